@@ -0,0 +1,87 @@
+#include "Benchmark.hpp"
+
+#include <ns3/log.h>
+
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+NS_LOG_COMPONENT_DEFINE ("Benchmark");
+
+#ifndef MONADCOUNT_SIM_REVISION
+#define MONADCOUNT_SIM_REVISION "unknown"
+#endif
+
+monadcount_sim::bench::Measurement monadcount_sim::bench::Measure(
+        const std::string &name, nlohmann::json params, double items, double minSeconds,
+        const std::function<double(uint64_t iterations)> &body) {
+    Measurement measurement;
+    measurement.name = name;
+    measurement.params = std::move(params);
+    measurement.items = items;
+    for (uint64_t iterations = 1;; iterations *= 2) {
+        double seconds = body(iterations);
+        if (seconds >= minSeconds || iterations >= (uint64_t{1} << 40)) {
+            measurement.iterations = iterations;
+            measurement.seconds = seconds;
+            break;
+        }
+    }
+    NS_LOG_INFO (name << " " << measurement.params.dump() << ": "
+                 << measurement.seconds / static_cast<double>(measurement.iterations) * 1e9 << " ns/iteration, "
+                 << measurement.items * static_cast<double>(measurement.iterations) / measurement.seconds
+                 << " items/s");
+    return measurement;
+}
+
+void monadcount_sim::bench::BenchmarkReport::Add(const Measurement &measurement) {
+    m_measurements.push_back(measurement);
+}
+
+void monadcount_sim::bench::BenchmarkReport::AddScaling(nlohmann::json run) {
+    m_scaling.push_back(std::move(run));
+}
+
+nlohmann::json monadcount_sim::bench::BenchmarkReport::ToJson() const {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    nlohmann::json report;
+    report["context"] = {
+            {"revision", MONADCOUNT_SIM_REVISION},
+            {"compiler", __VERSION__},
+#ifdef NDEBUG
+            {"build", "release"},
+#else
+            {"build", "debug"},
+#endif
+            {"date", date},
+            {"hardware_threads", std::thread::hardware_concurrency()},
+    };
+    report["benchmarks"] = nlohmann::json::array();
+    for (const Measurement &m : m_measurements) {
+        double iterations = static_cast<double>(m.iterations);
+        report["benchmarks"].push_back({
+                {"name", m.name},
+                {"params", m.params},
+                {"iterations", m.iterations},
+                {"ns_per_iteration", m.seconds / iterations * 1e9},
+                {"items_per_second", m.items * iterations / m.seconds},
+        });
+    }
+    report["scaling"] = m_scaling;
+    return report;
+}
+
+void monadcount_sim::bench::BenchmarkReport::Write(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Could not create benchmark report: " + path);
+    }
+    out << ToJson().dump(2) << '\n';
+    if (!out) {
+        throw std::runtime_error("Could not write benchmark report: " + path);
+    }
+}
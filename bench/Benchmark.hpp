@@ -0,0 +1,64 @@
+#ifndef MONADCOUNT_SIM_BENCHMARK_HPP
+#define MONADCOUNT_SIM_BENCHMARK_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace monadcount_sim::bench {
+    // One timed benchmark: `iterations` runs of the body took `seconds`, each handling `items` items
+    // (features, stations, updates...).
+    struct Measurement {
+        std::string name;
+        nlohmann::json params = nlohmann::json::object();
+        uint64_t iterations = 0;
+        double seconds = 0.0;
+        double items = 1.0;
+    };
+
+    // Runs the body with 1, 2, 4... iterations until one batch takes at least minSeconds, and keeps that
+    // batch. The body runs the given number of iterations and returns the seconds its timed part took, so
+    // it can leave set-up and tear-down (e.g. Simulator::Destroy) out.
+    Measurement Measure(const std::string &name, nlohmann::json params, double items, double minSeconds,
+                        const std::function<double(uint64_t iterations)> &body);
+
+    // Seconds since start, for bodies that time themselves.
+    inline double Elapsed(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Keeps the compiler from discarding a result that is otherwise unused.
+    template<typename T>
+    inline void DoNotOptimize(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Everything one monadcount_sim_bench invocation measured, as JSON:
+    //
+    //   {"context": {"revision", "compiler", "build", "date", "hardware_threads"},
+    //    "benchmarks": [{"name", "params", "iterations", "ns_per_iteration", "items_per_second"}, ...],
+    //    "scaling": [{"scenario", "pedestrians", "exit_code", "events", "simulate_seconds", "events_per_second",
+    //                 "sim_seconds_per_wall_second", "peak_rss_kb", ...}, ...]}
+    //
+    // Entries are keyed by name plus params, so two reports of different revisions can be joined on them.
+    class BenchmarkReport {
+    public:
+        void Add(const Measurement &measurement);
+        void AddScaling(nlohmann::json run);
+
+        // Throws std::runtime_error if the file cannot be written.
+        void Write(const std::string &path) const;
+
+        [[nodiscard]] nlohmann::json ToJson() const;
+
+    private:
+        std::vector<Measurement> m_measurements;
+        std::vector<nlohmann::json> m_scaling;
+    };
+}
+
+#endif //MONADCOUNT_SIM_BENCHMARK_HPP
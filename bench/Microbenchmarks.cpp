@@ -0,0 +1,300 @@
+#include "Suites.hpp"
+
+#include <monadcount_sim/core/EventProfiler.hpp>
+#include <monadcount_sim/core/GeoJsonParser.hpp>
+#include <monadcount_sim/core/ScenarioEnvironmentBuilder.hpp>
+#include <monadcount_sim/core/VisualizationManager.hpp>
+#include <monadcount_sim/wifi/HandoverEngine.hpp>
+
+#include <ns3/core-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/network-module.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+using namespace ns3;
+
+namespace {
+    using monadcount_sim::bench::Elapsed;
+    using monadcount_sim::bench::MicroOptions;
+    using Clock = std::chrono::steady_clock;
+
+    bool selected(const MicroOptions &options, const std::string &name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    // A building-like GeoJSON of `count` features: mostly wall outlines and seats, some rooms, APs,
+    // sniffers and terminals, laid out on a grid of 10 m cells.
+    std::string writeSyntheticGeoJson(const std::string &directory, uint32_t count) {
+        std::filesystem::create_directories(directory);
+        std::string path = directory + "/synthetic-" + std::to_string(count) + ".geo.json";
+        if (std::filesystem::exists(path)) {
+            return path;
+        }
+        std::ofstream out(path);
+        out << "{\"type\": \"FeatureCollection\", \"name\": \"synthetic\", \"features\": [\n";
+        std::mt19937 rng(count);
+        std::uniform_real_distribution<double> offset(0.5, 9.5);
+        for (uint32_t i = 0; i < count; ++i) {
+            double x = (i % 100) * 10.0;
+            double y = (i / 100) * 10.0;
+            const char *category = "wall";
+            switch (i % 20) {
+                case 0: category = "room"; break;
+                case 1: case 2: category = "access_point"; break;
+                case 3: category = "sniffer"; break;
+                case 4: case 5: category = "terminal"; break;
+                case 6: case 7: case 8: case 9: case 10: case 11: category = "seat"; break;
+                default: break;
+            }
+            bool polygon = i % 20 == 0 || i % 20 >= 12;
+            out << (i ? ",\n" : "") << "{\"type\": \"Feature\", \"properties\": {\"id\": \"f" << i
+                << "\", \"category\": \"" << category << "\", \"experiment_id\": \"bench\"}, \"geometry\": ";
+            if (polygon) {
+                out << "{\"type\": \"Polygon\", \"coordinates\": [[[" << x << ", " << y << "], [" << x + 10 << ", "
+                    << y << "], [" << x + 10 << ", " << y + 10 << "], [" << x << ", " << y + 10 << "], [" << x
+                    << ", " << y << "]]]}}";
+            } else {
+                out << "{\"type\": \"Point\", \"coordinates\": [" << x + offset(rng) << ", " << y + offset(rng)
+                    << "]}}";
+            }
+        }
+        out << "\n]}\n";
+        if (!out) {
+            throw std::runtime_error("Could not write synthetic GeoJSON: " + path);
+        }
+        return path;
+    }
+
+    NodeContainer placedNodes(uint32_t count, double size, uint32_t seed) {
+        NodeContainer nodes;
+        nodes.Create(count);
+        Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> coordinate(0.0, size);
+        for (uint32_t i = 0; i < count; ++i) {
+            positions->Add(Vector(coordinate(rng), coordinate(rng), 0.0));
+        }
+        MobilityHelper mobility;
+        mobility.SetPositionAllocator(positions);
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobility.Install(nodes);
+        return nodes;
+    }
+
+    void benchParser(monadcount_sim::bench::BenchmarkReport &report, const MicroOptions &options,
+                     const std::vector<std::pair<std::string, std::string>> &inputs) {
+        const std::string name = "GeoJSONParser::parseFile";
+        if (!selected(options, name)) {
+            return;
+        }
+        for (const auto &[label, path] : inputs) {
+            for (unsigned threads : {1u, 0u}) {
+                monadcount_sim::core::GeoJSONParser parser;
+                parser.setThreads(threads);
+                auto features = static_cast<double>(parser.parseFile(path).size());
+                report.Add(monadcount_sim::bench::Measure(
+                        name, {{"input", label}, {"threads", threads}}, features, options.minSeconds,
+                        [&](uint64_t iterations) {
+                            auto start = Clock::now();
+                            for (uint64_t i = 0; i < iterations; ++i) {
+                                monadcount_sim::bench::DoNotOptimize(parser.parseFile(path).size());
+                            }
+                            return Elapsed(start);
+                        }));
+            }
+        }
+    }
+
+    void benchBuilder(monadcount_sim::bench::BenchmarkReport &report, const MicroOptions &options,
+                      const std::vector<std::pair<std::string, std::string>> &inputs) {
+        const std::string name = "ScenarioEnvironmentBuilder::Build";
+        if (!selected(options, name)) {
+            return;
+        }
+        for (const auto &[label, path] : inputs) {
+            monadcount_sim::core::GeoJSONParser parser;
+            auto features = parser.parseFile(path);
+            for (bool batched : {false, true}) {
+                report.Add(monadcount_sim::bench::Measure(
+                        name, {{"input", label}, {"batched", batched}}, static_cast<double>(features.size()),
+                        options.minSeconds, [&](uint64_t iterations) {
+                            double seconds = 0.0;
+                            for (uint64_t i = 0; i < iterations; ++i) {
+                                monadcount_sim::core::ScenarioEnvironmentBuilder builder;
+                                builder.SetBatched(batched);
+                                auto start = Clock::now();
+                                auto env = builder.Build(features);
+                                seconds += Elapsed(start);
+                                env.reset();
+                                // Drops the created nodes from the global NodeList.
+                                Simulator::Destroy();
+                            }
+                            return seconds;
+                        }));
+            }
+        }
+    }
+
+    // The RSSI estimate behind every polling handover decision (HandoverExperiment's former EstimateRssi).
+    void benchRssiKernel(monadcount_sim::bench::BenchmarkReport &report, const MicroOptions &options) {
+        const std::string name = "HandoverEngine::ComputeRssi";
+        if (!selected(options, name)) {
+            return;
+        }
+        for (uint32_t stations : options.stationCounts) {
+            for (uint32_t aps : {4u, 64u}) {
+                std::size_t stride = (aps + monadcount_sim::wifi::HandoverEngine::kApLanes - 1)
+                                     / monadcount_sim::wifi::HandoverEngine::kApLanes
+                                     * monadcount_sim::wifi::HandoverEngine::kApLanes;
+                std::mt19937 rng(stations);
+                std::uniform_real_distribution<float> coordinate(0.0f, 100.0f);
+                std::vector<float> x(stations), y(stations), apX(stride, 1e6f), apY(stride, 1e6f);
+                for (uint32_t s = 0; s < stations; ++s) {
+                    x[s] = coordinate(rng);
+                    y[s] = coordinate(rng);
+                }
+                for (uint32_t a = 0; a < aps; ++a) {
+                    apX[a] = coordinate(rng);
+                    apY[a] = coordinate(rng);
+                }
+                std::vector<float> rssi(stations * stride);
+                report.Add(monadcount_sim::bench::Measure(
+                        name, {{"stations", stations}, {"aps", aps}}, static_cast<double>(stations) * aps,
+                        options.minSeconds, [&](uint64_t iterations) {
+                            auto start = Clock::now();
+                            for (uint64_t i = 0; i < iterations; ++i) {
+                                monadcount_sim::wifi::HandoverEngine::ComputeRssi(
+                                        x.data(), y.data(), stations, apX.data(), apY.data(), stride, 20.0f, 3.0f,
+                                        rssi.data());
+                                monadcount_sim::bench::DoNotOptimize(rssi[0]);
+                            }
+                            return Elapsed(start);
+                        }));
+            }
+        }
+    }
+
+    // One polling handover check over all stations: the work of HandoverExperiment::CheckRssiAndTriggerHandover.
+    // Stations stand still, so after the first tick this is the steady-state cost without handovers.
+    void benchHandoverTick(monadcount_sim::bench::BenchmarkReport &report, const MicroOptions &options) {
+        const std::string name = "HandoverEngine::Tick";
+        if (!selected(options, name)) {
+            return;
+        }
+        for (uint32_t stations : options.stationCounts) {
+            NodeContainer aps = placedNodes(4, 100.0, 1);
+            NodeContainer stas = placedNodes(stations, 100.0, stations);
+            monadcount_sim::wifi::HandoverEngine engine(20.0, 3.0, 5.0, Seconds(5.0));
+            engine.AddAps(aps);
+            engine.AddStations(stas);
+            report.Add(monadcount_sim::bench::Measure(
+                    name, {{"stations", stations}, {"aps", 4}}, stations, options.minSeconds,
+                    [&](uint64_t iterations) {
+                        auto start = Clock::now();
+                        for (uint64_t i = 0; i < iterations; ++i) {
+                            engine.Tick();
+                        }
+                        return Elapsed(start);
+                    }));
+            Simulator::Destroy();
+        }
+    }
+
+    // Association updates of every node, flushed once per instant as in a handover tick.
+    void benchVisualization(monadcount_sim::bench::BenchmarkReport &report, const MicroOptions &options) {
+        const std::string name = "VisualizationManager::OnNodeAssociated";
+        if (!selected(options, name)) {
+            return;
+        }
+        for (uint32_t stations : options.stationCounts) {
+            for (bool netanim : {false, true}) {
+                NodeContainer nodes = placedNodes(stations, 100.0, stations);
+                auto viz = std::make_unique<monadcount_sim::core::VisualizationManager>();
+                if (netanim) {
+                    // Position sampling far beyond the benchmark, so only colour changes are written.
+                    viz->EnableNetAnimPositions(options.workDirectory + "/viz-bench.xml", Seconds(1e9));
+                }
+                monadcount_sim::core::VisualizationManager::GroupVisualConfig config;
+                config.labelPrefix = "STA";
+                config.netanimColorFunc = [](uint32_t, int apId) {
+                    return std::make_tuple(uint8_t(apId * 60), uint8_t(255 - apId * 60), uint8_t(0));
+                };
+                config.netsimColorFunc = [](uint32_t, int) { return std::make_tuple(0.0, 1.0, 0.0); };
+                viz->RegisterGroup("stations", nodes, config);
+                viz->Initialize();
+
+                uint64_t round = 0;
+                report.Add(monadcount_sim::bench::Measure(
+                        name, {{"stations", stations}, {"output", netanim ? "netanim-positions" : "none"}},
+                        stations, options.minSeconds, [&](uint64_t iterations) {
+                            auto start = Clock::now();
+                            for (uint64_t i = 0; i < iterations; ++i, ++round) {
+                                for (uint32_t n = 0; n < nodes.GetN(); ++n) {
+                                    viz->OnNodeAssociated(nodes.Get(n)->GetId(), static_cast<int>((round + n) % 4));
+                                }
+                                // Runs the flush scheduled for this instant, then stops.
+                                Simulator::Stop(Seconds(0));
+                                Simulator::Run();
+                            }
+                            return Elapsed(start);
+                        }));
+                viz.reset();
+                Simulator::Destroy();
+            }
+        }
+    }
+
+    uint64_t dispatched = 0;
+
+    void countEvent() {
+        ++dispatched;
+    }
+
+    // Scheduling and running one near-empty event, with and without the event profiler: the difference is
+    // the profiler's cost per event, to be set against the events/s of the scaling runs.
+    void benchEventDispatch(monadcount_sim::bench::BenchmarkReport &report, const MicroOptions &options) {
+        const std::string name = "Simulator::Run";
+        if (!selected(options, name)) {
+            return;
+        }
+        auto &profiler = monadcount_sim::core::EventProfiler::Instance();
+        for (bool profiled : {false, true}) {
+            if (profiled) {
+                profiler.Enable();
+            }
+            report.Add(monadcount_sim::bench::Measure(
+                    name, {{"profile", profiled}}, 1.0, options.minSeconds, [&](uint64_t iterations) {
+                        auto start = Clock::now();
+                        for (uint64_t i = 0; i < iterations; ++i) {
+                            Simulator::Schedule(NanoSeconds(static_cast<int64_t>(i)), &countEvent);
+                        }
+                        Simulator::Run();
+                        double seconds = Elapsed(start);
+                        Simulator::Destroy();
+                        return seconds;
+                    }));
+        }
+        profiler.Disable();
+        monadcount_sim::bench::DoNotOptimize(dispatched);
+    }
+}
+
+void monadcount_sim::bench::RunMicrobenchmarks(BenchmarkReport &report, const MicroOptions &options) {
+    std::vector<std::pair<std::string, std::string>> inputs;
+    inputs.emplace_back("room.geo.json", options.geojsonDirectory + "/room.geo.json");
+    for (uint32_t count : options.featureCounts) {
+        inputs.emplace_back("synthetic-" + std::to_string(count),
+                            writeSyntheticGeoJson(options.workDirectory, count));
+    }
+
+    benchParser(report, options, inputs);
+    benchBuilder(report, options, inputs);
+    benchRssiKernel(report, options);
+    benchHandoverTick(report, options);
+    benchVisualization(report, options);
+    benchEventDispatch(report, options);
+}
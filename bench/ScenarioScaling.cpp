@@ -0,0 +1,76 @@
+#include "Suites.hpp"
+
+#include <monadcount_sim/core/SweepRunner.hpp>
+
+#include <ns3/log.h>
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+
+NS_LOG_COMPONENT_DEFINE("ScenarioScaling");
+
+void monadcount_sim::bench::RunScenarioScaling(BenchmarkReport &report, const ScalingOptions &options) {
+    std::vector<core::SweepRun> runs;
+    for (const std::string &scenario : options.scenarios) {
+        for (uint32_t pedestrians : options.pedestrians) {
+            for (bool profile : {false, true}) {
+                if (profile && !options.profileOverhead) {
+                    continue;
+                }
+                core::SweepRun run;
+                run.index = static_cast<uint32_t>(runs.size());
+                run.parameters = {{"scenario", scenario}, {"pedestrians", std::to_string(pedestrians)},
+                                  {"profile", profile ? "1" : "0"}};
+                runs.push_back(std::move(run));
+            }
+        }
+    }
+
+    // Outputs off, so the runs measure the simulation rather than the disk.
+    std::vector<std::string> arguments{"--capture=none", "--trajectory-period=0",
+                                       "--duration=" + std::to_string(options.duration)};
+    std::string directory = (std::filesystem::absolute(options.workDirectory) / "scaling").string();
+    core::SweepRunner runner(std::filesystem::absolute(options.executable).string(), arguments, directory, 1);
+
+    // simulate_seconds of the plain run of each point; the profiled run follows it.
+    std::map<std::pair<std::string, std::string>, double> plainSeconds;
+    for (const core::SweepResult &result : runner.Run(runs)) {
+        bool profiled = result.run.parameters[2].second == "1";
+        nlohmann::json entry = {
+                {"scenario", result.run.parameters[0].second},
+                {"pedestrians", std::stoul(result.run.parameters[1].second)},
+                {"profile", profiled},
+                {"exit_code", result.exitCode},
+                {"wall_seconds", result.wallSeconds},
+                {"peak_rss_kb", result.maxRssKb},
+        };
+        // Throughput over Simulator::Run alone: run_seconds also spans the topology set-up, which grows
+        // with the pedestrian count.
+        double events = 0.0;
+        double simulateSeconds = 0.0;
+        for (const auto &[name, value] : result.metrics) {
+            entry[name] = value;
+            if (name == "events") {
+                events = value;
+            } else if (name == "simulate_seconds") {
+                simulateSeconds = value;
+            }
+        }
+        if (simulateSeconds > 0.0) {
+            entry["events_per_second"] = events / simulateSeconds;
+            entry["sim_seconds_per_wall_second"] = options.duration / simulateSeconds;
+        }
+        auto point = std::make_pair(result.run.parameters[0].second, result.run.parameters[1].second);
+        if (!profiled) {
+            plainSeconds[point] = simulateSeconds;
+        } else if (plainSeconds[point] > 0.0 && simulateSeconds > 0.0) {
+            double overhead = simulateSeconds / plainSeconds[point] - 1.0;
+            entry["profile_overhead"] = overhead;
+            NS_LOG_INFO("--profile overhead, " << point.first << " at " << point.second << " pedestrians: "
+                        << overhead * 100.0 << " %");
+        }
+        report.AddScaling(std::move(entry));
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef MONADCOUNT_SIM_BENCH_SUITES_HPP
+#define MONADCOUNT_SIM_BENCH_SUITES_HPP
+
+#include "Benchmark.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace monadcount_sim::bench {
+    struct MicroOptions {
+        std::string filter;                  // only benchmarks whose name contains this (empty = all)
+        double minSeconds = 0.2;             // per measurement
+        std::string geojsonDirectory;        // holds room.geo.json
+        std::string workDirectory;           // synthetic inputs and scratch outputs
+        std::vector<uint32_t> featureCounts; // sizes of the synthetic GeoJSON files
+        std::vector<uint32_t> stationCounts; // N of the handover and visualization benchmarks
+    };
+
+    // Parser, builder, RSSI kernel, handover tick and visualization update benchmarks, in-process.
+    void RunMicrobenchmarks(BenchmarkReport &report, const MicroOptions &options);
+
+    struct ScalingOptions {
+        std::string executable;               // the monadcount-sim binary
+        std::string workDirectory;            // gets a sweep directory of one run per point
+        std::vector<std::string> scenarios;
+        std::vector<uint32_t> pedestrians;
+        double duration = 10.0;               // simulated seconds per run
+        bool profileOverhead = false;         // also run every point with --profile
+    };
+
+    // Every scenario at every pedestrian count, one process each and one at a time (SweepRunner), so
+    // each run's peak RSS and timing are its own. With profileOverhead, each point runs once more under
+    // --profile and that entry gets profile_overhead, its simulate_seconds relative to the plain run's.
+    void RunScenarioScaling(BenchmarkReport &report, const ScalingOptions &options);
+}
+
+#endif //MONADCOUNT_SIM_BENCH_SUITES_HPP
@@ -0,0 +1,118 @@
+// monadcount_sim_bench: microbenchmarks of the hot paths and scenario scaling runs, reported as JSON.
+#include "Suites.hpp"
+
+#include "ns3/core-module.h"
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("MonadcountSimBench");
+
+#ifndef MONADCOUNT_SIM_SOURCE_DIR
+#define MONADCOUNT_SIM_SOURCE_DIR "."
+#endif
+#ifndef MONADCOUNT_SIM_EXECUTABLE
+#define MONADCOUNT_SIM_EXECUTABLE "bin/monadcount-sim"
+#endif
+
+namespace {
+    std::vector<std::string> splitList(const std::string &text) {
+        std::vector<std::string> items;
+        std::size_t start = 0;
+        while (start <= text.size()) {
+            std::size_t end = text.find(',', start);
+            if (end == std::string::npos) {
+                end = text.size();
+            }
+            if (end > start) {
+                items.push_back(text.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+        return items;
+    }
+
+    std::vector<uint32_t> parseCounts(const std::string &text, const std::string &option) {
+        std::vector<uint32_t> counts;
+        for (const std::string &item : splitList(text)) {
+            std::size_t used = 0;
+            unsigned long value = 0;
+            try {
+                value = std::stoul(item, &used);
+            } catch (const std::exception &) {
+                used = 0;
+            }
+            if (used != item.size() || value == 0 || value > UINT32_MAX) {
+                throw std::invalid_argument("Invalid --" + option + " value '" + item + "' (positive integers)");
+            }
+            counts.push_back(static_cast<uint32_t>(value));
+        }
+        return counts;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    LogComponentEnable("MonadcountSimBench", LOG_LEVEL_INFO);
+    LogComponentEnable("Benchmark", LOG_LEVEL_INFO);
+    LogComponentEnable("SweepRunner", LOG_LEVEL_INFO);
+    LogComponentEnable("ScenarioScaling", LOG_LEVEL_INFO);
+
+    std::string output = "bench.json";
+    std::string workDir = "bench-work";
+    bool micro = true;
+    bool scaling = true;
+    monadcount_sim::bench::MicroOptions microOptions;
+    microOptions.geojsonDirectory = std::string(MONADCOUNT_SIM_SOURCE_DIR) + "/geojson";
+    std::string featureCounts = "1000,10000,100000";
+    std::string stationCounts = "10,100,1000,10000";
+    monadcount_sim::bench::ScalingOptions scalingOptions;
+    scalingOptions.executable = MONADCOUNT_SIM_EXECUTABLE;
+    std::string scenarios = "basic,doortodoor,handover,venue";
+    std::string pedestrians = "10,100,1000,10000";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("output", "JSON report to write", output);
+    cmd.AddValue("work-dir", "Directory for synthetic inputs, scratch files and the scaling runs", workDir);
+    cmd.AddValue("micro", "Run the microbenchmarks", micro);
+    cmd.AddValue("filter", "Only microbenchmarks whose name contains this, e.g. HandoverEngine", microOptions.filter);
+    cmd.AddValue("min-time", "Seconds each microbenchmark measurement runs for at least", microOptions.minSeconds);
+    cmd.AddValue("geojson-dir", "Directory holding room.geo.json", microOptions.geojsonDirectory);
+    cmd.AddValue("features", "Feature counts of the synthetic GeoJSON inputs", featureCounts);
+    cmd.AddValue("stations", "Station counts of the handover and visualization benchmarks", stationCounts);
+    cmd.AddValue("scaling", "Run every scenario at every pedestrian count", scaling);
+    cmd.AddValue("executable", "monadcount-sim binary of the scaling runs", scalingOptions.executable);
+    cmd.AddValue("scenarios", "Scenarios of the scaling runs", scenarios);
+    cmd.AddValue("pedestrians", "Pedestrian counts of the scaling runs", pedestrians);
+    cmd.AddValue("duration", "Simulated seconds of each scaling run", scalingOptions.duration);
+    cmd.AddValue("profile-overhead", "Run every scaling point again with --profile and report its overhead",
+                 scalingOptions.profileOverhead);
+    cmd.Parse(argc, argv);
+
+    try {
+        microOptions.workDirectory = workDir;
+        microOptions.featureCounts = parseCounts(featureCounts, "features");
+        microOptions.stationCounts = parseCounts(stationCounts, "stations");
+        scalingOptions.workDirectory = workDir;
+        scalingOptions.scenarios = splitList(scenarios);
+        scalingOptions.pedestrians = parseCounts(pedestrians, "pedestrians");
+        std::filesystem::create_directories(workDir);
+
+        monadcount_sim::bench::BenchmarkReport report;
+        if (micro) {
+            monadcount_sim::bench::RunMicrobenchmarks(report, microOptions);
+        }
+        if (scaling) {
+            monadcount_sim::bench::RunScenarioScaling(report, scalingOptions);
+        }
+        report.Write(output);
+        NS_LOG_INFO("Report written to " << output);
+    } catch (const std::exception &e) {
+        NS_LOG_ERROR(e.what());
+        return 1;
+    }
+    return 0;
+}
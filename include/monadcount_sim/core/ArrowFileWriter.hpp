@@ -0,0 +1,72 @@
+#ifndef MONADCOUNT_SIM_ARROWFILEWRITER_HPP
+#define MONADCOUNT_SIM_ARROWFILEWRITER_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace monadcount_sim::core {
+    // A fixed-width, non-nullable column of an Arrow file.
+    struct ArrowColumn {
+        enum class Type {
+            Int,             // byteWidth 1, 2, 4 or 8
+            Float,           // byteWidth 4 or 8
+            TimestampNs,     // int64 nanoseconds, no time zone
+            FixedSizeBinary  // byteWidth bytes per value, e.g. 6 for a MAC address
+        };
+
+        std::string name;
+        Type type = Type::Int;
+        uint32_t byteWidth = 8;
+        bool isSigned = true;  // Int only
+    };
+
+    // Writes an Arrow IPC file (a.k.a. Feather v2), readable by pyarrow, pandas.read_feather, polars, DuckDB, ...
+    //
+    // Only what columnar simulation output needs is supported: fixed-width columns without nulls, no
+    // dictionaries and no compression. Each WriteBatch call becomes one record batch whose body is the column
+    // buffers as given, so a batch costs one copy into the stream and no per-row work. The footer, which
+    // readers need to find the batches, is written by Close.
+    class ArrowFileWriter {
+    public:
+        // Writes the file header and schema; throws std::runtime_error if the file cannot be created and
+        // std::invalid_argument for an unsupported column.
+        ArrowFileWriter(const std::string &path, std::vector<ArrowColumn> columns);
+
+        ~ArrowFileWriter();
+
+        ArrowFileWriter(const ArrowFileWriter &) = delete;
+        ArrowFileWriter &operator=(const ArrowFileWriter &) = delete;
+
+        // Appends a record batch. columns[i] points to rows * byteWidth little-endian bytes of column i.
+        void WriteBatch(uint64_t rows, const void *const *columns);
+
+        // Writes the footer and closes the file; false if any write failed. Called by the destructor.
+        bool Close();
+
+        [[nodiscard]] uint64_t GetRows() const { return m_rows; }
+        [[nodiscard]] uint64_t GetBatches() const { return m_batches.size(); }
+        [[nodiscard]] uint64_t GetBytes() const { return m_offset; }
+
+    private:
+        struct Block {
+            int64_t offset;
+            int32_t metadataLength;
+            int64_t bodyLength;
+        };
+
+        void WriteMessage(const std::vector<uint8_t> &metadata);
+        void Write(const void *data, std::size_t size);
+
+        std::vector<ArrowColumn> m_columns;
+        std::ofstream m_out;
+        uint64_t m_offset = 0;
+        uint64_t m_rows = 0;
+        std::vector<Block> m_batches;
+        bool m_closed = false;
+        bool m_failed = false;
+    };
+}
+
+#endif //MONADCOUNT_SIM_ARROWFILEWRITER_HPP
@@ -0,0 +1,49 @@
+#ifndef MONADCOUNT_SIM_CAPTUREOPTIONS_HPP
+#define MONADCOUNT_SIM_CAPTUREOPTIONS_HPP
+
+#include <cstdint>
+
+#include <monadcount_sim/core/CaptureWriter.hpp>
+#include <monadcount_sim/core/EventLog.hpp>
+
+namespace monadcount_sim::core {
+    // How experiments record the frames of their Wi-Fi devices.
+    struct CaptureOptions {
+        enum class Format {
+            // One pcapng file per experiment, written by a background thread (wifi::WifiCaptureSink).
+            Pcapng,
+            // One pcap file per device via ns-3's EnablePcap, written synchronously.
+            PcapPerDevice,
+            None
+        };
+
+        Format format = Format::Pcapng;
+
+        // Compression of the pcapng stream; the file name gets CaptureCompressionSuffix() appended.
+        CaptureCompression compression = IsCaptureCompressionAvailable(CaptureCompression::Zstd)
+                                         ? CaptureCompression::Zstd : CaptureCompression::None;
+
+        // 802.11 frames kept by the capture taps: bit 16 * type + subtype of the frame control field
+        // (see wifi::WifiCaptureFilter). Everything else is dropped before it is copied.
+        uint64_t frameTypes = ~uint64_t{0};
+
+        // Bytes kept per frame, radiotap header included; e.g. 128 keeps the management headers and
+        // the first information elements.
+        uint32_t snapLength = 65535;
+
+        // Seconds between ground-truth position samples of every pedestrian in data/<scenario>/trajectories.traj
+        // (core::TrajectoryRecorder; course changes are recorded in between). 0 disables the recording.
+        double trajectoryPeriod = 1.0;
+
+        // Outputs of the experiments' structured event log (handovers, deliveries, ...; core::EventLog), written
+        // to data/<scenario>/events.log / events.bin. Nothing by default.
+        EventLogOptions eventLog;
+
+        // Seconds between node position samples of a position-only data/<scenario>/netanim.xml (colour changes
+        // are written as they happen; core::VisualizationManager::EnableNetAnimPositions). 0 keeps ns-3's
+        // AnimationInterface with packet animation, in WITH_NETANIM builds.
+        double netanimInterval = 0.0;
+    };
+}
+
+#endif //MONADCOUNT_SIM_CAPTUREOPTIONS_HPP
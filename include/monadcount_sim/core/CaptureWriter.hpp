@@ -0,0 +1,103 @@
+#ifndef MONADCOUNT_SIM_CAPTUREWRITER_HPP
+#define MONADCOUNT_SIM_CAPTUREWRITER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace monadcount_sim::core {
+    // Compression of a capture stream. Each written block becomes one independent frame, so the file is
+    // a plain concatenation that zstd/lz4 (and Wireshark) decode as a whole.
+    enum class CaptureCompression {
+        None,
+        Zstd,
+        Lz4
+    };
+
+    // Parses "none", "zstd" or "lz4"; throws std::invalid_argument otherwise.
+    CaptureCompression ParseCaptureCompression(const std::string &name);
+
+    // Whether this build was linked against the library for the given compression.
+    bool IsCaptureCompressionAvailable(CaptureCompression compression);
+
+    // File name suffix of a compressed stream: ".zst", ".lz4" or "".
+    const char *CaptureCompressionSuffix(CaptureCompression compression);
+
+    struct CaptureWriterStats {
+        uint64_t frames = 0;
+        uint64_t capturedBytes = 0;  // pcapng bytes produced
+        uint64_t writtenBytes = 0;   // bytes that reached the file, after compression
+        uint64_t blocks = 0;         // blocks handed to the I/O thread
+        uint64_t stalls = 0;         // times the simulator thread waited for a free block
+    };
+
+    // Single pcapng file shared by any number of interfaces (one per captured device).
+    //
+    // Frames are appended as Enhanced Packet Blocks into a large in-memory block. Full blocks are handed to a
+    // background thread that compresses and writes them, so the caller only ever copies bytes; it waits only
+    // when maxQueuedBlocks blocks are already pending, which bounds memory if the disk cannot keep up.
+    // Not thread-safe on the producer side: AddInterface and AppendPacket must come from one thread.
+    class CaptureWriter {
+    public:
+        // Throws std::runtime_error if the file cannot be created or the compression is not available.
+        CaptureWriter(const std::string &path, CaptureCompression compression, std::size_t blockBytes = 4u << 20,
+                      std::size_t maxQueuedBlocks = 8);
+
+        ~CaptureWriter();
+
+        CaptureWriter(const CaptureWriter &) = delete;
+        CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+        // Declares an interface (pcapng Interface Description Block) with nanosecond timestamps; returns its id.
+        uint32_t AddInterface(uint16_t linkType, uint32_t snapLength, const std::string &name);
+
+        // Appends a frame and returns where its capturedLength bytes go; valid until the next call.
+        uint8_t *AppendPacket(uint32_t interfaceId, uint64_t timestampNs, uint32_t capturedLength,
+                              uint32_t originalLength);
+
+        // Flushes everything and closes the file; false if any write failed. Called by the destructor.
+        bool Close();
+
+        [[nodiscard]] CaptureWriterStats GetStats() const;
+
+    private:
+        struct Block {
+            std::unique_ptr<uint8_t[]> data;
+            std::size_t capacity = 0;
+            std::size_t size = 0;
+        };
+
+        uint8_t *Reserve(std::size_t bytes);
+        void Submit();
+        void WriterLoop();
+        bool WriteAll(const uint8_t *data, std::size_t size);
+
+        int m_fd;
+        CaptureCompression m_compression;
+        std::size_t m_blockBytes;
+        std::size_t m_maxQueuedBlocks;
+        bool m_closed = false;
+        uint32_t m_interfaces = 0;
+
+        Block m_current;
+        std::vector<Block> m_free;  // recycled blocks, so steady state allocates nothing
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_pending;  // signals the writer thread
+        std::condition_variable m_drained;  // signals the producer
+        std::deque<Block> m_queue;
+        bool m_stopping = false;
+        bool m_failed = false;
+        CaptureWriterStats m_stats;
+
+        std::thread m_writer;
+    };
+}
+
+#endif //MONADCOUNT_SIM_CAPTUREWRITER_HPP
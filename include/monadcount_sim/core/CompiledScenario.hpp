@@ -0,0 +1,155 @@
+#ifndef MONADCOUNT_SIM_COMPILEDSCENARIO_HPP
+#define MONADCOUNT_SIM_COMPILEDSCENARIO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <monadcount_sim/core/MappedFile.hpp>
+#include <monadcount_sim/models/Feature.hpp>
+#include <monadcount_sim/models/FeatureStore.hpp>
+
+namespace monadcount_sim::core {
+    // On-disk layout of a compiled scenario. Native endianness, every section 8-byte aligned, so the
+    // file can be memory-mapped and read in place.
+    namespace compiled {
+        constexpr char kMagic[8] = {'M', 'C', 'S', 'C', 'E', 'N', 'E', '\0'};
+        constexpr uint32_t kVersion = 2;
+
+        enum GeometryKind : uint8_t {
+            POINT = 0,
+            POLYGON = 1
+        };
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t headerSize;
+            uint64_t sourceHash;   // HashFileContents() of the GeoJSON this was compiled from
+            uint64_t sourceSize;
+            uint64_t featureCount;
+            uint64_t ringCount;
+            uint64_t pointCount;
+            uint64_t stringBytes;
+            uint64_t featuresOffset;
+            uint64_t ringsOffset;
+            uint64_t pointsOffset;
+            uint64_t stringsOffset;
+        };
+
+        // Strings are interned: repeated values (experiment ids in particular) are stored once.
+        struct FeatureRecord {
+            uint32_t idOffset;
+            uint32_t idLength;
+            uint32_t experimentIdOffset;
+            uint32_t experimentIdLength;
+            uint8_t category;      // models::Category::Type
+            uint8_t geometryKind;  // GeometryKind
+            uint16_t reserved;
+            uint32_t firstRing;    // a Point is stored as one ring holding one point
+            uint32_t ringCount;
+            uint32_t reserved2;
+        };
+
+        // Rings and points share their layout with models::FeatureStore, so mapped sections are handed
+        // out as views without copying.
+        using RingRecord = models::RingSpan;
+        using PointRecord = models::Point;
+
+        static_assert(sizeof(RingRecord) == 8 && sizeof(PointRecord) == 16, "compiled layout changed");
+    }
+
+    // Fast non-cryptographic 64-bit hash, used for cache keys.
+    uint64_t HashBytes(std::string_view bytes);
+
+    // HashBytes() of a file's contents, used as the compiled-scenario cache key.
+    uint64_t HashFileContents(const std::string &filePath, uint64_t *fileSize = nullptr);
+
+    // Accumulates features and writes them out in the compiled layout.
+    class CompiledScenarioWriter {
+    public:
+        void Add(const models::Feature &feature);
+
+        void Add(const models::FeatureRef &feature);
+
+        // Writes to a temporary file next to path and renames it, so concurrent runs never see a partial file.
+        void Write(const std::string &path, uint64_t sourceHash, uint64_t sourceSize) const;
+
+    private:
+        struct StringHash {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view value) const { return std::hash<std::string_view>{}(value); }
+        };
+
+        std::vector<compiled::FeatureRecord> m_features;
+        std::vector<compiled::RingRecord> m_rings;
+        std::vector<compiled::PointRecord> m_points;
+        std::string m_strings;
+        std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> m_interned;
+
+        uint32_t Intern(std::string_view value);
+
+        compiled::FeatureRecord MakeRecord(std::string_view id, std::string_view experimentId, models::Category category);
+    };
+
+    // Read-only, memory-mapped view of a compiled scenario.
+    class CompiledScenario {
+    public:
+        // Maps path and validates it against the expected source hash; returns nullptr if the file is
+        // missing, stale, from another format version, truncated or holds out-of-range records.
+        static std::unique_ptr<CompiledScenario> Open(const std::string &path, uint64_t expectedHash);
+
+        // Cache file location for a source file with the given content hash.
+        static std::string CachePath(const std::string &cacheDirectory, const std::string &sourcePath, uint64_t hash);
+
+        CompiledScenario(const CompiledScenario &) = delete;
+        CompiledScenario &operator=(const CompiledScenario &) = delete;
+
+        [[nodiscard]] std::size_t GetFeatureCount() const { return m_header->featureCount; }
+
+        [[nodiscard]] const compiled::FeatureRecord &GetFeature(std::size_t index) const { return m_features[index]; }
+
+        [[nodiscard]] const compiled::RingRecord &GetRing(std::size_t index) const { return m_rings[index]; }
+
+        [[nodiscard]] const compiled::PointRecord &GetPoint(std::size_t index) const { return m_points[index]; }
+
+        [[nodiscard]] std::string_view GetString(uint32_t offset, uint32_t length) const {
+            return {m_strings + offset, length};
+        }
+
+        // View of one feature pointing into the mapping; valid for the lifetime of this object.
+        [[nodiscard]] models::FeatureRef GetFeatureRef(std::size_t index) const {
+            const compiled::FeatureRecord &record = m_features[index];
+            models::FeatureRef ref;
+            ref.id = GetString(record.idOffset, record.idLength);
+            ref.experimentId = GetString(record.experimentIdOffset, record.experimentIdLength);
+            ref.category = models::Category(static_cast<models::Category::Type>(record.category));
+            if (record.geometryKind == compiled::POINT) {
+                const compiled::PointRecord &pt = m_points[m_rings[record.firstRing].offset];
+                ref.geometry = models::PointView{pt.x, pt.y};
+            } else if (record.geometryKind == compiled::POLYGON) {
+                ref.geometry = models::PolygonView{{m_rings + record.firstRing, record.ringCount}, m_points};
+            }
+            return ref;
+        }
+
+    private:
+        CompiledScenario() = default;
+
+        std::unique_ptr<MappedFile> m_file;
+
+        const compiled::Header *m_header = nullptr;
+        const compiled::FeatureRecord *m_features = nullptr;
+        const compiled::RingRecord *m_rings = nullptr;
+        const compiled::PointRecord *m_points = nullptr;
+        const char *m_strings = nullptr;
+    };
+}
+
+#endif //MONADCOUNT_SIM_COMPILEDSCENARIO_HPP
@@ -0,0 +1,165 @@
+#ifndef MONADCOUNT_SIM_EVENTLOG_HPP
+#define MONADCOUNT_SIM_EVENTLOG_HPP
+
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <ns3/simulator.h>
+
+namespace monadcount_sim::core {
+    // Where an EventLog writes; with none enabled Post() returns immediately.
+    struct EventLogOptions {
+        bool console = false;  // NS_LOG-style lines on stderr
+        bool text = false;     // the same lines in <base path>.log
+        bool binary = false;   // raw records plus the event definitions in <base path>.bin
+    };
+
+    // Parses a comma-separated list of "console", "text", "binary" or just "none"; throws std::invalid_argument.
+    EventLogOptions ParseEventLogOptions(const std::string &names);
+
+    // One logged event as it travels through the queue and is stored in the binary file.
+    struct EventRecord {
+        enum ArgType : uint8_t {
+            UInt = 0,
+            Int = 1,
+            Double = 2
+        };
+
+        static constexpr uint32_t kMaxArgs = 4;
+
+        int64_t timeNs;
+        uint32_t code;
+        uint8_t argCount;
+        uint8_t argTypes;  // 2 bits per argument, ArgType
+        uint16_t reserved;
+        uint64_t args[kMaxArgs];  // integers as two's complement, doubles as their bit pattern
+    };
+
+    struct EventLogStats {
+        uint64_t events = 0;
+        uint64_t bytes = 0;   // written to files
+        uint64_t stalls = 0;  // times the simulation thread waited for queue space
+    };
+
+    // Structured event log that keeps formatting and I/O off the simulation thread.
+    //
+    // Event kinds are interned once, at setup, as a code with a name and a format whose "{}" placeholders take
+    // the arguments in order. Post() then stores the simulation time, the code and up to four numbers into a
+    // fixed-size record of a single-producer/single-consumer ring: no allocation, no formatting, no lock. A
+    // background thread drains the ring in batches and writes text lines and/or the raw records (the
+    // definitions are written ahead of their first use, so the binary file is self-describing).
+    //
+    // Not for NetSimulyzer's LogStream, which stamps messages with Simulator::Now() and must be written
+    // from the simulation thread.
+    class EventLog {
+    public:
+        // Opens the enabled outputs (basePath + ".log" / ".bin"); throws std::runtime_error if a file cannot be
+        // created. capacity is rounded up to a power of two.
+        EventLog(const EventLogOptions &options, const std::string &basePath, std::size_t capacity = 1u << 16);
+
+        ~EventLog();
+
+        EventLog(const EventLog &) = delete;
+        EventLog &operator=(const EventLog &) = delete;
+
+        // E.g. Intern("handover", "node {} from AP {} to AP {}"). Codes start at 0.
+        uint32_t Intern(const std::string &name, const std::string &format);
+
+        [[nodiscard]] bool IsEnabled() const { return m_enabled; }
+
+        // Logs an event at the current simulation time; arguments must be numbers. Simulation thread only.
+        template<typename... Args>
+        void Post(uint32_t code, Args... args) {
+            static_assert(sizeof...(Args) <= EventRecord::kMaxArgs, "at most four event arguments");
+            static_assert((std::is_arithmetic_v<Args> && ...), "event arguments must be numbers");
+            if (!m_enabled) {
+                return;
+            }
+            if (m_head - m_cachedConsumed > m_mask) {
+                WaitForSpace();
+            }
+            EventRecord &record = m_ring[m_head & m_mask];
+            record.timeNs = ns3::Simulator::Now().GetNanoSeconds();
+            record.code = code;
+            record.argCount = sizeof...(Args);
+            record.argTypes = 0;
+            uint32_t index = 0;
+            (Store(record, index++, args), ...);
+            ++m_head;
+            m_published.store(m_head, std::memory_order_release);
+            if (m_head % kWakeEvery == 0) {
+                Wake();
+            }
+        }
+
+        // Writes what is queued and closes the outputs; false if a write failed. Called by the destructor.
+        bool Close();
+
+        [[nodiscard]] EventLogStats GetStats() const;
+
+    private:
+        static constexpr uint64_t kWakeEvery = 1024;
+
+        struct Definition {
+            std::string name;
+            std::string format;
+        };
+
+        template<typename T>
+        static void Store(EventRecord &record, uint32_t index, T value) {
+            uint8_t type;
+            if constexpr (std::is_floating_point_v<T>) {
+                record.args[index] = std::bit_cast<uint64_t>(static_cast<double>(value));
+                type = EventRecord::Double;
+            } else if constexpr (std::is_signed_v<T>) {
+                record.args[index] = static_cast<uint64_t>(static_cast<int64_t>(value));
+                type = EventRecord::Int;
+            } else {
+                record.args[index] = static_cast<uint64_t>(value);
+                type = EventRecord::UInt;
+            }
+            record.argTypes = static_cast<uint8_t>(record.argTypes | (type << (2 * index)));
+        }
+
+        void WaitForSpace();
+        void Wake();
+        void WriterLoop();
+
+        bool m_enabled;
+        bool m_console;
+        int m_textFd = -1;
+        int m_binaryFd = -1;
+
+        std::unique_ptr<EventRecord[]> m_ring;
+        uint64_t m_mask;
+
+        // Producer state; m_cachedConsumed is the last m_consumed it has seen.
+        uint64_t m_head = 0;
+        uint64_t m_cachedConsumed = 0;
+
+        alignas(64) std::atomic<uint64_t> m_published{0};
+        alignas(64) std::atomic<uint64_t> m_consumed{0};
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_pending;  // signals the writer thread
+        std::condition_variable m_space;    // signals the producer
+        std::vector<Definition> m_definitions;
+        bool m_stopping = false;
+        bool m_closed = false;
+        bool m_failed = false;
+        EventLogStats m_stats;
+
+        std::thread m_writer;
+    };
+}
+
+#endif //MONADCOUNT_SIM_EVENTLOG_HPP
@@ -0,0 +1,120 @@
+#ifndef MONADCOUNT_SIM_EVENTPROFILER_HPP
+#define MONADCOUNT_SIM_EVENTPROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace monadcount_sim::core {
+    // Simulator events of one callback type: all scheduled ones, the sampled ones (wrapped for timing) and,
+    // of those, the ones that ran and their wall time.
+    struct EventProfile {
+        const std::type_info *type = nullptr;
+        uint64_t scheduled = 0;
+        uint64_t sampled = 0;
+        uint64_t timed = 0;
+        uint64_t ticks = 0;
+    };
+
+    // One row of the report, slowest first.
+    struct EventProfileEntry {
+        std::string group;     // owning class (ns-3 TypeId name for ns-3 objects), or the scheduling function
+        std::string callback;  // the scheduled callable: member function type, lambda, function type
+        uint64_t scheduled = 0;
+        uint64_t events = 0;   // estimated number that ran: scheduled, less the cancelled share of the sample
+        double seconds = 0.0;
+    };
+
+    // Opt-in profiler of the simulator's event loop.
+    //
+    // Enable() makes ns-3 create a DefaultSimulatorImpl subclass that sees every scheduled event, so the
+    // wall time of events is attributed to the type of their callable. The type is known from the
+    // EventImpl MakeEvent built: for member functions it names the class and signature (e.g.
+    // void (ns3::Txop::*)() under ns3::Txop, which for ns-3 objects is their TypeId name), for lambdas the
+    // function they were written in, so lambda call sites are told apart, while member functions of one
+    // class with the same signature share a row. Time between events (queue, scheduling) is reported as
+    // such.
+    //
+    // Sampling is decided when an event is scheduled: every event is counted by type, and only about one
+    // in SetSamplePeriod() (and the first of each type), at random gaps so periodic event patterns cannot
+    // alias, is wrapped to be timed; the others go to the scheduler as they are. A row's time is its timed
+    // ticks scaled by scheduled / sampled, which also discounts the events cancelled or left in the queue
+    // at the same rate as in the sample. The cost of an unsampled event is one table lookup and a
+    // countdown; monadcount_sim_bench measures it per event ("Simulator::Run" with and without profile)
+    // and per scenario run (--profile-overhead). Names are only demangled for the report. Process-wide,
+    // like the simulator.
+    class EventProfiler {
+    public:
+        static EventProfiler &Instance();
+
+        // Selects the profiling simulator implementation, or the default one again. Either takes effect
+        // when the next simulator is created: before the first Simulator call or after Destroy().
+        void Enable();
+
+        void Disable();
+
+        // Mean number of events per timed event (1 = time every event, exact but slower).
+        void SetSamplePeriod(uint32_t period);
+
+        [[nodiscard]] uint32_t GetSamplePeriod() const { return m_samplePeriod; }
+
+        [[nodiscard]] bool IsEnabled() const { return m_enabled; }
+
+        // Aggregated rows, slowest first, and the run totals.
+        [[nodiscard]] std::vector<EventProfileEntry> GetEntries() const;
+        [[nodiscard]] double GetRunSeconds() const;
+        [[nodiscard]] uint64_t GetScheduledCount() const;
+        [[nodiscard]] uint64_t GetEventCount() const;  // estimated events run
+
+        // Top-n table: share of the run, total, count and mean per event of each row.
+        void WriteReport(std::ostream &out, std::size_t topN) const;
+
+        // Collapsed stacks for flamegraph.pl / speedscope: "ns-3;<group>;<callback> <microseconds>" per row.
+        void WriteCollapsed(std::ostream &out) const;
+
+        // Used by the simulator implementation.
+        EventProfile *Lookup(const std::type_info &type);
+        void AddRunTicks(uint64_t ticks) { m_runTicks += ticks; }
+
+        // Whether to time the event of this profile being scheduled.
+        [[nodiscard]] bool TimeNext(const EventProfile &profile) {
+            if (--m_countdown != 0) {
+                return profile.sampled == 0;
+            }
+            // xorshift32: gaps uniform in [1, 2 * period - 1], mean period.
+            m_random ^= m_random << 13;
+            m_random ^= m_random >> 17;
+            m_random ^= m_random << 5;
+            m_countdown = 1 + m_random % (2 * m_samplePeriod - 1);
+            return true;
+        }
+
+        static uint64_t Ticks();
+
+    private:
+        EventProfiler() = default;
+
+        [[nodiscard]] double SecondsPerTick() const;
+
+        bool m_enabled = false;
+        uint64_t m_runTicks = 0;
+
+        uint32_t m_samplePeriod = 16;
+        uint32_t m_countdown = 1;
+        uint32_t m_random = 2463534242u;
+
+        // Open-addressed table keyed by type_info address; profiles live in a deque so pointers stay valid.
+        std::vector<EventProfile *> m_table = std::vector<EventProfile *>(1024, nullptr);
+        std::deque<EventProfile> m_profiles;
+
+        // Cycle counter calibration, from Enable() to the report.
+        uint64_t m_calibrationTicks = 0;
+        uint64_t m_calibrationNs = 0;
+    };
+}
+
+#endif //MONADCOUNT_SIM_EVENTPROFILER_HPP
@@ -0,0 +1,54 @@
+#ifndef MONADCOUNT_SIM_EXPERIMENTINDEX_HPP
+#define MONADCOUNT_SIM_EXPERIMENTINDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace monadcount_sim::core {
+    // Byte range [begin, end) of one element of a FeatureCollection's "features" array.
+    struct ByteRange {
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Maps properties.experiment_id to the byte ranges of that experiment's features in a GeoJSON file, so
+    // one experiment can be loaded from a shared export without parsing the others.
+    class ExperimentIndex {
+    public:
+        // Scans a whole GeoJSON document once; throws if it is not a FeatureCollection.
+        static ExperimentIndex Build(std::string_view document, uint64_t sourceHash);
+
+        // Loads a saved index; returns nothing if it is missing, damaged or was built from other content.
+        static std::optional<ExperimentIndex> Load(const std::string &path, uint64_t expectedHash);
+
+        // Writes to a temporary file next to path and renames it, like the compiled scenario cache.
+        void Save(const std::string &path) const;
+
+        // Index file location for a source file with the given content hash.
+        static std::string IndexPath(const std::string &cacheDirectory, const std::string &sourcePath, uint64_t hash);
+
+        // Ranges in document order, or nullptr if no feature carries this experiment id.
+        [[nodiscard]] const std::vector<ByteRange> *Find(std::string_view experimentId) const;
+
+        [[nodiscard]] std::vector<std::string> GetExperimentIds() const;
+
+        [[nodiscard]] std::size_t GetFeatureCount() const { return m_featureCount; }
+
+        // Features without a string experiment_id; they cannot be selected and are skipped.
+        [[nodiscard]] std::size_t GetUnindexedCount() const { return m_unindexedCount; }
+
+    private:
+        uint64_t m_sourceHash = 0;
+        std::size_t m_featureCount = 0;
+        std::size_t m_unindexedCount = 0;
+        std::map<std::string, std::vector<ByteRange>, std::less<>> m_ranges;
+    };
+}
+
+#endif //MONADCOUNT_SIM_EXPERIMENTINDEX_HPP
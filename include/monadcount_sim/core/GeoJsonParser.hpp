@@ -6,17 +6,55 @@
 #define MONADCOUNT_SIM_GEOJSONPARSER_HPP
 
 
+#include <cstddef>
+#include <functional>
+#include <span>
 #include <string>
 #include <vector>
 #include <memory>
 
+#include <monadcount_sim/core/ExperimentIndex.hpp>
 #include <monadcount_sim/models/Feature.hpp>
+#include <monadcount_sim/models/FeatureStore.hpp>
 
 namespace monadcount_sim::core {
+    // Statistics of the most recent parse, used to compare the DOM and streaming paths.
+    struct ParseReport {
+        std::size_t featureCount = 0;
+        std::size_t errorCount = 0;
+        double elapsedSeconds = 0.0;
+        long peakRssKb = 0;
+    };
+
     class GeoJSONParser {
     public:
+        using FeatureSink = std::function<void(std::unique_ptr<monadcount_sim::models::Feature>)>;
+
+        // Number of threads parseFile uses to decode features once the document is tokenized; 0 means one
+        // per hardware thread. Output order and error reporting do not depend on it.
+        void setThreads(unsigned count) { threads = count; }
+
         // Parse a GeoJSON file and return a vector of Feature pointers.
         std::vector<std::unique_ptr<monadcount_sim::models::Feature>> parseFile(const std::string &filePath);
+
+        // Parse only the given feature byte ranges of a GeoJSON file (see ExperimentIndex); cost is proportional
+        // to the bytes covered by the ranges, not to the size of the file.
+        std::vector<std::unique_ptr<monadcount_sim::models::Feature>> parseRanges(const std::string &filePath,
+                                                                                 std::span<const ByteRange> ranges);
+
+        // Parse a GeoJSON file through the SAX interface and hand every Feature to the sink as soon as
+        // it is complete. The JSON document is never materialised, so memory stays bounded by one feature.
+        void parseStream(const std::string &filePath, const FeatureSink &sink);
+
+        // Parse a GeoJSON file through the SAX interface directly into an arena, without creating a Feature,
+        // Geometry or ring vector per feature.
+        void parseToStore(const std::string &filePath, monadcount_sim::models::FeatureStore &store);
+
+        [[nodiscard]] const ParseReport &lastReport() const { return report; }
+
+    private:
+        ParseReport report;
+        unsigned threads = 1;
     };
 }
 
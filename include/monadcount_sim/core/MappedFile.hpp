@@ -0,0 +1,35 @@
+#ifndef MONADCOUNT_SIM_MAPPEDFILE_HPP
+#define MONADCOUNT_SIM_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace monadcount_sim::core {
+    // Read-only memory mapping of a whole file, unmapped on destruction.
+    class MappedFile {
+    public:
+        // Returns nullptr if the file is missing, empty or cannot be mapped.
+        static std::unique_ptr<MappedFile> Open(const std::string &path);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        [[nodiscard]] const char *GetData() const { return static_cast<const char *>(m_data); }
+
+        [[nodiscard]] std::size_t GetSize() const { return m_size; }
+
+        [[nodiscard]] std::string_view GetView() const { return {GetData(), m_size}; }
+
+    private:
+        MappedFile(void *data, std::size_t size) : m_data(data), m_size(size) {}
+
+        void *m_data;
+        std::size_t m_size;
+    };
+}
+
+#endif //MONADCOUNT_SIM_MAPPEDFILE_HPP
@@ -0,0 +1,49 @@
+#ifndef MONADCOUNT_SIM_NETANIMPOSITIONWRITER_HPP
+#define MONADCOUNT_SIM_NETANIMPOSITIONWRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace monadcount_sim::core {
+    // NetAnim trace (netanim-3.108 XML) holding nothing but nodes, their positions, descriptions and colours.
+    //
+    // Unlike ns-3's AnimationInterface it hooks no packet or mobility traces: the caller decides what is
+    // written and when (see VisualizationManager::EnableNetAnimPositions). Elements are formatted into a
+    // buffer that goes to the file in chunks of chunkBytes, so a long run costs a few hundred writes.
+    class NetAnimPositionWriter {
+    public:
+        // Writes the <anim> header; throws std::runtime_error if the file cannot be created.
+        explicit NetAnimPositionWriter(const std::string &path, std::size_t chunkBytes = 1u << 20);
+
+        ~NetAnimPositionWriter();
+
+        NetAnimPositionWriter(const NetAnimPositionWriter &) = delete;
+        NetAnimPositionWriter &operator=(const NetAnimPositionWriter &) = delete;
+
+        // Declares a node with its initial position; all nodes come before the first update.
+        void AddNode(uint32_t nodeId, double x, double y);
+
+        void UpdatePosition(double timeSeconds, uint32_t nodeId, double x, double y);
+        void UpdateColor(double timeSeconds, uint32_t nodeId, uint8_t r, uint8_t g, uint8_t b);
+        void UpdateDescription(double timeSeconds, uint32_t nodeId, const std::string &description);
+
+        // Closes the <anim> element and the file; false if a write failed. Called by the destructor.
+        bool Close();
+
+        // Bytes formatted so far, written or still buffered.
+        [[nodiscard]] uint64_t GetBytes() const { return m_bytes + m_buffer.size(); }
+
+    private:
+        void BeginUpdate(char property, double timeSeconds, uint32_t nodeId);
+        void EndElement();
+
+        int m_fd;
+        std::size_t m_chunkBytes;
+        std::string m_buffer;
+        uint64_t m_bytes = 0;
+        bool m_failed = false;
+    };
+}
+
+#endif //MONADCOUNT_SIM_NETANIMPOSITIONWRITER_HPP
@@ -0,0 +1,13 @@
+#ifndef MONADCOUNT_SIM_RESOURCEUSAGE_HPP
+#define MONADCOUNT_SIM_RESOURCEUSAGE_HPP
+
+namespace monadcount_sim::core {
+    // Peak resident set size of the current process in KiB (0 if unavailable).
+    long PeakRssKb();
+
+    // Memory of the current process that no other process shares, e.g. pages a forked child has written to,
+    // in KiB (Linux only; 0 if unavailable).
+    long PrivateMemoryKb();
+}
+
+#endif //MONADCOUNT_SIM_RESOURCEUSAGE_HPP
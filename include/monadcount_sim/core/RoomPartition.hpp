@@ -0,0 +1,30 @@
+#ifndef MONADCOUNT_SIM_ROOMPARTITION_HPP
+#define MONADCOUNT_SIM_ROOMPARTITION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ScenarioEnvironment.hpp"
+
+namespace monadcount_sim::core {
+    // Room from the outer ring of a ROOM feature's polygon, with its bounding box and area.
+    Room MakeRoom(std::string id, const models::PolygonView &polygon);
+
+    [[nodiscard]] bool RoomContains(const Room &room, double x, double y);
+
+    // Index of the first room containing the point, or rooms.size() if it lies in none.
+    [[nodiscard]] std::size_t FindRoom(const std::vector<Room> &rooms, double x, double y);
+
+    // Spreads the rooms over `ranks` MPI ranks and sets Room::rank; returns each rank's load.
+    //
+    // A room is weighted by its floor area plus `nodeWeight` per infrastructure node inside, since pedestrians
+    // are spread by area and dominate the event count. Rooms go heaviest first to the least loaded rank (LPT),
+    // which keeps the heaviest rank within 4/3 of the optimum. Rooms are never split: a Wi-Fi channel cannot
+    // span ranks in ns-3's distributed simulator, and walls already separate rooms' radio traffic.
+    std::vector<double> AssignRoomsToRanks(std::vector<Room> &rooms, uint32_t ranks,
+                                           const std::vector<uint32_t> &nodesPerRoom, double nodeWeight);
+}
+
+#endif //MONADCOUNT_SIM_ROOMPARTITION_HPP
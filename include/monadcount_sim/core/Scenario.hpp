@@ -2,9 +2,16 @@
 #define MONADCOUNT_SIM_SCENARIO_HPP
 
 #include <ns3/core-module.h>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+#include "CaptureOptions.hpp"
+#include "ExperimentIndex.hpp"
 #include "ScenarioEnvironment.hpp"
+#include "ScenarioLoadOptions.hpp"
 
 namespace monadcount_sim::core {
     class Scenario {
@@ -17,9 +24,67 @@ namespace monadcount_sim::core {
         // Override this to customize environment building if needed
         virtual std::unique_ptr<ScenarioEnvironment> BuildEnvironment(const std::string &scenarioFile);
 
+        void SetLoadOptions(const ScenarioLoadOptions &options) { m_loadOptions = options; }
+
+        void SetCaptureOptions(const CaptureOptions &options) { m_captureOptions = options; }
+
+        // Parameters most scenarios share; one that a scenario does not have throws std::invalid_argument.
+        virtual void SetSimulationTime(double seconds);
+        virtual void SetNumPedestrians(uint32_t count);
+
+        // Execute() writes the metrics reported by the run to this file, one "name,value" line each (empty = no
+        // file). Sweeps collect them into their summary table (SweepRunner).
+        void SetMetricsFile(const std::string &path) { m_metricsFile = path; }
+
+        // Replicate the run `count` times from one set-up simulation (see RunSimulation), at most `jobs` at a
+        // time (0 = one per hardware thread). Replicas use RngRun values following the current one.
+        void SetReplications(uint32_t count, unsigned jobs = 0) {
+            m_replications = count;
+            m_replicationJobs = jobs;
+        }
+
     protected:
         // Actual simulation implementation
         virtual void Run(ScenarioEnvironment &env) = 0;
+
+        // A number describing the finished run, e.g. the simulated event count.
+        void ReportMetric(const std::string &name, double value);
+
+        // Run() implementations call this instead of Simulator::Run(), once the topology is built.
+        //
+        // Ordinarily it just runs the simulation and returns true. With replications it forks a child per
+        // replica instead, so the set-up is paid once and shared copy-on-write. Each child moves to its own
+        // RngRun, calls reseed to re-assign the streams of the random variables created during set-up (which
+        // were seeded with the parent's run), runs and returns true; the rest of Run() then finishes the
+        // replica and its metrics are sent to the parent, which waits for all replicas, reports replication
+        // throughput and memory, and gets false: it must skip the post-run work and only clean up.
+        //
+        // Files opened before the fork would be shared by the replicas, so Run() must not open any while
+        // IsReplicating().
+        bool RunSimulation(const std::function<void()> &reseed);
+
+        [[nodiscard]] bool IsReplicating() const { return m_replications > 1; }
+
+        ScenarioLoadOptions m_loadOptions;
+        CaptureOptions m_captureOptions;
+
+    private:
+        void WriteMetrics() const;
+        void RunReplicas(const std::function<void()> &reseed);
+        [[noreturn]] void FinishReplica();
+
+        std::string m_metricsFile;
+        std::vector<std::pair<std::string, double>> m_metrics;
+
+        uint32_t m_replications = 1;
+        unsigned m_replicationJobs = 0;
+        std::chrono::steady_clock::time_point m_executeStart;
+        std::chrono::steady_clock::time_point m_replicaStart;
+        int m_replicaPipe = -1;  // in a replica: where its metrics go
+
+        // Byte ranges of m_loadOptions.experimentId in the scenario file, using (and if needed writing) the
+        // cached experiment index.
+        std::vector<ByteRange> FindExperiment(const std::string &scenarioFile, uint64_t sourceHash) const;
     };
 }
 
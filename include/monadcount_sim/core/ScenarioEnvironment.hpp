@@ -12,11 +12,16 @@
 #include <vector>
 #include <string>
 
+#include "ObstacleIndex.hpp"
+
 namespace monadcount_sim::core {
     // Obstacle represents a wall, table, or other signal-affecting object.
     struct Obstacle {
         std::string id;
-        // Additional geometry or bounding box information can be added here.
+        Material material = Material::WALL;
+        // Outline edges in ScenarioEnvironment::obstacleIndex.
+        uint32_t firstSegment = 0;
+        uint32_t segmentCount = 0;
     };
 
     // Seat is an obstacle that can be occupied.
@@ -38,6 +43,15 @@ namespace monadcount_sim::core {
         Door() : x(0.0), y(0.0) {}
     };
 
+    // Room is a floor-plan polygon (outer ring only); the unit a partitioned venue assigns to an MPI rank.
+    struct Room {
+        std::string id;
+        std::vector<models::Point> outline;
+        double minX = 0.0, minY = 0.0, maxX = 0.0, maxY = 0.0;
+        double area = 0.0;
+        uint32_t rank = 0;  // ns-3 system id of the nodes inside (see RoomPartition.hpp)
+    };
+
     class ScenarioEnvironment {
     public:
         // NodeContainers for different device types.
@@ -49,8 +63,16 @@ namespace monadcount_sim::core {
         std::vector<Obstacle> obstacles;
         std::vector<Seat> seats;
         std::vector<Door> doors;
+        std::vector<Room> rooms;
+
+        // Number of ranks the rooms are spread over; 1 unless built with ScenarioLoadOptions::partitions.
+        uint32_t partitionCount = 1;
+
+        // Edges of all obstacle outlines, indexed for wall-crossing queries between two points.
+        ObstacleIndex obstacleIndex;
 
-        // Optionally, a pointer to a custom PropagationLossModel
+        // Optionally, a pointer to a custom PropagationLossModel (e.g. a MultiWallPropagationLossModel chain over
+        // obstacleIndex); experiments that honour it install it on their channels.
         ns3::Ptr<ns3::PropagationLossModel> obstacleLossModel;
     };
 
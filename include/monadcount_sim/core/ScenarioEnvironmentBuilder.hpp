@@ -6,10 +6,16 @@
 #define MONADCOUNT_SIM_SCENARIOENVIRONMENTBUILDER_HPP
 
 
+#include <chrono>
 #include <vector>
 #include <memory>
+#include <string_view>
 #include <monadcount_sim/models/Feature.hpp>
+#include <monadcount_sim/models/FeatureStore.hpp>
 
+#include <ns3/vector.h>
+
+#include "CompiledScenario.hpp"
 #include "ScenarioEnvironment.hpp"
 
 namespace monadcount_sim::core {
@@ -18,19 +24,75 @@ namespace monadcount_sim::core {
         // Build the environment from the parsed Feature objects.
         std::unique_ptr<ScenarioEnvironment> Build(const std::vector<std::unique_ptr<models::Feature>> &features);
 
+        // Build the environment from a memory-mapped compiled scenario, reading records in place.
+        std::unique_ptr<ScenarioEnvironment> Build(const CompiledScenario &scenario);
+
+        // Build the environment from an arena-backed feature store.
+        std::unique_ptr<ScenarioEnvironment> Build(const models::FeatureStore &store);
+
+        // Queue AP, sniffer and terminal features and create each category with one NodeContainer::Create,
+        // one position allocator and one mobility Install in Finish(), instead of per feature.
+        void SetBatched(bool batched) { m_batched = batched; }
+
+        // Spread the ROOM features over this many MPI ranks (see AssignRoomsToRanks) and create every AP,
+        // sniffer and terminal with the rank of the room it stands in as ns-3 system id (rank 0 outside all
+        // rooms). Node creation is then deferred to Finish(), as in batched mode, since rooms may follow the
+        // nodes in the input. 1 (the default) leaves every node on rank 0.
+        void SetPartitions(uint32_t ranks) { m_partitions = ranks; }
+
+        // Incremental interface for streamed input: Begin(), then Add() per feature, then Finish().
+        void Begin();
+
+        void Add(const models::Feature &feature);
+
+        void Add(const models::FeatureRef &feature);
+
+        std::unique_ptr<ScenarioEnvironment> Finish();
+
     private:
+        std::unique_ptr<ScenarioEnvironment> m_env;
+        std::chrono::steady_clock::time_point m_buildStart;
+
+        // Infrastructure nodes of one category waiting for Finish() in batched mode.
+        struct NodeBatch {
+            uint32_t count = 0;
+            std::vector<uint32_t> positioned;    // indices of nodes that have a position
+            std::vector<ns3::Vector> positions;  // parallel to positioned
+        };
+
+        bool m_batched = false;
+        uint32_t m_partitions = 1;
+        NodeBatch m_apBatch;
+        NodeBatch m_snifferBatch;
+        NodeBatch m_terminalBatch;
+
+        static void QueueNode(NodeBatch &batch, const models::FeatureRef &feature);
+
+        // systemIds holds one ns-3 system id per node; empty means all on system 0.
+        static ns3::NodeContainer CreateBatch(const NodeBatch &batch, const std::vector<uint32_t> &systemIds = {});
+
+        // Assigns the rooms to ranks, weighted by the queued nodes inside, and returns each batch's system ids.
+        void PartitionRooms(std::vector<uint32_t> &apIds, std::vector<uint32_t> &snifferIds,
+                            std::vector<uint32_t> &terminalIds);
+
+        // Reused when flattening a PolygonGeometry into a FeatureRef.
+        std::vector<models::Point> m_scratchPoints;
+        std::vector<models::RingSpan> m_scratchRings;
+
         // Helper methods for each feature type.
-        void createApNode(const models::Feature &feature, ScenarioEnvironment &env);
+        void createApNode(const models::FeatureRef &feature, ScenarioEnvironment &env);
+
+        void createSnifferNode(const models::FeatureRef &feature, ScenarioEnvironment &env);
 
-        void createSnifferNode(const models::Feature &feature, ScenarioEnvironment &env);
+        void createTerminalNode(const models::FeatureRef &feature, ScenarioEnvironment &env);
 
-        void createTerminalNode(const models::Feature &feature, ScenarioEnvironment &env);
+        void createObstacle(const models::FeatureRef &feature, ScenarioEnvironment &env);
 
-        void createObstacle(const models::Feature &feature, ScenarioEnvironment &env);
+        void createSeat(const models::FeatureRef &feature, ScenarioEnvironment &env);
 
-        void createSeat(const models::Feature &feature, ScenarioEnvironment &env);
+        void createDoor(const models::FeatureRef &feature, ScenarioEnvironment &env);
 
-        void createDoor(const models::Feature &feature, ScenarioEnvironment &env);
+        void createRoom(const models::FeatureRef &feature, ScenarioEnvironment &env);
     };
 }
 #endif //MONADCOUNT_SIM_SCENARIOENVIRONMENTBUILDER_HPP
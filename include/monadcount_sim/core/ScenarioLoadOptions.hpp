@@ -0,0 +1,36 @@
+#ifndef MONADCOUNT_SIM_SCENARIOLOADOPTIONS_HPP
+#define MONADCOUNT_SIM_SCENARIOLOADOPTIONS_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace monadcount_sim::core {
+    // How Scenario::BuildEnvironment turns the --input GeoJSON into a ScenarioEnvironment.
+    struct ScenarioLoadOptions {
+        // Stream features through the SAX parser straight into the builder instead of building a JSON DOM.
+        bool streaming = false;
+
+        // Stream features into a flat FeatureStore arena (implies the SAX parser) and build from that.
+        bool arena = false;
+
+        // Threads used to decode features on the DOM path; 0 means one per hardware thread.
+        unsigned parseThreads = 1;
+
+        // Create infrastructure nodes per category in one batch instead of one at a time.
+        bool batchedBuild = false;
+
+        // Spread the input's rooms over this many MPI ranks and give nodes their room's rank as ns-3 system id
+        // (ScenarioEnvironmentBuilder::SetPartitions); 1 = no partitioning.
+        uint32_t partitions = 1;
+
+        // Only load features whose properties.experiment_id matches (empty = all). Uses an experiment_id to byte
+        // range index of the input, built once and kept in cacheDirectory.
+        std::string experimentId;
+
+        // Reuse a compiled, memory-mapped copy of the input keyed by its content hash; written on first load.
+        bool useCache = false;
+        std::string cacheDirectory = "data/cache";  // also holds experiment indexes
+    };
+}
+
+#endif //MONADCOUNT_SIM_SCENARIOLOADOPTIONS_HPP
@@ -0,0 +1,67 @@
+#ifndef MONADCOUNT_SIM_SWEEPRUNNER_HPP
+#define MONADCOUNT_SIM_SWEEPRUNNER_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace monadcount_sim::core {
+    // One point of a parameter sweep: the command-line options that differ from the base run, and its ns-3 RngRun.
+    struct SweepRun {
+        uint32_t index = 0;
+        std::vector<std::pair<std::string, std::string>> parameters;  // option name, value
+        uint32_t rngRun = 1;
+    };
+
+    // How a run ended and the metrics its scenario reported (Scenario::ReportMetric).
+    struct SweepResult {
+        SweepRun run;
+        int exitCode = -1;  // negated signal number if the run was killed
+        double wallSeconds = 0.0;
+        long maxRssKb = 0;
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    // Axes of a sweep grid, "pedestrians=10,50,100;duration=600,1200"; throws std::invalid_argument.
+    std::vector<std::pair<std::string, std::vector<std::string>>> ParseSweepGrid(const std::string &grid);
+
+    // RngRun values, "1-16" or "1,4,9" or a mix; throws std::invalid_argument.
+    std::vector<uint32_t> ParseSeedList(const std::string &seeds);
+
+    // Every combination of the axes' values, each with every seed (seeds vary fastest).
+    std::vector<SweepRun> ExpandSweep(const std::vector<std::pair<std::string, std::vector<std::string>>> &axes,
+                                      const std::vector<uint32_t> &seeds);
+
+    // Runs a sweep in a bounded pool of worker processes.
+    //
+    // The ns-3 simulator is a process-wide singleton, so each run is a fresh process: the runner forks and execs
+    // `executable arguments... --<option>=<value>... --RngRun=<seed> --metrics=metrics.csv` with
+    // outputDirectory/run-<index> as working directory. Relative outputs of the scenario (data/<scenario>/...)
+    // thus land in the run's own directory, next to run.log (its stdout and stderr) and metrics.csv. Paths in
+    // arguments must be absolute. At the end, every run's status, wall time, peak RSS and metrics go into one
+    // table, outputDirectory/summary.csv.
+    class SweepRunner {
+    public:
+        // jobs == 0 means one worker per hardware thread.
+        SweepRunner(std::string executable, std::vector<std::string> arguments, std::string outputDirectory,
+                    unsigned jobs);
+
+        // Blocks until every run has finished; throws std::runtime_error if a run cannot be started or the
+        // summary cannot be written. Results are in run order.
+        std::vector<SweepResult> Run(const std::vector<SweepRun> &runs);
+
+        // Name of the metrics file every run writes in its directory.
+        static constexpr const char *kMetricsFile = "metrics.csv";
+
+    private:
+        void WriteSummary(const std::vector<SweepResult> &results) const;
+
+        std::string m_executable;
+        std::vector<std::string> m_arguments;
+        std::string m_outputDirectory;
+        unsigned m_jobs;
+    };
+}
+
+#endif //MONADCOUNT_SIM_SWEEPRUNNER_HPP
@@ -0,0 +1,158 @@
+#ifndef MONADCOUNT_SIM_TRAJECTORYFILE_HPP
+#define MONADCOUNT_SIM_TRAJECTORYFILE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <monadcount_sim/core/MappedFile.hpp>
+
+namespace monadcount_sim::core {
+    // One trajectory record: a periodic position sample, or a course change (waypoint) reported by a node's
+    // mobility model, which also carries the new velocity.
+    struct TrajectorySample {
+        enum Kind : uint8_t {
+            Position = 0,
+            CourseChange = 1
+        };
+
+        int64_t timeNs = 0;
+        uint32_t node = 0;    // ns-3 node id
+        uint8_t kind = Position;
+        int32_t position[3] = {};  // millimetres
+        int32_t velocity[3] = {};  // millimetres per second, CourseChange only
+    };
+
+    // Fixed-point unit of positions and velocities.
+    inline constexpr double kTrajectoryUnitsPerMetre = 1000.0;
+
+    struct TrajectoryWriterStats {
+        uint64_t samples = 0;
+        uint64_t blocks = 0;
+        uint64_t bytes = 0;   // file size so far
+        uint64_t stalls = 0;  // times the producer waited for ring space
+    };
+
+    // Trajectory file (.traj): a 32-byte header followed by independent blocks, everything little-endian.
+    //
+    //   header  "MCTRAJ01", uint32 header bytes (32), uint32 units per metre, int64 sample period in ns, 8 zero bytes
+    //   block   "TBLK", uint32 samples, uint32 payload bytes, uint32 0, int64 first and last time in ns,
+    //           then the payload, zero-padded to 8 bytes
+    //
+    // A payload holds its samples in order, each as zigzag LEB128 varints: node id delta, time delta (both
+    // against the previous sample of the block, starting from node 0 and the block's first time), then the
+    // kind byte, the x/y/z delta against the same node's previous sample in the block (against 0 for its first),
+    // and for course changes the absolute velocity. Blocks decode on their own, so a reader can map the file,
+    // walk the block headers and pick blocks by time; a file cut short by a crash loses at most its last block.
+    //
+    // Appending copies the fixed-size sample into a single-producer/single-consumer ring; a background thread
+    // encodes and writes whole blocks, so the simulator thread never encodes or touches the disk. It only waits
+    // when the ring is full.
+    class TrajectoryWriter {
+    public:
+        // Writes the header; throws std::runtime_error if the file cannot be created. ringSamples is rounded up
+        // to a power of two and to at least two blocks.
+        TrajectoryWriter(const std::string &path, int64_t samplePeriodNs, std::size_t ringSamples = 1u << 18,
+                         uint32_t blockSamples = 16384);
+
+        ~TrajectoryWriter();
+
+        TrajectoryWriter(const TrajectoryWriter &) = delete;
+        TrajectoryWriter &operator=(const TrajectoryWriter &) = delete;
+
+        // Producer side; samples must come from one thread in non-decreasing time order.
+        void Append(const TrajectorySample &sample) {
+            if (m_head - m_cachedConsumed > m_mask) {
+                WaitForSpace();
+            }
+            m_ring[m_head & m_mask] = sample;
+            ++m_head;
+            m_published.store(m_head, std::memory_order_release);
+            if (m_head % m_blockSamples == 0) {
+                Wake();
+            }
+        }
+
+        // Writes the remaining samples and closes the file; false if any write failed. Called by the destructor.
+        bool Close();
+
+        [[nodiscard]] TrajectoryWriterStats GetStats() const;
+
+        // Previous position of a node within the block being encoded or decoded. A stale generation means the
+        // node has not appeared in the current block yet.
+        struct NodeState {
+            int32_t position[3];
+            uint32_t generation;
+        };
+
+    private:
+        void WaitForSpace();
+        void Wake();
+        void WriterLoop();
+        bool WriteBlock(uint64_t first, uint32_t count, std::vector<uint8_t> &buffer);
+
+        int m_fd;
+        uint32_t m_blockSamples;
+        std::unique_ptr<TrajectorySample[]> m_ring;
+        uint64_t m_mask;
+
+        // Producer state; m_cachedConsumed is the last m_consumed it has seen.
+        uint64_t m_head = 0;
+        uint64_t m_cachedConsumed = 0;
+
+        alignas(64) std::atomic<uint64_t> m_published{0};
+        alignas(64) std::atomic<uint64_t> m_consumed{0};
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_pending;  // signals the writer thread
+        std::condition_variable m_space;    // signals the producer
+        bool m_stopping = false;
+        bool m_closed = false;
+        bool m_failed = false;
+        TrajectoryWriterStats m_stats;
+
+        // Writer thread only: per node id, which ns-3 hands out densely.
+        std::vector<NodeState> m_nodes;
+        uint32_t m_generation = 0;
+
+        std::thread m_writer;
+    };
+
+    // Memory-mapped view of a trajectory file.
+    class TrajectoryReader {
+    public:
+        struct Block {
+            std::size_t offset;  // of the payload
+            uint32_t samples;
+            uint32_t payloadBytes;
+            int64_t firstTimeNs;
+            int64_t lastTimeNs;
+        };
+
+        // Returns nullptr if the file is missing or not a trajectory file. A truncated last block is ignored.
+        static std::unique_ptr<TrajectoryReader> Open(const std::string &path);
+
+        [[nodiscard]] int64_t GetSamplePeriodNs() const { return m_samplePeriodNs; }
+
+        [[nodiscard]] const std::vector<Block> &GetBlocks() const { return m_blocks; }
+
+        // Decodes a block and appends its samples to out; throws std::runtime_error if it is corrupt.
+        void DecodeBlock(std::size_t block, std::vector<TrajectorySample> &out) const;
+
+    private:
+        TrajectoryReader(std::unique_ptr<MappedFile> file, int64_t samplePeriodNs, std::vector<Block> blocks)
+                : m_file(std::move(file)), m_samplePeriodNs(samplePeriodNs), m_blocks(std::move(blocks)) {}
+
+        std::unique_ptr<MappedFile> m_file;
+        int64_t m_samplePeriodNs;
+        std::vector<Block> m_blocks;
+    };
+}
+
+#endif //MONADCOUNT_SIM_TRAJECTORYFILE_HPP
@@ -0,0 +1,49 @@
+#ifndef MONADCOUNT_SIM_TRAJECTORYRECORDER_HPP
+#define MONADCOUNT_SIM_TRAJECTORYRECORDER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ns3/mobility-model.h>
+#include <ns3/node-container.h>
+#include <ns3/nstime.h>
+#include <ns3/ptr.h>
+
+#include <monadcount_sim/core/TrajectoryFile.hpp>
+
+namespace monadcount_sim::core {
+    // Ground-truth trajectories of simulated nodes, written to a compact binary file (see TrajectoryWriter)
+    // instead of being recovered from NetAnim XML.
+    //
+    // Every added node's MobilityModel is sampled once per period, and each CourseChange it fires is recorded
+    // as well, with the new velocity, so waypoints are exact regardless of the sampling rate. Recording costs a
+    // position query and a 40-byte copy into the writer's ring per sample.
+    class TrajectoryRecorder {
+    public:
+        // Throws std::runtime_error if the file cannot be created, std::invalid_argument for a period <= 0.
+        TrajectoryRecorder(const std::string &path, ns3::Time period);
+
+        // Records these nodes from now on; throws std::runtime_error for a node without a MobilityModel.
+        void Add(const ns3::NodeContainer &nodes);
+
+        // Takes the first sample now and then one every period.
+        void Start();
+
+        // Writes what is still buffered; false if a write failed.
+        bool Close();
+
+        [[nodiscard]] TrajectoryWriterStats GetStats() const { return m_writer.GetStats(); }
+
+    private:
+        void SampleAll();
+        void OnCourseChange(uint32_t node, ns3::Ptr<const ns3::MobilityModel> model);
+
+        TrajectoryWriter m_writer;
+        ns3::Time m_period;
+        std::vector<uint32_t> m_nodeIds;
+        std::vector<ns3::Ptr<ns3::MobilityModel>> m_models;
+    };
+}
+
+#endif //MONADCOUNT_SIM_TRAJECTORYRECORDER_HPP
@@ -7,13 +7,20 @@
 #ifdef WITH_NETSIMULYZER
 #include <ns3/netsimulyzer-module.h>
 #endif
+#include <ns3/mobility-model.h>
 #include <ns3/node-container.h>
+#include <ns3/nstime.h>
 #include <ns3/ptr.h>
+#include <monadcount_sim/core/NetAnimPositionWriter.hpp>
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <functional>
+#include <vector>
 
 namespace monadcount_sim::core {
 
@@ -41,17 +48,38 @@ namespace monadcount_sim::core {
         void EnableNetSimulyzer(const std::string& filename);
 #endif
 
+        // NetAnim output for long runs: only the registered nodes' positions, sampled every interval (a node
+        // that moved less than 1 cm is skipped), and their colour changes; no packet animation. Written by
+        // NetAnimPositionWriter, so it does not need WITH_NETANIM. Throws std::runtime_error if the file
+        // cannot be created.
+        void EnableNetAnimPositions(const std::string& filename, ns3::Time interval);
+
         void RegisterGroup(const std::string& groupId,
                            const ns3::NodeContainer& nodes,
                            const GroupVisualConfig& config);
 
         void Initialize();
 
+        // Cheap to call as often as convenient: a node whose AP did not change is dropped right away, and
+        // the remaining changes are written in one flush at the end of the current simulation instant, so a
+        // node that changes more than once per instant is written once (or not at all if it changed back).
         void OnNodeAssociated(uint32_t nodeId, int apId);
         void OnHandoverEvent(uint32_t nodeId, int fromAp, int toAp, double time);
         void LogMessage(const std::string& message);
 
+        // Association updates received, and colour writes that reached an output.
+        [[nodiscard]] uint64_t GetUpdateCount() const { return m_updates; }
+        [[nodiscard]] uint64_t GetWriteCount() const { return m_writes; }
+
+        // Position updates written by EnableNetAnimPositions.
+        [[nodiscard]] uint64_t GetPositionCount() const { return m_positionWrites; }
+
     private:
+        static constexpr int kNoAp = std::numeric_limits<int>::min();
+
+        void Flush();
+        void SamplePositions();
+
 #ifdef WITH_NETANIM
         ns3::AnimationInterface* m_anim = nullptr;
 #endif
@@ -66,8 +94,42 @@ namespace monadcount_sim::core {
             GroupVisualConfig config;
         };
 
-        std::map<std::string, Group> m_groups;
-        std::map<uint32_t, std::string> m_nodeToGroup;
+        // Indexed by node id, which ns-3 hands out densely. requestedAp is the latest association,
+        // appliedAp the one the outputs show.
+        struct NodeState {
+            int32_t group = -1;
+            int requestedAp = kNoAp;
+            int appliedAp = kNoAp;
+            bool pending = false;
+            std::array<uint8_t, 3> netanimColor{};
+            std::array<double, 3> netsimColor{};
+#ifdef WITH_NETSIMULYZER
+            ns3::Ptr<ns3::netsimulyzer::NodeConfiguration> netsimConfig;
+#endif
+        };
+
+        // Decimated NetAnim output and the registered nodes it samples, with their last written position.
+        struct SampledNode {
+            uint32_t nodeId;
+            ns3::Ptr<ns3::MobilityModel> mobility;
+            double x;
+            double y;
+        };
+
+        std::unique_ptr<NetAnimPositionWriter> m_animPositions;
+        ns3::Time m_animInterval;
+        std::vector<SampledNode> m_sampledNodes;
+        uint64_t m_positionWrites = 0;
+
+        std::vector<Group> m_groups;
+        std::map<std::string, uint32_t> m_groupIndex;
+        std::vector<NodeState> m_nodes;
+
+        std::vector<uint32_t> m_pending;  // node ids with pending changes
+        bool m_enabled = false;  // some output is open
+        bool m_flushScheduled = false;
+        uint64_t m_updates = 0;
+        uint64_t m_writes = 0;
     };
 
 } // namespace monadcount_sim::core
@@ -0,0 +1,188 @@
+#ifndef MONADCOUNT_SIM_FEATURESTORE_HPP
+#define MONADCOUNT_SIM_FEATURESTORE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "Category.hpp"
+#include "PointGeometry.hpp"
+
+namespace monadcount_sim::models {
+    // Contiguous run of points inside a shared point buffer.
+    struct RingSpan {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    struct PointView {
+        double x;
+        double y;
+    };
+
+    // Rings of a polygon; every ring indexes into the same point buffer.
+    struct PolygonView {
+        std::span<const RingSpan> rings;
+        const Point *points = nullptr;
+
+        [[nodiscard]] std::span<const Point> ring(std::size_t index) const {
+            return {points + rings[index].offset, rings[index].count};
+        }
+    };
+
+    using GeometryView = std::variant<std::monostate, PointView, PolygonView>;
+
+    // Non-owning view of one feature, independent of where it is stored (arena, mapped cache, Feature object).
+    struct FeatureRef {
+        std::string_view id;
+        std::string_view experimentId;
+        Category category{Category::UNKNOWN};
+        GeometryView geometry;
+    };
+
+    // Arena-backed feature storage: all points in one buffer, rings as offset spans into it, ids in one
+    // character buffer and the geometry kind as a tag. Adding a feature costs no per-feature heap allocation
+    // once the buffers have grown.
+    class FeatureStore {
+    public:
+        enum class GeometryKind : uint8_t {
+            POINT,
+            POLYGON
+        };
+
+        void reserve(std::size_t features, std::size_t points) {
+            records.reserve(features);
+            rings.reserve(features);
+            this->points.reserve(points);
+        }
+
+        void addPoint(std::string_view id, std::string_view experimentId, Category category, double x, double y) {
+            Record &record = addRecord(id, experimentId, category, GeometryKind::POINT);
+            record.ringCount = 1;
+            rings.push_back({static_cast<uint32_t>(points.size()), 1});
+            points.emplace_back(x, y);
+        }
+
+        // ringSpans index into polygonPoints; they are rebased onto the shared buffer.
+        void addPolygon(std::string_view id, std::string_view experimentId, Category category,
+                        std::span<const Point> polygonPoints, std::span<const RingSpan> ringSpans) {
+            Record &record = addRecord(id, experimentId, category, GeometryKind::POLYGON);
+            record.ringCount = static_cast<uint32_t>(ringSpans.size());
+            auto base = static_cast<uint32_t>(points.size());
+            for (const RingSpan &ring : ringSpans) {
+                rings.push_back({base + ring.offset, ring.count});
+            }
+            points.insert(points.end(), polygonPoints.begin(), polygonPoints.end());
+        }
+
+        void clear() {
+            records.clear();
+            rings.clear();
+            points.clear();
+            ids.clear();
+            experimentIds.clear();
+            experimentIndex.clear();
+            lastExperiment = 0;
+        }
+
+        [[nodiscard]] std::size_t size() const { return records.size(); }
+
+        [[nodiscard]] std::size_t pointCount() const { return points.size(); }
+
+        [[nodiscard]] std::string_view getId(std::size_t index) const {
+            return std::string_view(ids).substr(records[index].idOffset, records[index].idLength);
+        }
+
+        // Views returned by the accessors stay valid until the next add*() call.
+        [[nodiscard]] std::string_view getExperimentId(std::size_t index) const {
+            return experimentIds[records[index].experiment];
+        }
+
+        [[nodiscard]] Category getCategory(std::size_t index) const { return Category(records[index].category); }
+
+        [[nodiscard]] GeometryView getGeometry(std::size_t index) const {
+            const Record &record = records[index];
+            std::span<const RingSpan> featureRings(rings.data() + record.firstRing, record.ringCount);
+            if (record.kind == GeometryKind::POINT) {
+                const Point &pt = points[featureRings[0].offset];
+                return PointView{pt.x, pt.y};
+            }
+            return PolygonView{featureRings, points.data()};
+        }
+
+        [[nodiscard]] FeatureRef get(std::size_t index) const {
+            return {getId(index), getExperimentId(index), getCategory(index), getGeometry(index)};
+        }
+
+        // Calls visitor(const FeatureRef &) for every feature in insertion order.
+        template<typename Visitor>
+        void visit(Visitor &&visitor) const {
+            for (std::size_t i = 0; i < records.size(); ++i) {
+                visitor(get(i));
+            }
+        }
+
+    private:
+        struct Record {
+            uint32_t idOffset;
+            uint32_t idLength;
+            uint32_t experiment;
+            Category::Type category;
+            GeometryKind kind;
+            uint32_t firstRing;
+            uint32_t ringCount;
+        };
+
+        std::vector<Record> records;
+        std::vector<RingSpan> rings;
+        std::vector<Point> points;
+        std::string ids;
+
+        struct StringHash {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view value) const { return std::hash<std::string_view>{}(value); }
+        };
+
+        // Experiment ids repeat across nearly every feature, so they are interned.
+        std::vector<std::string> experimentIds;
+        std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> experimentIndex;
+        uint32_t lastExperiment = 0;
+
+        Record &addRecord(std::string_view id, std::string_view experimentId, Category category, GeometryKind kind) {
+            Record record{};
+            record.idOffset = static_cast<uint32_t>(ids.size());
+            record.idLength = static_cast<uint32_t>(id.size());
+            ids.append(id);
+            record.experiment = internExperiment(experimentId);
+            record.category = category.getType();
+            record.kind = kind;
+            record.firstRing = static_cast<uint32_t>(rings.size());
+            records.push_back(record);
+            return records.back();
+        }
+
+        uint32_t internExperiment(std::string_view experimentId) {
+            // Features of one experiment are usually exported together, so check the previous one first.
+            if (lastExperiment < experimentIds.size() && experimentIds[lastExperiment] == experimentId) {
+                return lastExperiment;
+            }
+            auto it = experimentIndex.find(experimentId);
+            if (it != experimentIndex.end()) {
+                lastExperiment = it->second;
+                return lastExperiment;
+            }
+            lastExperiment = static_cast<uint32_t>(experimentIds.size());
+            experimentIds.emplace_back(experimentId);
+            experimentIndex.emplace(experimentIds.back(), lastExperiment);
+            return lastExperiment;
+        }
+    };
+}
+
+#endif //MONADCOUNT_SIM_FEATURESTORE_HPP
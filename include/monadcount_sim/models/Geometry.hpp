@@ -8,10 +8,22 @@
 #include <string>
 
 namespace monadcount_sim::models {
+    class PointGeometry;
+    class PolygonGeometry;
+
+    // Double dispatch over the concrete geometry types, replacing getType() string compares and dynamic_cast.
+    class GeometryVisitor {
+    public:
+        virtual ~GeometryVisitor() = default;
+        virtual void visit(const PointGeometry &geometry) = 0;
+        virtual void visit(const PolygonGeometry &geometry) = 0;
+    };
+
     class Geometry {
     public:
         virtual ~Geometry() = default;
         virtual std::string getType() const = 0;
+        virtual void accept(GeometryVisitor &visitor) const = 0;
     };
 }
 
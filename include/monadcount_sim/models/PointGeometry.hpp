@@ -23,6 +23,8 @@ namespace monadcount_sim::models {
         PointGeometry(double x, double y) : point(x, y) {}
 
         std::string getType() const override { return "Point"; }
+
+        void accept(GeometryVisitor &visitor) const override { visitor.visit(*this); }
     };
 }
 
@@ -14,6 +14,8 @@ namespace monadcount_sim::models {
     public:
         std::vector<std::vector<Point>> rings;
         std::string getType() const override { return "Polygon"; }
+
+        void accept(GeometryVisitor &visitor) const override { visitor.visit(*this); }
     };
 }
 
@@ -0,0 +1,124 @@
+#ifndef MONADCOUNT_SIM_WIFI_CACHED_PROPAGATION_LOSS_MODEL_HPP
+#define MONADCOUNT_SIM_WIFI_CACHED_PROPAGATION_LOSS_MODEL_HPP
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/mobility-model.h"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        /// Counters of a CachedPropagationLossModel since creation (or the last ResetStats ()).
+        struct PathLossCacheStats
+        {
+            uint64_t hits = 0;       ///< lookups answered from a cached tile
+            uint64_t misses = 0;     ///< lookups that had to fill a tile first
+            uint64_t bypasses = 0;   ///< links with no static end, computed by the wrapped model
+            uint64_t evictions = 0;  ///< tiles dropped to stay within the memory budget
+            uint64_t tiles = 0;      ///< tiles currently cached
+            uint64_t bytes = 0;      ///< memory held by the cached tiles
+        };
+
+/**
+ * \brief Caching decorator that serves deterministic path loss of static transmitters from lazily filled maps.
+ *
+ * For every static end of a link (a ConstantPositionMobilityModel, typically an AP or sniffer) the venue is
+ * covered by a lattice with Resolution metre spacing, split into square tiles of TileSize cells. The first
+ * lookup inside a tile evaluates the wrapped model at all of the tile's lattice points; later lookups
+ * interpolate bilinearly between the four surrounding points. Tiles are kept in LRU order and dropped once
+ * MemoryBudget is exceeded.
+ *
+ * The wrapped model must be deterministic, linear in the transmit power and reciprocal (the same loss
+ * A->B as B->A), which holds for Friis, LogDistance, multi-wall and their chains. Stochastic fading
+ * (e.g. Nakagami) goes after this model with SetNext () and is therefore drawn per frame as before.
+ * Links between two moving nodes are passed through uncached.
+ */
+        class CachedPropagationLossModel : public ns3::PropagationLossModel
+        {
+        public:
+            static ns3::TypeId GetTypeId (void);
+            CachedPropagationLossModel ();
+            virtual ~CachedPropagationLossModel ();
+
+            /**
+             * \brief Set the deterministic model whose loss is cached.
+             * \param model Loss model or chain; clears the cache.
+             */
+            void SetModel (ns3::Ptr<ns3::PropagationLossModel> model);
+            ns3::Ptr<ns3::PropagationLossModel> GetModel (void) const;
+
+            /// \brief Drop every cached tile.
+            void Clear (void);
+
+            PathLossCacheStats GetStats (void) const;
+            void ResetStats (void);
+
+        protected:
+            virtual void DoDispose (void);
+
+        private:
+            double DoCalcRxPower (double txPowerDbm,
+                                  ns3::Ptr<ns3::MobilityModel> a,
+                                  ns3::Ptr<ns3::MobilityModel> b) const override;
+            int64_t DoAssignStreams (int64_t stream) override;
+
+            /// Tile (x, y) of a static transmitter's map, at one (quantized) receiver height.
+            struct TileKey
+            {
+                uint32_t transmitter;
+                int32_t x;
+                int32_t y;
+                int32_t z;
+
+                bool operator== (const TileKey &other) const = default;
+            };
+
+            struct TileKeyHash
+            {
+                std::size_t operator() (const TileKey &key) const;
+            };
+
+            struct Tile
+            {
+                std::vector<float> lossDb;             ///< (TileSize + 1)^2 lattice points, row-major
+                std::list<TileKey>::iterator lruEntry;
+            };
+
+            /// A link end seen before. A static end that has been moved gets a new id; its old tiles are
+            /// never hit again and age out of the LRU.
+            struct LinkEnd
+            {
+                bool isStatic;
+                uint32_t id;
+                ns3::Vector position;
+            };
+
+            static constexpr uint32_t kNotStatic = UINT32_MAX;
+
+            /// Id of the end's current map, or kNotStatic for a moving node.
+            uint32_t GetTransmitter (ns3::Ptr<ns3::MobilityModel> mobility) const;
+            const Tile &GetTile (ns3::Ptr<ns3::MobilityModel> transmitter, const TileKey &key) const;
+            void EvictOverBudget (void) const;
+
+            ns3::Ptr<ns3::PropagationLossModel> m_model;
+            double m_resolution;
+            uint32_t m_tileSize;
+            uint64_t m_memoryBudget;
+
+            // Lookups are const (CalcRxPower), the cache behind them is not.
+            mutable std::unordered_map<const ns3::MobilityModel *, LinkEnd> m_linkEnds;
+            mutable uint32_t m_nextTransmitter = 0;
+            mutable std::unordered_map<TileKey, Tile, TileKeyHash> m_tiles;
+            mutable std::list<TileKey> m_lru;  ///< most recently used first
+            mutable ns3::Ptr<ns3::MobilityModel> m_probe;  ///< receiver placed at lattice points while filling
+            mutable PathLossCacheStats m_stats;
+        };
+
+    } // namespace wifi
+} // namespace monadcount_sim
+
+#endif // MONADCOUNT_SIM_WIFI_CACHED_PROPAGATION_LOSS_MODEL_HPP
@@ -0,0 +1,129 @@
+#ifndef MONADCOUNT_SIM_WIFI_HANDOVER_ENGINE_HPP
+#define MONADCOUNT_SIM_WIFI_HANDOVER_ENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "ns3/event-id.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+
+#include "monadcount_sim/wifi/HandoverPredictor.hpp"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+/**
+ * \brief RSSI-based handover decisions for any number of stations and APs.
+ *
+ * RSSI is the log-distance estimate txPower - 10 * n * log10(max(d, 1 m)) over horizontal distance. A
+ * station hands over to its strongest AP once that AP beats the serving one by more than the margin,
+ * and then holds for the hold-off time.
+ *
+ * Station state is kept as dense arrays indexed by a compact station index, with the mobility models
+ * resolved once. A polling Tick () evaluates the whole stations x APs RSSI matrix in one batched kernel,
+ * several APs per SIMD operation. Alternatively, StartEventDriven () schedules one event per station at
+ * its predicted boundary crossing (see HandoverPredictor).
+ *
+ * With an RssiMonitor attached, Tick () decides on the RSSI the stations actually measured instead of the
+ * estimate; APs a station has not heard recently are never handover targets.
+ */
+        class RssiMonitor;
+
+        class HandoverEngine
+        {
+        public:
+            /// Called on every handover with the station index (see GetNodeId ()) and the AP indices it moved between.
+            using HandoverCallback = std::function<void (uint32_t station, uint32_t fromAp, uint32_t toAp)>;
+
+            HandoverEngine (double txPowerDbm, double pathLossExponent, double marginDb, ns3::Time holdOff);
+
+            /// \brief Add the APs (which must have a mobility model); their index is the insertion order.
+            void AddAps (const ns3::NodeContainer &aps);
+
+            /**
+             * \brief Add stations, each initially served by its strongest AP. Call after AddAps ().
+             * \return Index of the first added station.
+             */
+            uint32_t AddStations (const ns3::NodeContainer &stations);
+
+            void SetHandoverCallback (HandoverCallback callback);
+
+            /// \brief Take Tick ()'s RSSI from a monitor whose stations and APs were added in the same order
+            /// as here (nullptr restores the estimate). Event-driven mode keeps using the estimate.
+            void SetRssiMonitor (const RssiMonitor *monitor);
+
+            /// \brief Evaluate every station once, as of now.
+            void Tick (void);
+
+            /// \brief Schedule each station's predicted handover instead of polling; stations need
+            /// ConstantVelocity, Waypoint or ConstantPosition mobility. Nothing is scheduled past stopTime.
+            void StartEventDriven (ns3::Time stopTime);
+
+            uint32_t GetApCount (void) const { return static_cast<uint32_t> (m_apPositions.size ()); }
+            uint32_t GetStationCount (void) const { return static_cast<uint32_t> (m_nodeId.size ()); }
+            uint32_t GetNodeId (uint32_t station) const { return m_nodeId[station]; }
+            uint32_t GetServingAp (uint32_t station) const { return m_servingAp[station]; }
+
+            /// \brief RSSI (dBm) of a station from every AP as of the last Tick (); GetApCount () entries.
+            const float *GetRssi (uint32_t station) const { return m_rssi.data () + std::size_t (station) * m_apStride; }
+
+            /// \brief Station x AP evaluations so far (matrix entries in polling mode, predictions otherwise).
+            uint64_t GetChecks (void) const { return m_checks; }
+
+            /// APs are processed this many at a time; apStride arguments must be a multiple of it.
+            static constexpr uint32_t kApLanes = 8;
+
+            /**
+             * \brief Batched RSSI kernel: rssi[s * apStride + a] for every station s and AP a.
+             *
+             * Pad AP coordinates up to apStride with far-away positions; their entries are computed but
+             * meaningless. log10 is evaluated with a vectorized approximation: at most 1.5e-5 dB off for a
+             * path loss exponent of 3, in proportion to the exponent otherwise.
+             */
+            static void ComputeRssi (const float *stationX, const float *stationY, std::size_t stations,
+                                     const float *apX, const float *apY, std::size_t apStride,
+                                     float txPowerDbm, float pathLossExponent, float *rssi);
+
+        private:
+            uint32_t StrongestAp (uint32_t station) const;
+            void Handover (uint32_t station, uint32_t toAp);
+            void Predict (uint32_t station);
+            void OnPredictedHandover (uint32_t station);
+            void OnCourseChange (uint32_t station, ns3::Ptr<const ns3::MobilityModel>);
+
+            double m_txPowerDbm;
+            double m_pathLossExponent;
+            double m_marginDb;
+            ns3::Time m_holdOff;
+            HandoverPredictor m_predictor;
+            HandoverCallback m_onHandover;
+            const RssiMonitor *m_monitor = nullptr;
+
+            // APs: exact positions for prediction, padded float coordinates for the kernel.
+            std::vector<ns3::Vector> m_apPositions;
+            std::vector<float> m_apX;
+            std::vector<float> m_apY;
+            std::size_t m_apStride = 0;
+
+            // Stations, one entry per station index.
+            std::vector<uint32_t> m_nodeId;
+            std::vector<ns3::Ptr<ns3::MobilityModel>> m_mobility;
+            std::vector<float> m_x;
+            std::vector<float> m_y;
+            std::vector<uint32_t> m_servingAp;
+            std::vector<int64_t> m_holdUntil;  ///< time step before which the station does not hand over
+            std::vector<ns3::EventId> m_pending;  ///< event-driven mode only
+
+            std::vector<float> m_rssi;  ///< stations x m_apStride
+            uint64_t m_checks = 0;
+            ns3::Time m_stopTime;
+        };
+
+    } // namespace wifi
+} // namespace monadcount_sim
+
+#endif // MONADCOUNT_SIM_WIFI_HANDOVER_ENGINE_HPP
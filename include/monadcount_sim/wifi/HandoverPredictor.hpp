@@ -0,0 +1,52 @@
+#ifndef MONADCOUNT_SIM_WIFI_HANDOVER_PREDICTOR_HPP
+#define MONADCOUNT_SIM_WIFI_HANDOVER_PREDICTOR_HPP
+
+#include "ns3/vector.h"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+/**
+ * \brief Analytic prediction of RSSI hysteresis crossings for stations on straight-line courses.
+ *
+ * RSSI follows the log-distance estimate used by the handover experiments,
+ * rssi = txPower - 10 * n * log10(max(d, 1 m)) with d the horizontal distance. A station served by one AP
+ * hands over to another once the other's RSSI exceeds the serving one by more than a margin. For a station
+ * moving with constant velocity that condition reduces to a piecewise quadratic in time, so the first
+ * crossing can be computed instead of being found by periodic polling. Models with piecewise constant
+ * velocity (ConstantVelocity, Waypoint) stay exact as long as the prediction is redone on every
+ * CourseChange.
+ */
+        class HandoverPredictor
+        {
+        public:
+            /**
+             * \param marginDb Hysteresis margin in dB (>= 0).
+             * \param pathLossExponent Exponent n of the log-distance estimate (> 0).
+             */
+            HandoverPredictor (double marginDb, double pathLossExponent);
+
+            /**
+             * \brief Earliest time at which the candidate AP beats the serving AP by more than the margin.
+             * \param position Current station position.
+             * \param velocity Current station velocity.
+             * \param servingAp Position of the AP the station is associated with.
+             * \param candidateAp Position of the other AP.
+             * \return Seconds from now: 0 if the condition already holds, +infinity if it never will on this
+             *         course. At the returned time the two sides are equal; the condition holds right after.
+             */
+            double Predict (const ns3::Vector &position, const ns3::Vector &velocity,
+                            const ns3::Vector &servingAp, const ns3::Vector &candidateAp) const;
+
+            /// \brief The condition itself, for checking at a given position.
+            bool ShouldHandover (const ns3::Vector &position,
+                                 const ns3::Vector &servingAp, const ns3::Vector &candidateAp) const;
+
+        private:
+            double m_distanceRatioSquared;  ///< 10^(margin / (5 n)): the squared distance ratio at the boundary
+        };
+
+    } // namespace wifi
+} // namespace monadcount_sim
+
+#endif // MONADCOUNT_SIM_WIFI_HANDOVER_PREDICTOR_HPP
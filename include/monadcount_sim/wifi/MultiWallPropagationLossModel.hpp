@@ -0,0 +1,54 @@
+#ifndef MONADCOUNT_SIM_WIFI_MULTI_WALL_PROPAGATION_LOSS_MODEL_HPP
+#define MONADCOUNT_SIM_WIFI_MULTI_WALL_PROPAGATION_LOSS_MODEL_HPP
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/mobility-model.h"
+
+#include "monadcount_sim/core/ObstacleIndex.hpp"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+/**
+ * \brief Multi-wall propagation loss: a fixed attenuation for every obstacle on the direct path.
+ *
+ * The loss is purely additive and distance-independent, so the model is meant to be chained in front of
+ * a distance model (Friis, LogDistance, ...) with SetNext(). Obstacle outlines come from the scenario's
+ * ObstacleIndex; a link is tested against the walls of the grid cells it passes through, several packed
+ * edges per SIMD operation, and an obstacle is counted once however many of its edges the link crosses.
+ */
+        class MultiWallPropagationLossModel : public ns3::PropagationLossModel
+        {
+        public:
+            static ns3::TypeId GetTypeId (void);
+            MultiWallPropagationLossModel ();
+            virtual ~MultiWallPropagationLossModel ();
+
+            /**
+             * \brief Use the obstacles of a scenario.
+             * \param obstacles Built index of obstacle outlines, e.g. ScenarioEnvironment::obstacleIndex.
+             *
+             * The index is copied, so the model does not depend on the environment's lifetime. The
+             * per-material attenuation of the copy is taken from this model's attributes.
+             */
+            void SetObstacles (const core::ObstacleIndex &obstacles);
+
+            void SetWallAttenuation (double attenuationDb);
+            double GetWallAttenuation (void) const;
+
+            void SetTableAttenuation (double attenuationDb);
+            double GetTableAttenuation (void) const;
+
+        private:
+            double DoCalcRxPower (double txPowerDbm,
+                                  ns3::Ptr<ns3::MobilityModel> a,
+                                  ns3::Ptr<ns3::MobilityModel> b) const override;
+            int64_t DoAssignStreams (int64_t stream) override;
+
+            core::ObstacleIndex m_obstacles;
+        };
+
+    } // namespace wifi
+} // namespace monadcount_sim
+
+#endif // MONADCOUNT_SIM_WIFI_MULTI_WALL_PROPAGATION_LOSS_MODEL_HPP
@@ -5,6 +5,13 @@
 #include "ns3/wifi-assoc-manager.h"
 #include "ns3/sta-wifi-mac.h"
 #include "ns3/mac48-address.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+
+#include <optional>
+#include <vector>
 
 namespace monadcount_sim {
     namespace wifi {
@@ -13,8 +20,13 @@ namespace monadcount_sim {
  * \brief Custom association manager that triggers realistic handover based on RSSI.
  *
  * This class extends ns3::WifiAssocManager by providing a method to trigger a handover
- * procedure. The handover is performed by first deauthenticating the STA and then, after a short delay,
- * associating with the target Access Point (AP) specified by its identifier.
+ * procedure. The handover is performed by first deauthenticating the STA and then
+ * associating with the target Access Point (AP) specified by its BSSID.
+ *
+ * Every beacon the STA receives refreshes a small per-station cache of candidate APs. When the target
+ * of a handover has been heard within CandidateLifetime, the reassociation request goes straight to it
+ * and the active-probing scan is skipped; otherwise a regular scan (probe request, then waiting
+ * MaxChannelTime for responses) restricted to the target is performed.
  */
         class RssiBasedAssocManager : public ns3::WifiAssocManager
         {
@@ -24,17 +36,69 @@ namespace monadcount_sim {
             virtual ~RssiBasedAssocManager ();
 
             /**
-             * \brief Trigger a handover for the given STA WiFi MAC.
-             * \param staMac Pointer to the STA’s WiFi MAC instance.
-             * \param targetApId Identifier of the target AP.
+             * \brief Move the STA to another AP.
+             * \param targetBssid BSSID of the target AP.
              *
-             * This method simulates a realistic handover by performing a deauthentication,
-             * then scheduling reassociation with the new AP after a short delay.
+             * The STA is deauthenticated from its current AP and reassociates with the target, from the
+             * candidate cache when possible. Ignored while the STA is not associated (a scan is already
+             * running) or is already associated with the target.
+             * \return whether a handover was started; it ends with a Reassociated trace, or without one if
+             * the target is not found by the scan or does not associate within ReassociationTimeout.
+             */
+            bool TriggerHandover (ns3::Mac48Address targetBssid);
+
+            /// \brief Whether a beacon of the given AP was received within CandidateLifetime.
+            bool HasFreshCandidate (ns3::Mac48Address bssid) const;
+
+            void NotifyChannelSwitched (void) override;
+
+            /**
+             * TracedCallback signature for completed handovers.
+             * \param bssid AP the STA reassociated with.
+             * \param elapsed Time from TriggerHandover to the association.
+             * \param fromCache Whether the scan was skipped thanks to the candidate cache.
              */
-            void TriggerHandover (ns3::Ptr<ns3::StaWifiMac> staMac, uint32_t targetApId);
+            typedef void (*ReassociatedCallback) (ns3::Mac48Address bssid, ns3::Time elapsed, bool fromCache);
 
         protected:
             virtual void DoDispose (void);
+
+        private:
+            void DoStartScanning (void) override;
+            bool CanBeInserted (const ns3::StaWifiMac::ApInfo &apInfo) const override;
+            bool CanBeReturned (const ns3::StaWifiMac::ApInfo &apInfo) const override;
+
+            void EndScanning (void);
+            void AssociateFromCache (void);
+            bool IsScanned (ns3::Mac48Address bssid) const;
+            void StartReassociationTimeout (void);
+            void ReassociationTimeout (void);
+            void NotifyAssociated (ns3::Mac48Address bssid);
+
+            /// The last beacon of one AP; a station hears only a handful of APs, so a flat vector is enough.
+            struct Candidate
+            {
+                ns3::StaWifiMac::ApInfo apInfo;
+                ns3::Time lastSeen;
+            };
+
+            const Candidate *FindCandidate (ns3::Mac48Address bssid) const;
+
+            ns3::Time m_candidateLifetime;
+            ns3::Time m_reassociationTimeout;
+            mutable std::vector<Candidate> m_candidates;
+
+            std::optional<ns3::Mac48Address> m_target;  ///< set from TriggerHandover until associated or given up
+            ns3::Time m_handoverStart;
+            bool m_fromCache;
+            bool m_insertingCached;
+            bool m_assocConnected;
+            ns3::EventId m_scanEvent;
+            ns3::EventId m_probeEvent;
+            ns3::EventId m_assocTimeoutEvent;
+
+            ns3::TracedCallback<ns3::Mac48Address, ns3::Time, bool> m_reassociatedTrace;
+            ns3::TracedValue<uint32_t> m_scansAvoided;
         };
 
     } // namespace wifi
@@ -0,0 +1,100 @@
+#ifndef MONADCOUNT_SIM_WIFI_RSSI_MONITOR_HPP
+#define MONADCOUNT_SIM_WIFI_RSSI_MONITOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/wifi-phy.h"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+/**
+ * \brief Smoothed RSSI that stations actually receive from each AP, taken from the PHY MonitorSnifferRx trace.
+ *
+ * Every frame a station receives from an AP (beacons, probe responses, data) updates an exponentially
+ * weighted moving average, in dB, of the signal power reported by the PHY, so fading and walls configured on
+ * the channel are reflected. The averages live in one dense stations x APs table allocated up front.
+ *
+ * Per frame only the first 16 bytes of the MAC header are copied out of the packet; the transmitter address is
+ * turned into an AP index through a direct offset table (ns-3 hands out MAC addresses consecutively), or a
+ * binary search over the sorted AP addresses if they are scattered. No allocation or map lookup happens on
+ * the receive path.
+ */
+        class RssiMonitor
+        {
+        public:
+            /// Table value of a (station, AP) pair with no recent sample.
+            static constexpr float kNoSample = -std::numeric_limits<float>::infinity ();
+
+            /**
+             * \param alpha EWMA weight of a new sample, in (0, 1].
+             * \param maxAge Samples older than this read as kNoSample.
+             */
+            RssiMonitor (double alpha, ns3::Time maxAge);
+
+            /// \brief Register the AP devices; their index is the insertion order. Call before AddStations ().
+            void AddAps (const ns3::NetDeviceContainer &apDevices);
+
+            /**
+             * \brief Subscribe to the PHY of every station device.
+             * \return Index of the first added station.
+             */
+            uint32_t AddStations (const ns3::NetDeviceContainer &staDevices);
+
+            uint32_t GetApCount (void) const { return m_apCount; }
+            uint32_t GetStationCount (void) const { return m_stationCount; }
+
+            /// \brief Smoothed RSSI (dBm) of an AP at a station, or kNoSample.
+            float GetRssi (uint32_t station, uint32_t ap) const;
+
+            /// \brief Frames that updated the table so far.
+            uint64_t GetSamples (void) const { return m_samples; }
+
+            /**
+             * \brief Fold one received frame into the table.
+             * \param transmitter Transmitter address (addr2) as a 48-bit integer.
+             *
+             * This is the receive path without the trace plumbing; frames from non-AP transmitters are ignored.
+             */
+            void Update (uint32_t station, uint64_t transmitter, double signalDbm);
+
+        private:
+            void OnMonitorRx (uint32_t station, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                              ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, ns3::SignalNoiseDbm signalNoise,
+                              uint16_t staId);
+            uint32_t FindAp (uint64_t address) const;
+
+            static constexpr uint32_t kNotAp = UINT32_MAX;
+
+            float m_alpha;
+            int64_t m_maxAge;  ///< in time steps
+            uint32_t m_apCount = 0;
+            uint32_t m_stationCount = 0;
+            uint64_t m_samples = 0;
+
+            // AP address -> index. Dense: m_apByOffset[address - m_firstAddress]; otherwise sorted arrays.
+            uint64_t m_firstAddress = 0;
+            std::vector<uint32_t> m_apByOffset;
+            std::vector<uint64_t> m_sortedAddresses;
+            std::vector<uint32_t> m_sortedAps;
+
+            /// One (station, AP) pair; the average and its age share a cache line.
+            struct Entry
+            {
+                float rssi = kNoSample;
+                int64_t lastSample = 0;  ///< time step of the last update
+            };
+
+            std::vector<Entry> m_entries;  ///< stations x m_apCount, row-major
+        };
+
+    } // namespace wifi
+} // namespace monadcount_sim
+
+#endif // MONADCOUNT_SIM_WIFI_RSSI_MONITOR_HPP
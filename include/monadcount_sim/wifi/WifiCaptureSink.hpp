@@ -0,0 +1,99 @@
+#ifndef MONADCOUNT_SIM_WIFI_WIFI_CAPTURE_SINK_HPP
+#define MONADCOUNT_SIM_WIFI_WIFI_CAPTURE_SINK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ns3/net-device-container.h"
+#include "ns3/packet.h"
+#include "ns3/wifi-phy.h"
+
+#include "monadcount_sim/core/CaptureOptions.hpp"
+#include "monadcount_sim/core/CaptureWriter.hpp"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+/**
+ * \brief What one capture tap keeps: a set of 802.11 frame types/subtypes and a snap length.
+ *
+ * Frame types are a bit mask indexed by 16 * type + subtype of the frame control field (type 0 is
+ * management, 1 control, 2 data), so e.g. probe requests (0/4) are bit 4 and QoS data (2/8) bit 40.
+ */
+        struct WifiCaptureFilter
+        {
+            static constexpr uint64_t kAllFrames = ~uint64_t{0};
+            static constexpr uint64_t kManagement = 0xffff;
+            /// (Re)association request/response, probe request/response, disassociation, deauthentication.
+            static constexpr uint64_t kProbeAndAssociation = 0x143f;
+
+            static constexpr uint64_t Bit (uint8_t type, uint8_t subtype) { return uint64_t{1} << (16 * type + subtype); }
+
+            /**
+             * \brief Frame type mask from a comma-separated list of "all", "mgmt", "ctrl", "data",
+             * "probe-assoc" and "beacon".
+             * \return false on an unknown name.
+             */
+            static bool ParseFrameTypes (const std::string &names, uint64_t &frameTypes);
+
+            uint64_t frameTypes = kAllFrames;
+            uint32_t snapLength = 65535;  ///< bytes per frame, radiotap header included
+        };
+
+/**
+ * \brief Captures the frames of any number of Wi-Fi devices into one (compressed) pcapng file.
+ *
+ * Replaces YansWifiPhyHelper::EnablePcap, which opens a pcap file per device and writes it synchronously
+ * from the simulator thread. Every added device becomes a pcapng interface named
+ * "<prefix>-<node id>-<device index>" (the file names EnablePcap would have used) with a radiotap link
+ * layer carrying the channel and, for received frames, the signal and noise in dBm. Like EnablePcap, both
+ * MonitorSnifferRx and MonitorSnifferTx are recorded. Buffering, compression and disk I/O are done by
+ * core::CaptureWriter.
+ *
+ * Each AddDevices () call is a tap with its own WifiCaptureFilter. The filter is applied on the frame
+ * control byte before anything else is copied, and the snap length bounds what is copied, so frames that
+ * are dropped or truncated cost little more than the trace callback.
+ */
+        class WifiCaptureSink
+        {
+        public:
+            /**
+             * \param path Output file; conventionally ends in ".pcapng" plus core::CaptureCompressionSuffix ().
+             * \param compression Compression of the stream.
+             */
+            WifiCaptureSink (const std::string &path, core::CaptureCompression compression);
+
+            /// \brief Capture the given devices (WifiNetDevices) from now on, keeping what the filter selects.
+            void AddDevices (const ns3::NetDeviceContainer &devices, const std::string &prefix,
+                             const WifiCaptureFilter &filter = WifiCaptureFilter ());
+
+            /// \brief Filter with the frame types and snap length of the run's capture options.
+            static WifiCaptureFilter MakeFilter (const core::CaptureOptions &options);
+
+            /// \brief Flush and close the file; false if a write failed.
+            bool Close (void);
+
+            core::CaptureWriterStats GetStats (void) const;
+
+            /// \brief Frames rejected by the tap filters.
+            uint64_t GetFilteredFrames (void) const { return m_filteredFrames; }
+
+        private:
+            void OnMonitorRx (uint32_t interfaceId, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                              ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, ns3::SignalNoiseDbm signalNoise,
+                              uint16_t staId);
+            void OnMonitorTx (uint32_t interfaceId, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                              ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, uint16_t staId);
+            void Write (uint32_t interfaceId, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                        const ns3::SignalNoiseDbm *signalNoise);
+
+            core::CaptureWriter m_writer;
+            std::vector<WifiCaptureFilter> m_filters;  ///< indexed by interface id
+            uint64_t m_filteredFrames = 0;
+        };
+
+    } // namespace wifi
+} // namespace monadcount_sim
+
+#endif // MONADCOUNT_SIM_WIFI_WIFI_CAPTURE_SINK_HPP
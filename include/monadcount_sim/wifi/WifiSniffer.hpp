@@ -0,0 +1,88 @@
+#ifndef MONADCOUNT_SIM_WIFI_WIFI_SNIFFER_HPP
+#define MONADCOUNT_SIM_WIFI_WIFI_SNIFFER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/wifi-phy.h"
+
+#include "monadcount_sim/core/ArrowFileWriter.hpp"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+/**
+ * \brief Passive Wi-Fi sniffers that log one compact record per overheard frame into an Arrow file.
+ *
+ * Install () gives every sniffer node (normally ScenarioEnvironment::snifferNodes) a Wi-Fi device whose ad-hoc
+ * MAC never transmits, on the channel of the PHY helper it is given, so sniffers hear what a monitor-mode
+ * card at their position would. Installing the same nodes on several channels gives them one radio each.
+ *
+ * Each received management or data frame becomes a row of
+ *   timestamp   timestamp[ns]          simulation time of reception
+ *   sniffer     uint32                 index of the sniffer in the container it was installed from
+ *   transmitter fixed_size_binary[6]   addr2 of the MAC header
+ *   frame_type  uint8                  16 * type + subtype, as in WifiCaptureFilter
+ *   rssi        float32                signal power in dBm
+ *   channel     uint16                 channel number
+ * which is what a device-counting pipeline consumes, at 25 bytes per frame instead of a pcap record.
+ * Control frames, which carry no usable transmitter address, are skipped.
+ *
+ * Rows go into fixed-width column buffers allocated up front; a full set of buffers is written as one record
+ * batch by core::ArrowFileWriter, so the receive path only copies 16 header bytes and stores six values.
+ */
+        class WifiSniffer
+        {
+        public:
+            /**
+             * \param path Output file; conventionally ends in ".arrow".
+             * \param batchRows Rows per record batch.
+             */
+            WifiSniffer (const std::string &path, uint32_t batchRows = 65536);
+
+            /**
+             * \brief Give each node a passive sniffer device on the channel of the PHY helper.
+             * \return The installed devices.
+             */
+            ns3::NetDeviceContainer Install (const ns3::WifiHelper &wifi, const ns3::WifiPhyHelper &phy,
+                                             const ns3::NodeContainer &nodes);
+
+            /// \brief Record only these frame types (a WifiCaptureFilter mask); all by default.
+            void SetFrameTypes (uint64_t frameTypes) { m_frameTypes = frameTypes; }
+
+            /// \brief Write the pending rows and the file footer; false if a write failed.
+            bool Close (void);
+
+            /// \brief Rows recorded so far, written or pending.
+            uint64_t GetRecords (void) const { return m_writer.GetRows () + m_rows; }
+
+            uint64_t GetBytes (void) const { return m_writer.GetBytes (); }
+
+        private:
+            void OnMonitorRx (uint32_t sniffer, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                              ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, ns3::SignalNoiseDbm signalNoise,
+                              uint16_t staId);
+            void Flush (void);
+
+            core::ArrowFileWriter m_writer;
+            uint32_t m_batchRows;
+            uint32_t m_rows = 0;
+            uint64_t m_frameTypes = ~uint64_t{0};
+
+            std::vector<int64_t> m_timestamp;
+            std::vector<uint32_t> m_sniffer;
+            std::vector<uint8_t> m_transmitter;  ///< 6 bytes per row
+            std::vector<uint8_t> m_frameType;
+            std::vector<float> m_rssi;
+            std::vector<uint16_t> m_channel;
+        };
+
+    } // namespace wifi
+} // namespace monadcount_sim
+
+#endif // MONADCOUNT_SIM_WIFI_WIFI_SNIFFER_HPP
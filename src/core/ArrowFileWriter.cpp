@@ -0,0 +1,333 @@
+#include <monadcount_sim/core/ArrowFileWriter.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+    // Enum values of the Arrow flatbuffer schema (format/Schema.fbs, format/Message.fbs).
+    constexpr uint64_t kMetadataV5 = 4;
+    constexpr uint64_t kLittleEndian = 0;
+    constexpr uint8_t kTypeInt = 2;
+    constexpr uint8_t kTypeFloatingPoint = 3;
+    constexpr uint8_t kTypeTimestamp = 10;
+    constexpr uint8_t kTypeFixedSizeBinary = 15;
+    constexpr uint64_t kPrecisionSingle = 1;
+    constexpr uint64_t kPrecisionDouble = 2;
+    constexpr uint64_t kTimeUnitNanosecond = 3;
+    constexpr uint8_t kHeaderSchema = 1;
+    constexpr uint8_t kHeaderRecordBatch = 3;
+
+    constexpr char kMagic[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+    constexpr uint32_t kContinuation = 0xFFFFFFFF;
+
+    constexpr std::size_t pad8(std::size_t value) {
+        return (value + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    // Minimal flatbuffer encoder for the few Arrow metadata tables written here. Objects are laid out front
+    // to back, each table followed by what it references, which keeps every offset pointing forward as the
+    // format requires. Scalars are stored in host byte order, i.e. this assumes a little-endian host.
+    class FlatBuilder {
+    public:
+        using Emit = std::function<uint32_t(FlatBuilder &)>;
+
+        struct Field {
+            uint16_t id;
+            uint8_t size;    // inline bytes: 1, 2, 4 or 8
+            uint64_t value;  // scalars
+            Emit reference;  // tables, vectors and strings
+        };
+
+        static Field Scalar(uint16_t id, uint8_t size, uint64_t value) {
+            return {id, size, value, {}};
+        }
+
+        static Field Reference(uint16_t id, Emit emit) {
+            return {id, 4, 0, std::move(emit)};
+        }
+
+        // The root offset followed by the root table, padded to 8 bytes as Arrow message metadata must be.
+        std::vector<uint8_t> Finish(const Emit &root) {
+            m_data.assign(4, 0);
+            Patch(0, root(*this));
+            Align(8);
+            return std::move(m_data);
+        }
+
+        uint32_t Table(std::vector<Field> fields) {
+            uint16_t slots = 0;
+            std::size_t alignment = 4;
+            for (const Field &field: fields) {
+                slots = std::max<uint16_t>(slots, field.id + 1);
+                alignment = std::max<std::size_t>(alignment, field.size);
+            }
+            // After the offset to the vtable, largest fields first so that little padding is needed.
+            std::stable_sort(fields.begin(), fields.end(),
+                             [](const Field &a, const Field &b) { return a.size > b.size; });
+            std::vector<uint16_t> vtable(2 + slots, 0);
+            uint16_t inlineSize = 4;
+            for (const Field &field: fields) {
+                inlineSize = static_cast<uint16_t>((inlineSize + field.size - 1) / field.size * field.size);
+                vtable[2 + field.id] = inlineSize;
+                inlineSize = static_cast<uint16_t>(inlineSize + field.size);
+            }
+            vtable[0] = static_cast<uint16_t>(vtable.size() * sizeof(uint16_t));
+            vtable[1] = inlineSize;
+
+            Align(2);
+            const auto vtablePosition = static_cast<uint32_t>(m_data.size());
+            Append(vtable.data(), vtable[0]);
+            Align(alignment);
+            const auto tablePosition = static_cast<uint32_t>(m_data.size());
+            m_data.resize(tablePosition + inlineSize, 0);
+            const auto toVtable = static_cast<int32_t>(tablePosition - vtablePosition);
+            std::memcpy(m_data.data() + tablePosition, &toVtable, sizeof(toVtable));
+            for (const Field &field: fields) {
+                if (!field.reference) {
+                    std::memcpy(m_data.data() + tablePosition + vtable[2 + field.id], &field.value, field.size);
+                }
+            }
+            for (const Field &field: fields) {
+                if (field.reference) {
+                    const uint32_t slot = tablePosition + vtable[2 + field.id];
+                    Patch(slot, field.reference(*this));
+                }
+            }
+            return tablePosition;
+        }
+
+        uint32_t String(const std::string &value) {
+            Align(4);
+            const auto position = static_cast<uint32_t>(m_data.size());
+            const auto length = static_cast<uint32_t>(value.size());
+            Append(&length, sizeof(length));
+            Append(value.data(), value.size());
+            m_data.push_back(0);
+            return position;
+        }
+
+        // Vector of 8-byte aligned structs of structSize bytes each.
+        uint32_t Structs(const void *data, uint32_t count, uint32_t structSize) {
+            while ((m_data.size() + sizeof(uint32_t)) % 8 != 0) {
+                m_data.push_back(0);
+            }
+            const auto position = static_cast<uint32_t>(m_data.size());
+            Append(&count, sizeof(count));
+            Append(data, static_cast<std::size_t>(count) * structSize);
+            return position;
+        }
+
+        uint32_t Tables(const std::vector<Emit> &tables) {
+            Align(4);
+            const auto position = static_cast<uint32_t>(m_data.size());
+            const auto count = static_cast<uint32_t>(tables.size());
+            Append(&count, sizeof(count));
+            m_data.resize(m_data.size() + tables.size() * sizeof(uint32_t), 0);
+            for (uint32_t i = 0; i < count; ++i) {
+                Patch(position + 4 + 4 * i, tables[i](*this));
+            }
+            return position;
+        }
+
+    private:
+        void Align(std::size_t alignment) {
+            while (m_data.size() % alignment != 0) {
+                m_data.push_back(0);
+            }
+        }
+
+        void Append(const void *data, std::size_t size) {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            m_data.insert(m_data.end(), bytes, bytes + size);
+        }
+
+        void Patch(uint32_t slot, uint32_t target) {
+            const uint32_t offset = target - slot;
+            std::memcpy(m_data.data() + slot, &offset, sizeof(offset));
+        }
+
+        std::vector<uint8_t> m_data;
+    };
+
+    using Emit = FlatBuilder::Emit;
+
+    uint32_t fieldTable(FlatBuilder &builder, const monadcount_sim::core::ArrowColumn &column) {
+        using Type = monadcount_sim::core::ArrowColumn::Type;
+        uint8_t typeType = 0;
+        std::vector<FlatBuilder::Field> type;
+        switch (column.type) {
+            case Type::Int:
+                typeType = kTypeInt;
+                type = {FlatBuilder::Scalar(0, 4, column.byteWidth * 8), FlatBuilder::Scalar(1, 1, column.isSigned)};
+                break;
+            case Type::Float:
+                typeType = kTypeFloatingPoint;
+                type = {FlatBuilder::Scalar(0, 2, column.byteWidth == 4 ? kPrecisionSingle : kPrecisionDouble)};
+                break;
+            case Type::TimestampNs:
+                typeType = kTypeTimestamp;
+                type = {FlatBuilder::Scalar(0, 2, kTimeUnitNanosecond)};
+                break;
+            case Type::FixedSizeBinary:
+                typeType = kTypeFixedSizeBinary;
+                type = {FlatBuilder::Scalar(0, 4, column.byteWidth)};
+                break;
+        }
+        // Field: name, nullable, type_type, type, dictionary, children (required, even if empty).
+        return builder.Table({
+                FlatBuilder::Reference(0, [&column](FlatBuilder &b) { return b.String(column.name); }),
+                FlatBuilder::Scalar(1, 1, 0),
+                FlatBuilder::Scalar(2, 1, typeType),
+                FlatBuilder::Reference(3, [type](FlatBuilder &b) { return b.Table(type); }),
+                FlatBuilder::Reference(5, [](FlatBuilder &b) { return b.Tables({}); })});
+    }
+
+    Emit schemaTable(const std::vector<monadcount_sim::core::ArrowColumn> &columns) {
+        return [&columns](FlatBuilder &builder) {
+            std::vector<Emit> fields;
+            for (const auto &column: columns) {
+                fields.emplace_back([&column](FlatBuilder &b) { return fieldTable(b, column); });
+            }
+            return builder.Table({
+                    FlatBuilder::Scalar(0, 2, kLittleEndian),
+                    FlatBuilder::Reference(1, [fields](FlatBuilder &b) { return b.Tables(fields); })});
+        };
+    }
+
+    std::vector<uint8_t> message(uint8_t headerType, const Emit &header, int64_t bodyLength) {
+        return FlatBuilder().Finish([&](FlatBuilder &builder) {
+            return builder.Table({
+                    FlatBuilder::Scalar(0, 2, kMetadataV5),
+                    FlatBuilder::Scalar(1, 1, headerType),
+                    FlatBuilder::Reference(2, header),
+                    FlatBuilder::Scalar(3, 8, static_cast<uint64_t>(bodyLength))});
+        });
+    }
+}
+
+monadcount_sim::core::ArrowFileWriter::ArrowFileWriter(const std::string &path, std::vector<ArrowColumn> columns)
+        : m_columns(std::move(columns)) {
+    for (const ArrowColumn &column: m_columns) {
+        const uint32_t width = column.byteWidth;
+        bool valid = false;
+        switch (column.type) {
+            case ArrowColumn::Type::Int:
+                valid = width == 1 || width == 2 || width == 4 || width == 8;
+                break;
+            case ArrowColumn::Type::Float:
+                valid = width == 4 || width == 8;
+                break;
+            case ArrowColumn::Type::TimestampNs:
+                valid = width == 8;
+                break;
+            case ArrowColumn::Type::FixedSizeBinary:
+                valid = width > 0;
+                break;
+        }
+        if (!valid) {
+            throw std::invalid_argument("Unsupported Arrow column width: " + column.name);
+        }
+    }
+
+    m_out.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_out.is_open()) {
+        throw std::runtime_error("Could not create Arrow file: " + path);
+    }
+    Write(kMagic, sizeof(kMagic));
+    WriteMessage(message(kHeaderSchema, schemaTable(m_columns), 0));
+}
+
+monadcount_sim::core::ArrowFileWriter::~ArrowFileWriter() {
+    Close();
+}
+
+void monadcount_sim::core::ArrowFileWriter::WriteBatch(uint64_t rows, const void *const *columns) {
+    if (m_closed || rows == 0) {
+        return;
+    }
+
+    // Per column a field node (length, null count) and two buffers (offset, length): an empty validity
+    // bitmap, since nothing is null, then the values. Buffers start at 8-byte boundaries of the body.
+    std::vector<int64_t> nodes;
+    std::vector<int64_t> buffers;
+    int64_t bodyLength = 0;
+    for (const ArrowColumn &column: m_columns) {
+        const auto length = static_cast<int64_t>(rows * column.byteWidth);
+        nodes.insert(nodes.end(), {static_cast<int64_t>(rows), 0});
+        buffers.insert(buffers.end(), {bodyLength, 0, bodyLength, length});
+        bodyLength += static_cast<int64_t>(pad8(static_cast<std::size_t>(length)));
+    }
+
+    const auto header = [&](FlatBuilder &builder) {
+        const auto columnCount = static_cast<uint32_t>(m_columns.size());
+        return builder.Table({
+                FlatBuilder::Scalar(0, 8, rows),
+                FlatBuilder::Reference(1, [&](FlatBuilder &b) { return b.Structs(nodes.data(), columnCount, 16); }),
+                FlatBuilder::Reference(2, [&](FlatBuilder &b) {
+                    return b.Structs(buffers.data(), 2 * columnCount, 16);
+                })});
+    };
+    const std::vector<uint8_t> metadata = message(kHeaderRecordBatch, header, bodyLength);
+
+    Block block{static_cast<int64_t>(m_offset), static_cast<int32_t>(8 + metadata.size()), bodyLength};
+    WriteMessage(metadata);
+    static constexpr uint8_t zeros[8] = {};
+    for (std::size_t i = 0; i < m_columns.size(); ++i) {
+        const std::size_t length = rows * m_columns[i].byteWidth;
+        Write(columns[i], length);
+        Write(zeros, pad8(length) - length);
+    }
+    m_batches.push_back(block);
+    m_rows += rows;
+}
+
+void monadcount_sim::core::ArrowFileWriter::WriteMessage(const std::vector<uint8_t> &metadata) {
+    const auto length = static_cast<int32_t>(metadata.size());
+    Write(&kContinuation, sizeof(kContinuation));
+    Write(&length, sizeof(length));
+    Write(metadata.data(), metadata.size());
+}
+
+void monadcount_sim::core::ArrowFileWriter::Write(const void *data, std::size_t size) {
+    m_out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    m_offset += size;
+    m_failed = m_failed || !m_out;
+}
+
+bool monadcount_sim::core::ArrowFileWriter::Close() {
+    if (m_closed) {
+        return !m_failed;
+    }
+    m_closed = true;
+
+    // End-of-stream marker, then the footer: the schema again plus where each record batch starts.
+    const int32_t endOfStream = 0;
+    Write(&kContinuation, sizeof(kContinuation));
+    Write(&endOfStream, sizeof(endOfStream));
+
+    std::vector<uint8_t> blocks(m_batches.size() * 24, 0);
+    for (std::size_t i = 0; i < m_batches.size(); ++i) {
+        std::memcpy(&blocks[24 * i], &m_batches[i].offset, 8);
+        std::memcpy(&blocks[24 * i + 8], &m_batches[i].metadataLength, 4);
+        std::memcpy(&blocks[24 * i + 16], &m_batches[i].bodyLength, 8);
+    }
+    const Emit schema = schemaTable(m_columns);
+    const std::vector<uint8_t> footer = FlatBuilder().Finish([&](FlatBuilder &builder) {
+        const auto batchCount = static_cast<uint32_t>(m_batches.size());
+        return builder.Table({
+                FlatBuilder::Scalar(0, 2, kMetadataV5),
+                FlatBuilder::Reference(1, schema),
+                FlatBuilder::Reference(2, [](FlatBuilder &b) { return b.Structs(nullptr, 0, 24); }),
+                FlatBuilder::Reference(3, [&](FlatBuilder &b) { return b.Structs(blocks.data(), batchCount, 24); })});
+    });
+    const auto footerLength = static_cast<int32_t>(footer.size());
+    Write(footer.data(), footer.size());
+    Write(&footerLength, sizeof(footerLength));
+    Write(kMagic, 6);
+
+    m_out.close();
+    m_failed = m_failed || !m_out;
+    return !m_failed;
+}
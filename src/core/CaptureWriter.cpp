@@ -0,0 +1,305 @@
+#include <monadcount_sim/core/CaptureWriter.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef MONADCOUNT_SIM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef MONADCOUNT_SIM_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace {
+    // pcapng block types (native byte order; readers detect it from the section header's magic).
+    constexpr uint32_t kSectionHeaderBlock = 0x0A0D0D0A;
+    constexpr uint32_t kInterfaceDescriptionBlock = 0x00000001;
+    constexpr uint32_t kEnhancedPacketBlock = 0x00000006;
+    constexpr uint32_t kByteOrderMagic = 0x1A2B3C4D;
+
+    constexpr uint16_t kOptionEnd = 0;
+    constexpr uint16_t kOptionInterfaceName = 2;
+    constexpr uint16_t kOptionTimestampResolution = 9;
+
+    // Type, length, interface, two timestamp halves, captured and original length; the length again at the end.
+    constexpr std::size_t kPacketBlockOverhead = 7 * sizeof(uint32_t) + sizeof(uint32_t);
+
+    constexpr std::size_t pad4(std::size_t value) {
+        return (value + 3) & ~static_cast<std::size_t>(3);
+    }
+
+    template<typename T>
+    uint8_t *put(uint8_t *out, T value) {
+        std::memcpy(out, &value, sizeof(value));
+        return out + sizeof(value);
+    }
+
+    uint8_t *putOption(uint8_t *out, uint16_t code, const void *value, uint16_t length) {
+        out = put(out, code);
+        out = put(out, length);
+        std::memcpy(out, value, length);
+        std::memset(out + length, 0, pad4(length) - length);
+        return out + pad4(length);
+    }
+}
+
+monadcount_sim::core::CaptureCompression monadcount_sim::core::ParseCaptureCompression(const std::string &name) {
+    if (name == "none") {
+        return CaptureCompression::None;
+    }
+    if (name == "zstd") {
+        return CaptureCompression::Zstd;
+    }
+    if (name == "lz4") {
+        return CaptureCompression::Lz4;
+    }
+    throw std::invalid_argument("Unknown capture compression: " + name);
+}
+
+bool monadcount_sim::core::IsCaptureCompressionAvailable(CaptureCompression compression) {
+    switch (compression) {
+        case CaptureCompression::None:
+            return true;
+        case CaptureCompression::Zstd:
+#ifdef MONADCOUNT_SIM_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        case CaptureCompression::Lz4:
+#ifdef MONADCOUNT_SIM_HAVE_LZ4
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char *monadcount_sim::core::CaptureCompressionSuffix(CaptureCompression compression) {
+    switch (compression) {
+        case CaptureCompression::Zstd:
+            return ".zst";
+        case CaptureCompression::Lz4:
+            return ".lz4";
+        default:
+            return "";
+    }
+}
+
+monadcount_sim::core::CaptureWriter::CaptureWriter(const std::string &path, CaptureCompression compression,
+                                                   std::size_t blockBytes, std::size_t maxQueuedBlocks)
+        : m_compression(compression),
+          m_blockBytes(std::max<std::size_t>(blockBytes, 4096)),
+          m_maxQueuedBlocks(std::max<std::size_t>(maxQueuedBlocks, 1)) {
+    if (!IsCaptureCompressionAvailable(compression)) {
+        throw std::runtime_error("Capture compression not available in this build: " + path);
+    }
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+        throw std::runtime_error("Could not create capture file: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    m_current.capacity = m_blockBytes;
+    m_current.data = std::make_unique<uint8_t[]>(m_current.capacity);
+
+    // Section Header Block with no options and an unspecified section length.
+    constexpr uint32_t shbLength = 28;
+    uint8_t *out = Reserve(shbLength);
+    out = put(out, kSectionHeaderBlock);
+    out = put(out, shbLength);
+    out = put(out, kByteOrderMagic);
+    out = put(out, static_cast<uint16_t>(1));
+    out = put(out, static_cast<uint16_t>(0));
+    out = put(out, static_cast<int64_t>(-1));
+    put(out, shbLength);
+
+    m_writer = std::thread(&CaptureWriter::WriterLoop, this);
+}
+
+monadcount_sim::core::CaptureWriter::~CaptureWriter() {
+    Close();
+}
+
+uint32_t monadcount_sim::core::CaptureWriter::AddInterface(uint16_t linkType, uint32_t snapLength,
+                                                           const std::string &name) {
+    const auto nameLength = static_cast<uint16_t>(std::min<std::size_t>(name.size(), 0xFFFF));
+    const uint8_t resolution = 9;  // 10^-9 s
+    const auto length = static_cast<uint32_t>(20 + 4 + pad4(nameLength) + 4 + 4 + 4);
+
+    uint8_t *out = Reserve(length);
+    out = put(out, kInterfaceDescriptionBlock);
+    out = put(out, length);
+    out = put(out, linkType);
+    out = put(out, static_cast<uint16_t>(0));
+    out = put(out, snapLength);
+    out = putOption(out, kOptionInterfaceName, name.data(), nameLength);
+    out = putOption(out, kOptionTimestampResolution, &resolution, 1);
+    out = put(out, kOptionEnd);
+    out = put(out, static_cast<uint16_t>(0));
+    put(out, length);
+
+    return m_interfaces++;
+}
+
+uint8_t *monadcount_sim::core::CaptureWriter::AppendPacket(uint32_t interfaceId, uint64_t timestampNs,
+                                                           uint32_t capturedLength, uint32_t originalLength) {
+    const auto length = static_cast<uint32_t>(kPacketBlockOverhead + pad4(capturedLength));
+    uint8_t *out = Reserve(length);
+    out = put(out, kEnhancedPacketBlock);
+    out = put(out, length);
+    out = put(out, interfaceId);
+    out = put(out, static_cast<uint32_t>(timestampNs >> 32));
+    out = put(out, static_cast<uint32_t>(timestampNs));
+    out = put(out, capturedLength);
+    out = put(out, originalLength);
+    uint8_t *data = out;
+    out += capturedLength;
+    std::memset(out, 0, pad4(capturedLength) - capturedLength);
+    put(out + pad4(capturedLength) - capturedLength, length);
+    ++m_stats.frames;
+    return data;
+}
+
+uint8_t *monadcount_sim::core::CaptureWriter::Reserve(std::size_t bytes) {
+    if (m_current.size + bytes > m_current.capacity) {
+        Submit();
+        if (bytes > m_current.capacity) {
+            // A frame larger than a whole block gets a block of its own size.
+            m_current.capacity = bytes;
+            m_current.data = std::make_unique<uint8_t[]>(bytes);
+        }
+    }
+    uint8_t *out = m_current.data.get() + m_current.size;
+    m_current.size += bytes;
+    m_stats.capturedBytes += bytes;
+    return out;
+}
+
+void monadcount_sim::core::CaptureWriter::Submit() {
+    if (m_current.size == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_queue.size() >= m_maxQueuedBlocks) {
+        ++m_stats.stalls;
+        m_drained.wait(lock, [this] { return m_queue.size() < m_maxQueuedBlocks; });
+    }
+    m_queue.push_back(std::move(m_current));
+    ++m_stats.blocks;
+    if (!m_free.empty()) {
+        m_current = std::move(m_free.back());
+        m_free.pop_back();
+    } else {
+        m_current = Block{std::make_unique<uint8_t[]>(m_blockBytes), m_blockBytes, 0};
+    }
+    m_current.size = 0;
+    lock.unlock();
+    m_pending.notify_one();
+}
+
+void monadcount_sim::core::CaptureWriter::WriterLoop() {
+#ifdef MONADCOUNT_SIM_HAVE_ZSTD
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> zstd(
+            m_compression == CaptureCompression::Zstd ? ZSTD_createCCtx() : nullptr, &ZSTD_freeCCtx);
+#endif
+    std::vector<uint8_t> compressed;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_pending.wait(lock, [this] { return !m_queue.empty() || m_stopping; });
+        if (m_queue.empty()) {
+            break;
+        }
+        Block block = std::move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+        m_drained.notify_one();
+
+        const uint8_t *data = block.data.get();
+        std::size_t size = block.size;
+        bool ok = true;
+        switch (m_compression) {
+            case CaptureCompression::Zstd: {
+#ifdef MONADCOUNT_SIM_HAVE_ZSTD
+                // Level 1: several hundred MB/s per core, still 5-10x on mostly-header 802.11 traffic.
+                compressed.resize(ZSTD_compressBound(size));
+                std::size_t result = ZSTD_compressCCtx(zstd.get(), compressed.data(), compressed.size(), data, size, 1);
+                ok = !ZSTD_isError(result);
+                data = compressed.data();
+                size = ok ? result : 0;
+#endif
+                break;
+            }
+            case CaptureCompression::Lz4: {
+#ifdef MONADCOUNT_SIM_HAVE_LZ4
+                LZ4F_preferences_t preferences{};
+                preferences.frameInfo.contentSize = size;
+                compressed.resize(LZ4F_compressFrameBound(size, &preferences));
+                std::size_t result = LZ4F_compressFrame(compressed.data(), compressed.size(), data, size, &preferences);
+                ok = !LZ4F_isError(result);
+                data = compressed.data();
+                size = ok ? result : 0;
+#endif
+                break;
+            }
+            case CaptureCompression::None:
+                break;
+        }
+        ok = ok && WriteAll(data, size);
+
+        lock.lock();
+        m_failed = m_failed || !ok;
+        m_stats.writtenBytes += size;
+        // Oversized one-off blocks are not worth keeping around.
+        if (block.capacity == m_blockBytes && m_free.size() < m_maxQueuedBlocks) {
+            m_free.push_back(std::move(block));
+        }
+    }
+}
+
+bool monadcount_sim::core::CaptureWriter::WriteAll(const uint8_t *data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(m_fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool monadcount_sim::core::CaptureWriter::Close() {
+    if (m_closed) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_failed;
+    }
+    m_closed = true;
+    Submit();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_pending.notify_one();
+    m_writer.join();
+    bool closed = ::close(m_fd) == 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_failed = m_failed || !closed;
+    m_free.clear();
+    return !m_failed;
+}
+
+monadcount_sim::core::CaptureWriterStats monadcount_sim::core::CaptureWriter::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,257 @@
+#include <monadcount_sim/core/CompiledScenario.hpp>
+#include <monadcount_sim/core/MappedFile.hpp>
+#include "monadcount_sim/models/PointGeometry.hpp"
+#include "monadcount_sim/models/PolygonGeometry.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <variant>
+
+#include <unistd.h>
+
+namespace {
+    constexpr uint64_t align8(uint64_t value) {
+        return (value + 7) & ~static_cast<uint64_t>(7);
+    }
+
+    uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    void writePadding(std::ofstream &out, uint64_t written) {
+        static const char zeros[8] = {};
+        out.write(zeros, static_cast<std::streamsize>(align8(written) - written));
+    }
+}
+
+uint64_t monadcount_sim::core::HashBytes(std::string_view bytes) {
+    // Word-at-a-time multiply/xorshift; plenty to detect an edited floor plan, and runs at memory bandwidth.
+    const auto *data = reinterpret_cast<const unsigned char *>(bytes.data());
+    std::size_t size = bytes.size();
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ size;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h = (h ^ mix(word)) * 0x100000001b3ULL;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    return mix(h ^ mix(tail));
+}
+
+uint64_t monadcount_sim::core::HashFileContents(const std::string &filePath, uint64_t *fileSize) {
+    auto file = MappedFile::Open(filePath);
+    if (!file) {
+        throw std::runtime_error("Could not open file: " + filePath);
+    }
+    if (fileSize) {
+        *fileSize = file->GetSize();
+    }
+    return HashBytes(file->GetView());
+}
+
+uint32_t monadcount_sim::core::CompiledScenarioWriter::Intern(std::string_view value) {
+    auto it = m_interned.find(value);
+    if (it != m_interned.end()) {
+        return it->second;
+    }
+    auto offset = static_cast<uint32_t>(m_strings.size());
+    m_strings += value;
+    m_interned.emplace(value, offset);
+    return offset;
+}
+
+namespace {
+    // Flattens a Feature's geometry into the writer's ring and point sections.
+    class RecordGeometryVisitor : public monadcount_sim::models::GeometryVisitor {
+    public:
+        RecordGeometryVisitor(monadcount_sim::core::compiled::FeatureRecord &record,
+                              std::vector<monadcount_sim::core::compiled::RingRecord> &rings,
+                              std::vector<monadcount_sim::core::compiled::PointRecord> &points)
+                : record(record), rings(rings), points(points) {}
+
+        void visit(const monadcount_sim::models::PointGeometry &geometry) override {
+            record.geometryKind = monadcount_sim::core::compiled::POINT;
+            rings.push_back({static_cast<uint32_t>(points.size()), 1});
+            points.push_back(geometry.point);
+        }
+
+        void visit(const monadcount_sim::models::PolygonGeometry &geometry) override {
+            record.geometryKind = monadcount_sim::core::compiled::POLYGON;
+            for (const auto &ring : geometry.rings) {
+                rings.push_back({static_cast<uint32_t>(points.size()), static_cast<uint32_t>(ring.size())});
+                points.insert(points.end(), ring.begin(), ring.end());
+            }
+        }
+
+    private:
+        monadcount_sim::core::compiled::FeatureRecord &record;
+        std::vector<monadcount_sim::core::compiled::RingRecord> &rings;
+        std::vector<monadcount_sim::core::compiled::PointRecord> &points;
+    };
+}
+
+monadcount_sim::core::compiled::FeatureRecord monadcount_sim::core::CompiledScenarioWriter::MakeRecord(std::string_view id, std::string_view experimentId, models::Category category) {
+    compiled::FeatureRecord record{};
+    record.idOffset = Intern(id);
+    record.idLength = static_cast<uint32_t>(id.size());
+    record.experimentIdOffset = Intern(experimentId);
+    record.experimentIdLength = static_cast<uint32_t>(experimentId.size());
+    record.category = static_cast<uint8_t>(category.getType());
+    record.firstRing = static_cast<uint32_t>(m_rings.size());
+    return record;
+}
+
+void monadcount_sim::core::CompiledScenarioWriter::Add(const models::Feature &feature) {
+    if (!feature.getGeometry()) {
+        throw std::runtime_error("Cannot compile feature without geometry: " + feature.getId());
+    }
+    compiled::FeatureRecord record = MakeRecord(feature.getId(), feature.getExperimentId(), feature.getCategory());
+    RecordGeometryVisitor visitor(record, m_rings, m_points);
+    feature.getGeometry()->accept(visitor);
+
+    record.ringCount = static_cast<uint32_t>(m_rings.size() - record.firstRing);
+    m_features.push_back(record);
+}
+
+void monadcount_sim::core::CompiledScenarioWriter::Add(const models::FeatureRef &feature) {
+    compiled::FeatureRecord record = MakeRecord(feature.id, feature.experimentId, feature.category);
+
+    if (const auto *pt = std::get_if<models::PointView>(&feature.geometry)) {
+        record.geometryKind = compiled::POINT;
+        m_rings.push_back({static_cast<uint32_t>(m_points.size()), 1});
+        m_points.emplace_back(pt->x, pt->y);
+    } else if (const auto *poly = std::get_if<models::PolygonView>(&feature.geometry)) {
+        record.geometryKind = compiled::POLYGON;
+        for (std::size_t i = 0; i < poly->rings.size(); ++i) {
+            auto ring = poly->ring(i);
+            m_rings.push_back({static_cast<uint32_t>(m_points.size()), static_cast<uint32_t>(ring.size())});
+            m_points.insert(m_points.end(), ring.begin(), ring.end());
+        }
+    } else {
+        throw std::runtime_error("Cannot compile feature without geometry: " + std::string(feature.id));
+    }
+
+    record.ringCount = static_cast<uint32_t>(m_rings.size() - record.firstRing);
+    m_features.push_back(record);
+}
+
+void monadcount_sim::core::CompiledScenarioWriter::Write(const std::string &path, uint64_t sourceHash, uint64_t sourceSize) const {
+    compiled::Header header{};
+    std::memcpy(header.magic, compiled::kMagic, sizeof(header.magic));
+    header.version = compiled::kVersion;
+    header.headerSize = sizeof(compiled::Header);
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.featureCount = m_features.size();
+    header.ringCount = m_rings.size();
+    header.pointCount = m_points.size();
+    header.stringBytes = m_strings.size();
+    header.featuresOffset = align8(sizeof(compiled::Header));
+    header.ringsOffset = align8(header.featuresOffset + m_features.size() * sizeof(compiled::FeatureRecord));
+    header.pointsOffset = align8(header.ringsOffset + m_rings.size() * sizeof(compiled::RingRecord));
+    header.stringsOffset = align8(header.pointsOffset + m_points.size() * sizeof(compiled::PointRecord));
+
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path());
+    }
+    std::string tmpPath = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Could not write compiled scenario: " + tmpPath);
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        writePadding(out, sizeof(header));
+
+        auto writeSection = [&out](const void *data, uint64_t bytes) {
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+            writePadding(out, bytes);
+        };
+        writeSection(m_features.data(), m_features.size() * sizeof(compiled::FeatureRecord));
+        writeSection(m_rings.data(), m_rings.size() * sizeof(compiled::RingRecord));
+        writeSection(m_points.data(), m_points.size() * sizeof(compiled::PointRecord));
+        writeSection(m_strings.data(), m_strings.size());
+
+        if (!out) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Could not write compiled scenario: " + tmpPath);
+        }
+    }
+    std::filesystem::rename(tmpPath, target);
+}
+
+std::unique_ptr<monadcount_sim::core::CompiledScenario> monadcount_sim::core::CompiledScenario::Open(const std::string &path, uint64_t expectedHash) {
+    auto file = MappedFile::Open(path);
+    if (!file || file->GetSize() < sizeof(compiled::Header)) {
+        return nullptr;
+    }
+    std::size_t size = file->GetSize();
+    const char *base = file->GetData();
+    const auto *header = reinterpret_cast<const compiled::Header *>(base);
+    if (std::memcmp(header->magic, compiled::kMagic, sizeof(header->magic)) != 0 ||
+        header->version != compiled::kVersion ||
+        header->headerSize != sizeof(compiled::Header) ||
+        header->sourceHash != expectedHash) {
+        return nullptr;
+    }
+
+    auto fits = [size](uint64_t offset, uint64_t count, uint64_t elementSize) {
+        return offset <= size && count <= (size - offset) / elementSize;
+    };
+    if (!fits(header->featuresOffset, header->featureCount, sizeof(compiled::FeatureRecord)) ||
+        !fits(header->ringsOffset, header->ringCount, sizeof(compiled::RingRecord)) ||
+        !fits(header->pointsOffset, header->pointCount, sizeof(compiled::PointRecord)) ||
+        !fits(header->stringsOffset, header->stringBytes, 1)) {
+        return nullptr;
+    }
+
+    // Cross-references are checked once here so readers can index without bounds checks.
+    const auto *features = reinterpret_cast<const compiled::FeatureRecord *>(base + header->featuresOffset);
+    const auto *rings = reinterpret_cast<const compiled::RingRecord *>(base + header->ringsOffset);
+    for (uint64_t i = 0; i < header->ringCount; ++i) {
+        if (rings[i].offset > header->pointCount || rings[i].count > header->pointCount - rings[i].offset) {
+            return nullptr;
+        }
+    }
+    for (uint64_t i = 0; i < header->featureCount; ++i) {
+        const auto &f = features[i];
+        if (uint64_t(f.idOffset) + f.idLength > header->stringBytes ||
+            uint64_t(f.experimentIdOffset) + f.experimentIdLength > header->stringBytes ||
+            uint64_t(f.firstRing) + f.ringCount > header->ringCount ||
+            f.category > models::Category::UNKNOWN ||
+            (f.geometryKind != compiled::POINT && f.geometryKind != compiled::POLYGON)) {
+            return nullptr;
+        }
+        // GetFeatureRef reads a point's coordinates from its single one-point ring.
+        if (f.geometryKind == compiled::POINT && (f.ringCount != 1 || rings[f.firstRing].count != 1)) {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<CompiledScenario> scenario(new CompiledScenario());
+    scenario->m_file = std::move(file);
+    scenario->m_header = header;
+    scenario->m_features = features;
+    scenario->m_rings = rings;
+    scenario->m_points = reinterpret_cast<const compiled::PointRecord *>(base + header->pointsOffset);
+    scenario->m_strings = base + header->stringsOffset;
+    return scenario;
+}
+
+std::string monadcount_sim::core::CompiledScenario::CachePath(const std::string &cacheDirectory, const std::string &sourcePath, uint64_t hash) {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    std::string stem = std::filesystem::path(sourcePath).stem().string();
+    return (std::filesystem::path(cacheDirectory) / (stem + "-" + hex + ".mcscene")).string();
+}
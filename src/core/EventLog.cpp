@@ -0,0 +1,316 @@
+#include <monadcount_sim/core/EventLog.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    // Binary log (.bin): the magic, then entries of uint32 kind, uint32 payload bytes and the payload,
+    // zero-padded to 8 bytes. A definition (kind 1) holds uint32 code, name bytes, format bytes and 0, then
+    // the name and format; an event (kind 2) is an EventRecord as laid out in memory (little-endian).
+    constexpr char kFileMagic[8] = {'M', 'C', 'E', 'V', 'L', 'O', 'G', '1'};
+    constexpr uint32_t kDefinitionEntry = 1;
+    constexpr uint32_t kEventEntry = 2;
+
+    static_assert(sizeof(monadcount_sim::core::EventRecord) == 48);
+
+    // Records formatted between two writes at most, so a long backlog is released to the producer in steps.
+    constexpr uint64_t kBatchEvents = 4096;
+
+    constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+    constexpr std::size_t pad8(std::size_t value) {
+        return (value + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    template<typename T>
+    void append(std::string &out, T value) {
+        char digits[32];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void appendBinary(std::string &out, uint32_t kind, const void *payload, std::size_t size) {
+        const auto bytes = static_cast<uint32_t>(size);
+        out.append(reinterpret_cast<const char *>(&kind), sizeof(kind));
+        out.append(reinterpret_cast<const char *>(&bytes), sizeof(bytes));
+        out.append(static_cast<const char *>(payload), size);
+        out.append(pad8(size) - size, '\0');
+    }
+
+    bool writeAll(int fd, const std::string &data) {
+        const char *next = data.data();
+        std::size_t size = data.size();
+        while (size > 0) {
+            ssize_t written = ::write(fd, next, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            next += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    int openOutput(const std::string &path) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Could not create event log: " + path + " (" + std::strerror(errno) + ")");
+        }
+        return fd;
+    }
+
+    // A definition as the writer thread uses it: the text between the "{}" placeholders.
+    struct Layout {
+        std::string name;
+        std::vector<std::string> pieces;
+    };
+
+    Layout parseFormat(const std::string &name, const std::string &format) {
+        Layout layout{name, {}};
+        std::size_t start = 0;
+        std::size_t placeholder;
+        while ((placeholder = format.find("{}", start)) != std::string::npos) {
+            layout.pieces.push_back(format.substr(start, placeholder - start));
+            start = placeholder + 2;
+        }
+        layout.pieces.push_back(format.substr(start));
+        return layout;
+    }
+
+    void appendLine(std::string &out, const Layout &layout, const monadcount_sim::core::EventRecord &record) {
+        using monadcount_sim::core::EventRecord;
+        // Same shape as an NS_LOG line with time and function prefixes.
+        out += '+';
+        const int64_t timeNs = record.timeNs;
+        append(out, timeNs / 1000000000);
+        out += '.';
+        char fraction[10];
+        int64_t rest = timeNs % 1000000000;
+        for (int digit = 8; digit >= 0; --digit) {
+            fraction[digit] = static_cast<char>('0' + rest % 10);
+            rest /= 10;
+        }
+        out.append(fraction, 9);
+        out += "s ";
+        out += layout.name;
+        out += ": ";
+        for (std::size_t i = 0; i < layout.pieces.size(); ++i) {
+            out += layout.pieces[i];
+            if (i + 1 == layout.pieces.size()) {
+                break;
+            }
+            if (i >= record.argCount) {
+                out += "{}";
+                continue;
+            }
+            const uint64_t raw = record.args[i];
+            switch ((record.argTypes >> (2 * i)) & 3) {
+                case EventRecord::Int:
+                    append(out, static_cast<int64_t>(raw));
+                    break;
+                case EventRecord::Double:
+                    append(out, std::bit_cast<double>(raw));
+                    break;
+                default:
+                    append(out, raw);
+                    break;
+            }
+        }
+        out += '\n';
+    }
+}
+
+monadcount_sim::core::EventLogOptions monadcount_sim::core::ParseEventLogOptions(const std::string &names) {
+    EventLogOptions options;
+    std::size_t start = 0;
+    while (start <= names.size()) {
+        std::size_t end = names.find(',', start);
+        if (end == std::string::npos) {
+            end = names.size();
+        }
+        const std::string name = names.substr(start, end - start);
+        if (name == "console") {
+            options.console = true;
+        } else if (name == "text") {
+            options.text = true;
+        } else if (name == "binary") {
+            options.binary = true;
+        } else if (name != "none") {
+            throw std::invalid_argument("Unknown event log output '" + name + "' (use console, text, binary or none)");
+        }
+        start = end + 1;
+    }
+    return options;
+}
+
+monadcount_sim::core::EventLog::EventLog(const EventLogOptions &options, const std::string &basePath,
+                                         std::size_t capacity)
+        : m_enabled(options.console || options.text || options.binary),
+          m_console(options.console) {
+    std::size_t size = 1;
+    while (size < std::max<std::size_t>(capacity, 2 * kWakeEvery)) {
+        size <<= 1;
+    }
+    m_mask = size - 1;
+    if (!m_enabled) {
+        return;
+    }
+    m_ring = std::make_unique<EventRecord[]>(size);
+
+    if (options.text) {
+        m_textFd = openOutput(basePath + ".log");
+    }
+    if (options.binary) {
+        m_binaryFd = openOutput(basePath + ".bin");
+        m_failed = !writeAll(m_binaryFd, std::string(kFileMagic, sizeof(kFileMagic)));
+        m_stats.bytes = sizeof(kFileMagic);
+    }
+
+    m_writer = std::thread(&EventLog::WriterLoop, this);
+}
+
+monadcount_sim::core::EventLog::~EventLog() {
+    Close();
+}
+
+uint32_t monadcount_sim::core::EventLog::Intern(const std::string &name, const std::string &format) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_definitions.push_back(Definition{name, format});
+    return static_cast<uint32_t>(m_definitions.size() - 1);
+}
+
+void monadcount_sim::core::EventLog::WaitForSpace() {
+    m_cachedConsumed = m_consumed.load(std::memory_order_acquire);
+    if (m_head - m_cachedConsumed <= m_mask) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_stats.stalls;
+    m_pending.notify_one();
+    m_space.wait(lock, [this] {
+        m_cachedConsumed = m_consumed.load(std::memory_order_acquire);
+        return m_head - m_cachedConsumed <= m_mask;
+    });
+}
+
+void monadcount_sim::core::EventLog::Wake() {
+    // Taking the lock orders the publish before the writer's predicate check, so no wake-up is lost.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.notify_one();
+}
+
+void monadcount_sim::core::EventLog::WriterLoop() {
+    std::vector<Layout> layouts;
+    std::string text;
+    std::string binary;
+    uint64_t consumed = 0;
+    while (true) {
+        uint64_t published;
+        bool stopping;
+        {
+            // Besides batches of kWakeEvery, whatever is queued goes out every kFlushInterval, so console
+            // lines keep up with a slow simulation.
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pending.wait_for(lock, kFlushInterval, [&] {
+                published = m_published.load(std::memory_order_acquire);
+                return published - consumed >= kWakeEvery || m_stopping;
+            });
+            published = m_published.load(std::memory_order_acquire);
+            stopping = m_stopping;
+            for (std::size_t code = layouts.size(); code < m_definitions.size(); ++code) {
+                const Definition &definition = m_definitions[code];
+                layouts.push_back(parseFormat(definition.name, definition.format));
+                if (m_binaryFd >= 0) {
+                    std::string payload(16, '\0');
+                    const uint32_t header[4] = {static_cast<uint32_t>(code),
+                                                static_cast<uint32_t>(definition.name.size()),
+                                                static_cast<uint32_t>(definition.format.size()), 0};
+                    std::memcpy(payload.data(), header, sizeof(header));
+                    payload += definition.name;
+                    payload += definition.format;
+                    appendBinary(binary, kDefinitionEntry, payload.data(), payload.size());
+                }
+            }
+        }
+
+        while (consumed < published || !binary.empty()) {
+            const uint64_t end = std::min(published, consumed + kBatchEvents);
+            for (uint64_t i = consumed; i < end; ++i) {
+                const EventRecord &record = m_ring[i & m_mask];
+                if (m_binaryFd >= 0) {
+                    appendBinary(binary, kEventEntry, &record, sizeof(record));
+                }
+                if ((m_console || m_textFd >= 0) && record.code < layouts.size()) {
+                    appendLine(text, layouts[record.code], record);
+                }
+            }
+            const uint64_t events = end - consumed;
+            consumed = end;
+            m_consumed.store(consumed, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_space.notify_one();
+            }
+
+            bool ok = true;
+            if (m_console && !text.empty()) {
+                ok = writeAll(STDERR_FILENO, text) && ok;
+            }
+            if (m_textFd >= 0) {
+                ok = writeAll(m_textFd, text) && ok;
+            }
+            if (m_binaryFd >= 0) {
+                ok = writeAll(m_binaryFd, binary) && ok;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.events += events;
+            m_stats.bytes += (m_textFd >= 0 ? text.size() : 0) + binary.size();
+            m_failed = m_failed || !ok;
+            text.clear();
+            binary.clear();
+        }
+
+        if (stopping && consumed == m_published.load(std::memory_order_acquire)) {
+            break;
+        }
+    }
+}
+
+bool monadcount_sim::core::EventLog::Close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) {
+            return !m_failed;
+        }
+        m_closed = true;
+        m_stopping = true;
+        m_pending.notify_one();
+    }
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    for (int fd : {m_textFd, m_binaryFd}) {
+        if (fd >= 0 && ::close(fd) != 0) {
+            m_failed = true;
+        }
+    }
+    m_textFd = -1;
+    m_binaryFd = -1;
+    m_enabled = false;
+    return !m_failed;
+}
+
+monadcount_sim::core::EventLogStats monadcount_sim::core::EventLog::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
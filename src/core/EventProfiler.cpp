@@ -0,0 +1,343 @@
+#include <monadcount_sim/core/EventProfiler.hpp>
+
+#include <ns3/default-simulator-impl.h>
+#include <ns3/event-impl.h>
+#include <ns3/global-value.h>
+#include <ns3/string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+    using monadcount_sim::core::EventProfile;
+    using monadcount_sim::core::EventProfiler;
+
+    std::string demangle(const char *name) {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+        std::string result = status == 0 && demangled ? demangled : name;
+        std::free(demangled);
+        return result;
+    }
+
+    // The callable an EventImpl was made from: the first template argument of the MakeEvent it is local to,
+    // e.g. "void (ns3::Txop::*)()" or "HandoverExperiment::SetupHandover()::{lambda()#1}".
+    std::string callbackOf(const std::string &eventType) {
+        std::size_t open = eventType.find("MakeEvent<");
+        if (open == std::string::npos) {
+            return eventType;
+        }
+        std::size_t start = open + 10;
+        int depth = 0;
+        for (std::size_t i = start; i < eventType.size(); ++i) {
+            char c = eventType[i];
+            if (c == '<' || c == '(' || c == '{' || c == '[') {
+                ++depth;
+            } else if (c == ')' || c == '}' || c == ']' || (c == '>' && depth > 0)) {
+                --depth;
+            } else if (depth == 0 && (c == ',' || c == '>')) {
+                return eventType.substr(start, i - start);
+            }
+        }
+        return eventType;
+    }
+
+    // Class of a member function ("ns3::Txop" for "void (ns3::Txop::*)()"), the enclosing function of a
+    // lambda, or "functions" for plain function pointers.
+    std::string groupOf(const std::string &callback) {
+        std::size_t member = callback.find("::*)");
+        if (member != std::string::npos) {
+            std::size_t open = callback.rfind('(', member);
+            return callback.substr(open + 1, member - open - 1);
+        }
+        if (callback.find("(*)") != std::string::npos) {
+            return "functions";
+        }
+        return callback.substr(0, callback.find_first_of("(<"));
+    }
+
+    // Wrapper timing a sampled event. Freed ones are kept for reuse instead of going back to the allocator.
+    class ProfiledEvent : public ns3::EventImpl {
+    public:
+        ProfiledEvent(ns3::EventImpl *event, EventProfile *profile)
+                : m_event(event, false),
+                  m_profile(profile) {
+        }
+
+        static void *operator new(std::size_t size) {
+            std::vector<void *> &pool = freeList();
+            if (size == sizeof(ProfiledEvent) && !pool.empty()) {
+                void *memory = pool.back();
+                pool.pop_back();
+                return memory;
+            }
+            return ::operator new(size);
+        }
+
+        static void operator delete(void *memory, std::size_t size) {
+            std::vector<void *> &pool = freeList();
+            if (size == sizeof(ProfiledEvent) && pool.size() < (1u << 16)) {
+                pool.push_back(memory);
+                return;
+            }
+            ::operator delete(memory);
+        }
+
+    protected:
+        void Notify() override {
+            uint64_t start = EventProfiler::Ticks();
+            m_event->Invoke();
+            m_profile->ticks += EventProfiler::Ticks() - start;
+            ++m_profile->timed;
+        }
+
+    private:
+        static std::vector<void *> &freeList() {
+            thread_local std::vector<void *> pool;
+            return pool;
+        }
+
+        ns3::Ptr<ns3::EventImpl> m_event;
+        EventProfile *m_profile;
+    };
+
+    // The default (single-threaded) simulator, counting events as they are scheduled and wrapping the sampled
+    // ones.
+    class ProfilingSimulatorImpl : public ns3::DefaultSimulatorImpl {
+    public:
+        static ns3::TypeId GetTypeId() {
+            static ns3::TypeId tid = ns3::TypeId("monadcount_sim::core::ProfilingSimulatorImpl")
+                    .SetParent<ns3::DefaultSimulatorImpl>()
+                    .SetGroupName("MonadCountSim")
+                    .AddConstructor<ProfilingSimulatorImpl>();
+            return tid;
+        }
+
+        ns3::EventId Schedule(const ns3::Time &delay, ns3::EventImpl *event) override {
+            return DefaultSimulatorImpl::Schedule(delay, Wrap(event));
+        }
+
+        void ScheduleWithContext(uint32_t context, const ns3::Time &delay, ns3::EventImpl *event) override {
+            DefaultSimulatorImpl::ScheduleWithContext(context, delay, Wrap(event));
+        }
+
+        ns3::EventId ScheduleNow(ns3::EventImpl *event) override {
+            return DefaultSimulatorImpl::ScheduleNow(Wrap(event));
+        }
+
+        ns3::EventId ScheduleDestroy(ns3::EventImpl *event) override {
+            return DefaultSimulatorImpl::ScheduleDestroy(Wrap(event));
+        }
+
+        void Run() override {
+            uint64_t start = EventProfiler::Ticks();
+            DefaultSimulatorImpl::Run();
+            EventProfiler::Instance().AddRunTicks(EventProfiler::Ticks() - start);
+        }
+
+    private:
+        static ns3::EventImpl *Wrap(ns3::EventImpl *event) {
+            EventProfiler &profiler = EventProfiler::Instance();
+            EventProfile *profile = profiler.Lookup(typeid(*event));
+            ++profile->scheduled;
+            if (!profiler.TimeNext(*profile)) {
+                return event;
+            }
+            ++profile->sampled;
+            return new ProfiledEvent(event, profile);
+        }
+    };
+
+    NS_OBJECT_ENSURE_REGISTERED (ProfilingSimulatorImpl);
+
+    uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+monadcount_sim::core::EventProfiler &monadcount_sim::core::EventProfiler::Instance() {
+    static EventProfiler profiler;
+    return profiler;
+}
+
+uint64_t monadcount_sim::core::EventProfiler::Ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return nowNs();
+#endif
+}
+
+void monadcount_sim::core::EventProfiler::Enable() {
+    ns3::GlobalValue::Bind("SimulatorImplementationType",
+                           ns3::StringValue(ProfilingSimulatorImpl::GetTypeId().GetName()));
+    m_enabled = true;
+    m_calibrationTicks = Ticks();
+    m_calibrationNs = nowNs();
+}
+
+void monadcount_sim::core::EventProfiler::SetSamplePeriod(uint32_t period) {
+    if (period == 0) {
+        throw std::invalid_argument("EventProfiler: the sample period must be at least 1");
+    }
+    m_samplePeriod = period;
+    m_countdown = 1;
+}
+
+void monadcount_sim::core::EventProfiler::Disable() {
+    ns3::GlobalValue::Bind("SimulatorImplementationType", ns3::StringValue("ns3::DefaultSimulatorImpl"));
+    m_enabled = false;
+}
+
+monadcount_sim::core::EventProfile *monadcount_sim::core::EventProfiler::Lookup(const std::type_info &type) {
+    const std::size_t mask = m_table.size() - 1;
+    std::size_t slot = (reinterpret_cast<uintptr_t>(&type) >> 4) * 0x9E3779B97F4A7C15ull >> 20 & mask;
+    while (m_table[slot]) {
+        if (m_table[slot]->type == &type) {
+            return m_table[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    EventProfile &profile = m_profiles.emplace_back();
+    profile.type = &type;
+    m_table[slot] = &profile;
+    if (m_profiles.size() * 2 > m_table.size()) {
+        // Keep probes short: rehash into a table twice the size.
+        std::vector<EventProfile *> table(m_table.size() * 2, nullptr);
+        const std::size_t newMask = table.size() - 1;
+        for (EventProfile &entry : m_profiles) {
+            std::size_t s = (reinterpret_cast<uintptr_t>(entry.type) >> 4) * 0x9E3779B97F4A7C15ull >> 20 & newMask;
+            while (table[s]) {
+                s = (s + 1) & newMask;
+            }
+            table[s] = &entry;
+        }
+        m_table.swap(table);
+    }
+    return &profile;
+}
+
+double monadcount_sim::core::EventProfiler::SecondsPerTick() const {
+    uint64_t ticks = Ticks() - m_calibrationTicks;
+    uint64_t ns = nowNs() - m_calibrationNs;
+    return ticks > 0 && ns > 0 ? static_cast<double>(ns) / static_cast<double>(ticks) * 1e-9 : 1e-9;
+}
+
+std::vector<monadcount_sim::core::EventProfileEntry> monadcount_sim::core::EventProfiler::GetEntries() const {
+    const double secondsPerTick = SecondsPerTick();
+    // Equal types from different shared objects may have distinct type_info objects: merge by name.
+    std::map<std::pair<std::string, std::string>, EventProfileEntry> merged;
+    for (const EventProfile &profile : m_profiles) {
+        if (profile.timed == 0) {
+            continue;
+        }
+        std::string callback = callbackOf(demangle(profile.type->name()));
+        std::string group = groupOf(callback);
+        EventProfileEntry &entry = merged[{group, callback}];
+        entry.group = std::move(group);
+        entry.callback = std::move(callback);
+        entry.scheduled += profile.scheduled;
+        // Unsampled events are assumed to run, or be cancelled, and cost what the sampled ones of their type did.
+        double scale = static_cast<double>(profile.scheduled) / static_cast<double>(profile.sampled);
+        entry.events += static_cast<uint64_t>(static_cast<double>(profile.timed) * scale + 0.5);
+        entry.seconds += static_cast<double>(profile.ticks) * secondsPerTick * scale;
+    }
+
+    std::vector<EventProfileEntry> entries;
+    entries.reserve(merged.size());
+    for (auto &[key, entry] : merged) {
+        entries.push_back(std::move(entry));
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const EventProfileEntry &a, const EventProfileEntry &b) { return a.seconds > b.seconds; });
+    return entries;
+}
+
+double monadcount_sim::core::EventProfiler::GetRunSeconds() const {
+    return static_cast<double>(m_runTicks) * SecondsPerTick();
+}
+
+uint64_t monadcount_sim::core::EventProfiler::GetScheduledCount() const {
+    uint64_t scheduled = 0;
+    for (const EventProfile &profile : m_profiles) {
+        scheduled += profile.scheduled;
+    }
+    return scheduled;
+}
+
+uint64_t monadcount_sim::core::EventProfiler::GetEventCount() const {
+    uint64_t events = 0;
+    for (const EventProfileEntry &entry : GetEntries()) {
+        events += entry.events;
+    }
+    return events;
+}
+
+void monadcount_sim::core::EventProfiler::WriteReport(std::ostream &out, std::size_t topN) const {
+    std::vector<EventProfileEntry> entries = GetEntries();
+    double runSeconds = GetRunSeconds();
+    double eventSeconds = 0.0;
+    uint64_t events = 0;
+    for (const EventProfileEntry &entry : entries) {
+        eventSeconds += entry.seconds;
+        events += entry.events;
+    }
+    double total = runSeconds > 0.0 ? runSeconds : eventSeconds;
+
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%llu events scheduled, about %llu run (1 in %u timed), %.3f s in events of a %.3f s run "
+                  "(%.3f s between events)\n",
+                  static_cast<unsigned long long>(GetScheduledCount()), static_cast<unsigned long long>(events),
+                  m_samplePeriod, eventSeconds, runSeconds, std::max(0.0, runSeconds - eventSeconds));
+    out << line;
+    out << "   share     total s   scheduled    ~events   ns/event  group  callback\n";
+    for (std::size_t i = 0; i < entries.size() && i < topN; ++i) {
+        const EventProfileEntry &entry = entries[i];
+        std::snprintf(line, sizeof(line), "  %5.1f%%  %10.3f  %10llu  %9llu  %9.0f  ",
+                      total > 0.0 ? entry.seconds / total * 100.0 : 0.0, entry.seconds,
+                      static_cast<unsigned long long>(entry.scheduled), static_cast<unsigned long long>(entry.events),
+                      entry.events > 0 ? entry.seconds / static_cast<double>(entry.events) * 1e9 : 0.0);
+        out << line << entry.group << "  " << entry.callback << '\n';
+    }
+    if (entries.size() > topN) {
+        out << "  (" << entries.size() - topN << " more callback types)\n";
+    }
+}
+
+void monadcount_sim::core::EventProfiler::WriteCollapsed(std::ostream &out) const {
+    // Frames are separated by ';' and the count by the last space.
+    auto frame = [](std::string text) {
+        std::replace(text.begin(), text.end(), ';', ',');
+        return text;
+    };
+    std::vector<EventProfileEntry> entries = GetEntries();
+    double eventSeconds = 0.0;
+    for (const EventProfileEntry &entry : entries) {
+        auto micros = static_cast<unsigned long long>(entry.seconds * 1e6);
+        if (micros > 0) {
+            out << "ns-3;" << frame(entry.group) << ';' << frame(entry.callback) << ' ' << micros << '\n';
+        }
+        eventSeconds += entry.seconds;
+    }
+    double between = GetRunSeconds() - eventSeconds;
+    if (between > 0.0) {
+        out << "ns-3;(between events) " << static_cast<unsigned long long>(between * 1e6) << '\n';
+    }
+}
@@ -0,0 +1,333 @@
+#include <monadcount_sim/core/ExperimentIndex.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+namespace {
+    using json = nlohmann::json;
+
+    constexpr char kIndexMagic[8] = {'M', 'C', 'E', 'X', 'I', 'D', 'X', '\0'};
+    constexpr uint32_t kIndexVersion = 1;
+
+    // Walks the raw document just far enough to find the boundaries of each element of "features"; values
+    // are skipped by bracket matching without being decoded.
+    class DocumentScanner {
+    public:
+        explicit DocumentScanner(std::string_view document) : doc(document) {}
+
+        template<typename OnFeature>
+        std::string_view scanCollection(const OnFeature &onFeature) {
+            std::string_view type;
+            skipWhitespace();
+            expect('{');
+            skipWhitespace();
+            if (peek() == '}') {
+                return type;
+            }
+            for (;;) {
+                skipWhitespace();
+                std::string_view key = readString();
+                skipWhitespace();
+                expect(':');
+                skipWhitespace();
+                if (key == "type" && peek() == '"') {
+                    type = readString();
+                } else if (key == "features" && peek() == '[') {
+                    scanFeatures(onFeature);
+                } else {
+                    skipValue();
+                }
+                skipWhitespace();
+                char c = next();
+                if (c == '}') return type;
+                if (c != ',') fail("expected ',' or '}'");
+            }
+        }
+
+    private:
+        std::string_view doc;
+        std::size_t pos = 0;
+
+        [[noreturn]] void fail(const char *what) const {
+            throw std::runtime_error("Invalid GeoJSON: " + std::string(what) + " at byte " + std::to_string(pos));
+        }
+
+        char peek() const {
+            if (pos >= doc.size()) fail("unexpected end of input");
+            return doc[pos];
+        }
+
+        char next() {
+            char c = peek();
+            ++pos;
+            return c;
+        }
+
+        void expect(char c) {
+            if (next() != c) fail("unexpected character");
+        }
+
+        void skipWhitespace() {
+            while (pos < doc.size() && (doc[pos] == ' ' || doc[pos] == '\n' || doc[pos] == '\r' || doc[pos] == '\t')) {
+                ++pos;
+            }
+        }
+
+        // Returns the raw contents between the quotes; escapes are left as they are.
+        std::string_view readString() {
+            expect('"');
+            std::size_t begin = pos;
+            for (;;) {
+                char c = next();
+                if (c == '\\') {
+                    next();
+                } else if (c == '"') {
+                    return doc.substr(begin, pos - 1 - begin);
+                }
+            }
+        }
+
+        void skipValue() {
+            char c = peek();
+            if (c == '"') {
+                readString();
+            } else if (c == '{' || c == '[') {
+                int depth = 0;
+                do {
+                    c = peek();
+                    if (c == '"') {
+                        readString();
+                        continue;
+                    }
+                    if (c == '{' || c == '[') ++depth;
+                    else if (c == '}' || c == ']') --depth;
+                    ++pos;
+                } while (depth > 0);
+            } else {
+                while (pos < doc.size() && std::strchr(",}] \n\r\t", doc[pos]) == nullptr) {
+                    ++pos;
+                }
+            }
+        }
+
+        template<typename OnFeature>
+        void scanFeatures(const OnFeature &onFeature) {
+            expect('[');
+            skipWhitespace();
+            if (peek() == ']') {
+                ++pos;
+                return;
+            }
+            for (;;) {
+                skipWhitespace();
+                std::size_t begin = pos;
+                skipValue();
+                onFeature(doc.substr(begin, pos - begin), begin);
+                skipWhitespace();
+                char c = next();
+                if (c == ']') return;
+                if (c != ',') fail("expected ',' or ']'");
+            }
+        }
+    };
+
+    // Picks properties.experiment_id out of one feature object.
+    class ExperimentIdSax : public nlohmann::json_sax<json> {
+    public:
+        std::optional<std::string> experimentId;
+
+        bool null() override { return scalar(); }
+        bool boolean(bool) override { return scalar(); }
+        bool number_integer(number_integer_t) override { return scalar(); }
+        bool number_unsigned(number_unsigned_t) override { return scalar(); }
+        bool number_float(number_float_t, const string_t &) override { return scalar(); }
+        bool binary(binary_t &) override { return scalar(); }
+
+        bool string(string_t &val) override {
+            if (capture) experimentId = val;
+            return scalar();
+        }
+
+        bool start_object(std::size_t) override {
+            ++depth;
+            if (depth == 2) inProperties = featureKey == "properties";
+            capture = false;
+            return true;
+        }
+
+        bool key(string_t &val) override {
+            if (depth == 1) featureKey = val;
+            capture = depth == 2 && inProperties && val == "experiment_id";
+            return true;
+        }
+
+        bool end_object() override {
+            if (depth == 2) inProperties = false;
+            --depth;
+            return true;
+        }
+
+        bool start_array(std::size_t) override {
+            ++depth;
+            capture = false;
+            return true;
+        }
+
+        bool end_array() override {
+            --depth;
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override {
+            return false;
+        }
+
+    private:
+        int depth = 0;
+        bool inProperties = false;
+        bool capture = false;
+        std::string featureKey;
+
+        bool scalar() {
+            capture = false;
+            return true;
+        }
+    };
+
+    template<typename T>
+    void writeValue(std::ofstream &out, const T &value) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template<typename T>
+    bool readValue(std::ifstream &in, T &value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+    }
+}
+
+monadcount_sim::core::ExperimentIndex monadcount_sim::core::ExperimentIndex::Build(std::string_view document, uint64_t sourceHash) {
+    ExperimentIndex index;
+    index.m_sourceHash = sourceHash;
+
+    DocumentScanner scanner(document);
+    std::string_view type = scanner.scanCollection([&index](std::string_view feature, std::size_t offset) {
+        ++index.m_featureCount;
+        ExperimentIdSax sax;
+        if (!json::sax_parse(feature.begin(), feature.end(), &sax) || !sax.experimentId) {
+            ++index.m_unindexedCount;
+            return;
+        }
+        auto it = index.m_ranges.find(*sax.experimentId);
+        if (it == index.m_ranges.end()) {
+            it = index.m_ranges.emplace(*sax.experimentId, std::vector<ByteRange>{}).first;
+        }
+        it->second.push_back({offset, offset + feature.size()});
+    });
+    if (type != "FeatureCollection") {
+        throw std::runtime_error("Invalid GeoJSON: Not a FeatureCollection");
+    }
+    return index;
+}
+
+std::optional<monadcount_sim::core::ExperimentIndex> monadcount_sim::core::ExperimentIndex::Load(const std::string &path, uint64_t expectedHash) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return std::nullopt;
+    }
+    // Lengths read from the file are checked against its size before anything is allocated.
+    auto fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+
+    char magic[8];
+    uint32_t version = 0;
+    uint64_t experimentCount = 0;
+    uint64_t featureCount = 0;
+    uint64_t unindexedCount = 0;
+    ExperimentIndex index;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kIndexMagic, sizeof(magic)) != 0 ||
+        !readValue(in, version) || version != kIndexVersion ||
+        !readValue(in, index.m_sourceHash) || index.m_sourceHash != expectedHash ||
+        !readValue(in, featureCount) || !readValue(in, unindexedCount) || !readValue(in, experimentCount)) {
+        return std::nullopt;
+    }
+    index.m_featureCount = featureCount;
+    index.m_unindexedCount = unindexedCount;
+
+    for (uint64_t e = 0; e < experimentCount; ++e) {
+        uint64_t idLength = 0;
+        uint64_t rangeCount = 0;
+        if (!readValue(in, idLength) || idLength > fileSize) {
+            return std::nullopt;
+        }
+        std::string id(idLength, '\0');
+        if (!in.read(id.data(), static_cast<std::streamsize>(idLength)) || !readValue(in, rangeCount) ||
+            rangeCount > fileSize / sizeof(ByteRange)) {
+            return std::nullopt;
+        }
+        std::vector<ByteRange> ranges(rangeCount);
+        if (!in.read(reinterpret_cast<char *>(ranges.data()), static_cast<std::streamsize>(rangeCount * sizeof(ByteRange)))) {
+            return std::nullopt;
+        }
+        index.m_ranges.emplace(std::move(id), std::move(ranges));
+    }
+    return index;
+}
+
+void monadcount_sim::core::ExperimentIndex::Save(const std::string &path) const {
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path());
+    }
+    std::string tmpPath = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Could not write experiment index: " + tmpPath);
+        }
+        out.write(kIndexMagic, sizeof(kIndexMagic));
+        writeValue(out, kIndexVersion);
+        writeValue(out, m_sourceHash);
+        writeValue(out, static_cast<uint64_t>(m_featureCount));
+        writeValue(out, static_cast<uint64_t>(m_unindexedCount));
+        writeValue(out, static_cast<uint64_t>(m_ranges.size()));
+        for (const auto &[id, ranges] : m_ranges) {
+            writeValue(out, static_cast<uint64_t>(id.size()));
+            out.write(id.data(), static_cast<std::streamsize>(id.size()));
+            writeValue(out, static_cast<uint64_t>(ranges.size()));
+            out.write(reinterpret_cast<const char *>(ranges.data()), static_cast<std::streamsize>(ranges.size() * sizeof(ByteRange)));
+        }
+        if (!out) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Could not write experiment index: " + tmpPath);
+        }
+    }
+    std::filesystem::rename(tmpPath, target);
+}
+
+std::string monadcount_sim::core::ExperimentIndex::IndexPath(const std::string &cacheDirectory, const std::string &sourcePath, uint64_t hash) {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    std::string stem = std::filesystem::path(sourcePath).stem().string();
+    return (std::filesystem::path(cacheDirectory) / (stem + "-" + hex + ".mcindex")).string();
+}
+
+const std::vector<monadcount_sim::core::ByteRange> *monadcount_sim::core::ExperimentIndex::Find(std::string_view experimentId) const {
+    auto it = m_ranges.find(experimentId);
+    return it == m_ranges.end() ? nullptr : &it->second;
+}
+
+std::vector<std::string> monadcount_sim::core::ExperimentIndex::GetExperimentIds() const {
+    std::vector<std::string> ids;
+    ids.reserve(m_ranges.size());
+    for (const auto &entry : m_ranges) {
+        ids.push_back(entry.first);
+    }
+    return ids;
+}
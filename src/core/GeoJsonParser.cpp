@@ -1,15 +1,614 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <optional>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
 
 #include <nlohmann/json.hpp>
 #include <monadcount_sim/models/Feature.hpp>
 #include <monadcount_sim/core/GeoJsonParser.hpp>
+#include <monadcount_sim/core/MappedFile.hpp>
+#include <monadcount_sim/core/ResourceUsage.hpp>
 #include "monadcount_sim/models/PointGeometry.hpp"
 #include "monadcount_sim/models/PolygonGeometry.hpp"
+#include "monadcount_sim/models/FeatureStore.hpp"
+
+namespace {
+    using json = nlohmann::json;
+
+    // Read buffer for the streaming path; large enough that the SAX lexer is never starved by small reads.
+    constexpr std::size_t kStreamBufferSize = 1 << 20;
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Features per work item when decoding in parallel; large enough to amortise the atomic fetch.
+    constexpr std::size_t kParallelBatchSize = 256;
+
+    struct DecodedFeature {
+        std::unique_ptr<monadcount_sim::models::Feature> feature;
+        std::string error;
+    };
+
+    // Converts one element of the "features" array; throws on malformed input.
+    std::unique_ptr<monadcount_sim::models::Feature> decodeFeature(const json &featureJson) {
+        // Extract common properties.
+        std::string id = featureJson["properties"]["id"].get<std::string>();
+        std::string experiment_id = featureJson["properties"]["experiment_id"].get<std::string>();
+        std::string catStr = featureJson["properties"]["category"].get<std::string>();
+        monadcount_sim::models::Category cat = monadcount_sim::models::Category::fromString(catStr);
+
+        // Parse geometry.
+        std::string geomType = featureJson["geometry"]["type"].get<std::string>();
+        std::unique_ptr<monadcount_sim::models::Geometry> geometry;
+
+        if (geomType == "Point") {
+            const auto &coords = featureJson["geometry"]["coordinates"];
+            if (!coords.is_array() || coords.size() < 2)
+                throw std::runtime_error("Invalid Point coordinates");
+            double x = coords[0].get<double>();
+            double y = coords[1].get<double>();
+            geometry = std::make_unique<monadcount_sim::models::PointGeometry>(x, y);
+        } else if (geomType == "Polygon") {
+            const auto &coords = featureJson["geometry"]["coordinates"];
+            auto polyGeom = std::make_unique<monadcount_sim::models::PolygonGeometry>();
+            for (const auto &ring : coords) {
+                std::vector<monadcount_sim::models::Point> loop;
+                for (const auto &pt : ring) {
+                    if (!pt.is_array() || pt.size() < 2)
+                        throw std::runtime_error("Invalid polygon point");
+                    double x = pt[0].get<double>();
+                    double y = pt[1].get<double>();
+                    loop.push_back(monadcount_sim::models::Point(x, y));
+                }
+                polyGeom->rings.push_back(loop);
+            }
+            geometry = std::move(polyGeom);
+        } else {
+            throw std::runtime_error("Unsupported geometry type: " + geomType);
+        }
+
+        return std::make_unique<monadcount_sim::models::Feature>(id, experiment_id, cat, std::move(geometry));
+    }
+
+    // Runs decodeOne(i) for i in [0, count) on up to `threads` threads (0 = hardware concurrency) and returns
+    // the features in index order. Errors are counted and printed in index order too, so the outcome does not
+    // depend on the thread count.
+    template<typename DecodeOne>
+    std::vector<std::unique_ptr<monadcount_sim::models::Feature>> decodeAll(std::size_t count, unsigned threads,
+                                                                            monadcount_sim::core::ParseReport &report,
+                                                                            const DecodeOne &decodeOne) {
+        std::vector<DecodedFeature> decoded(count);
+        auto decodeRange = [&decoded, &decodeOne](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                try {
+                    decoded[i].feature = decodeOne(i);
+                } catch (const std::exception &ex) {
+                    decoded[i].error = ex.what();
+                }
+            }
+        };
+
+        unsigned workers = threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+        if (workers <= 1 || count < kParallelBatchSize * 2) {
+            decodeRange(0, count);
+        } else {
+            // Workers pull fixed-size batches so uneven polygons do not leave threads idle; every result lands
+            // in its own slot, so the merge below sees features in document order.
+            std::atomic<std::size_t> nextBatch{0};
+            auto worker = [&]() {
+                for (;;) {
+                    std::size_t first = nextBatch.fetch_add(kParallelBatchSize);
+                    if (first >= count) return;
+                    decodeRange(first, std::min(first + kParallelBatchSize, count));
+                }
+            };
+            std::vector<std::thread> pool;
+            workers = std::min<unsigned>(workers, static_cast<unsigned>(count / kParallelBatchSize));
+            for (unsigned t = 1; t < workers; ++t) {
+                pool.emplace_back(worker);
+            }
+            worker();
+            for (auto &thread : pool) {
+                thread.join();
+            }
+        }
+
+        std::vector<std::unique_ptr<monadcount_sim::models::Feature>> features;
+        features.reserve(count);
+        for (auto &result : decoded) {
+            if (result.feature) {
+                features.push_back(std::move(result.feature));
+            } else {
+                ++report.errorCount;
+                std::cerr << "Error parsing feature: " << result.error << std::endl;
+            }
+        }
+        return features;
+    }
+
+    enum class CoordinatesState { Missing, Null, Array, Invalid };
+
+    // A string property that may be absent; assign() reuses the buffer so steady-state parsing does not allocate.
+    struct PendingString {
+        std::string value;
+        bool present = false;
+
+        void assign(const std::string &text) {
+            value.assign(text);
+            present = true;
+        }
+
+        void reset() { present = false; }
+
+        explicit operator bool() const { return present; }
+
+        const std::string &operator*() const { return value; }
+    };
+
+    // Everything collected for the feature currently being read; keys may arrive in any order. Polygon
+    // coordinates are kept flat (points plus ring spans) and the buffers are reused from feature to feature.
+    struct PendingFeature {
+        bool hasProperties = false;
+        bool hasGeometry = false;
+        PendingString id;
+        PendingString experimentId;
+        PendingString category;
+        PendingString geometryType;
+
+        CoordinatesState coordinates = CoordinatesState::Missing;
+        // Point interpretation: the leading elements of the coordinates array.
+        std::size_t pointElements = 0;
+        bool pointValid = true;
+        double point[2] = {0.0, 0.0};
+        // Polygon interpretation: rings of [x, y, ...] positions.
+        bool polygonValid = true;
+        std::vector<monadcount_sim::models::Point> points;
+        std::vector<monadcount_sim::models::RingSpan> rings;
+        std::size_t positionElements = 0;
+        bool positionValid = true;
+        double position[2] = {0.0, 0.0};
+
+        void reset() {
+            hasProperties = false;
+            hasGeometry = false;
+            id.reset();
+            experimentId.reset();
+            category.reset();
+            geometryType.reset();
+            coordinates = CoordinatesState::Missing;
+            pointElements = 0;
+            pointValid = true;
+            polygonValid = true;
+            points.clear();
+            rings.clear();
+        }
+
+        void invalidateCoordinates() {
+            coordinates = CoordinatesState::Invalid;
+        }
+
+        // An element at the given depth inside "coordinates" that is an array (nested) or not a number.
+        void coordinateElement(int depth, bool isArray) {
+            if (depth == 1) {
+                if (pointElements < 2) pointValid = false;
+                ++pointElements;
+                if (isArray) rings.push_back({static_cast<uint32_t>(points.size()), 0});
+                else polygonValid = false;
+            } else if (depth == 2) {
+                if (isArray) {
+                    positionElements = 0;
+                    positionValid = true;
+                } else {
+                    polygonValid = false;
+                }
+            } else {
+                // Only x and y are read; trailing members such as altitude may be anything.
+                if (positionElements < 2) positionValid = false;
+                ++positionElements;
+            }
+        }
+
+        void coordinateNumber(int depth, double value) {
+            if (depth == 1) {
+                if (pointElements < 2) point[pointElements] = value;
+                ++pointElements;
+                polygonValid = false;
+            } else if (depth == 2) {
+                polygonValid = false;
+            } else {
+                if (positionElements < 2) position[positionElements] = value;
+                ++positionElements;
+            }
+        }
+
+        void closePosition() {
+            if (positionValid && positionElements >= 2 && !rings.empty()) {
+                points.emplace_back(position[0], position[1]);
+                ++rings.back().count;
+            } else {
+                polygonValid = false;
+            }
+        }
+    };
+
+    enum class GeometryKind { Point, Polygon };
+
+    // Output that materialises heap-allocated models::Feature objects and hands them to a sink.
+    class FeatureOutput {
+    public:
+        explicit FeatureOutput(const monadcount_sim::core::GeoJSONParser::FeatureSink &sink) : sink(sink) {}
+
+        void add(const PendingFeature &feature, monadcount_sim::models::Category cat, GeometryKind kind) {
+            std::unique_ptr<monadcount_sim::models::Geometry> geometry;
+            if (kind == GeometryKind::Point) {
+                geometry = std::make_unique<monadcount_sim::models::PointGeometry>(feature.point[0], feature.point[1]);
+            } else {
+                auto polyGeom = std::make_unique<monadcount_sim::models::PolygonGeometry>();
+                polyGeom->rings.reserve(feature.rings.size());
+                for (const auto &ring : feature.rings) {
+                    auto first = feature.points.begin() + ring.offset;
+                    polyGeom->rings.emplace_back(first, first + ring.count);
+                }
+                geometry = std::move(polyGeom);
+            }
+            sink(std::make_unique<monadcount_sim::models::Feature>(*feature.id, *feature.experimentId, cat,
+                                                                   std::move(geometry)));
+        }
+
+    private:
+        const monadcount_sim::core::GeoJSONParser::FeatureSink &sink;
+    };
+
+    // Output that appends straight into a FeatureStore arena.
+    class StoreOutput {
+    public:
+        explicit StoreOutput(monadcount_sim::models::FeatureStore &store) : store(store) {}
+
+        void add(const PendingFeature &feature, monadcount_sim::models::Category cat, GeometryKind kind) {
+            if (kind == GeometryKind::Point) {
+                store.addPoint(*feature.id, *feature.experimentId, cat, feature.point[0], feature.point[1]);
+            } else {
+                store.addPolygon(*feature.id, *feature.experimentId, cat, feature.points, feature.rings);
+            }
+        }
+
+    private:
+        monadcount_sim::models::FeatureStore &store;
+    };
+
+    // SAX handler that assembles one feature at a time from the token stream and forwards it to an output.
+    // It accepts exactly what the DOM path in parseFile accepts and reports per-feature errors the same way.
+    template<typename Output>
+    class GeoJsonSaxHandler : public nlohmann::json_sax<json> {
+    public:
+        GeoJsonSaxHandler(Output &output, monadcount_sim::core::ParseReport &report)
+                : output(output), report(report) {}
+
+        // Called once the whole document has been consumed.
+        void finish() const {
+            if (!collectionType || *collectionType != "FeatureCollection") {
+                throw std::runtime_error("Invalid GeoJSON: Not a FeatureCollection");
+            }
+        }
+
+        bool null() override {
+            return scalar(Value::Null);
+        }
+
+        bool boolean(bool) override {
+            // get<double>() in the DOM path rejects booleans, so they are never coordinates.
+            return scalar(Value::Other);
+        }
+
+        bool number_integer(number_integer_t val) override {
+            return number(static_cast<double>(val));
+        }
+
+        bool number_unsigned(number_unsigned_t val) override {
+            return number(static_cast<double>(val));
+        }
+
+        bool number_float(number_float_t val, const string_t &) override {
+            return number(val);
+        }
+
+        bool string(string_t &val) override {
+            switch (top()) {
+                case Scope::Collection:
+                    if (field == Field::Type) {
+                        collectionType = val;
+                        if (val != "FeatureCollection") {
+                            throw std::runtime_error("Invalid GeoJSON: Not a FeatureCollection");
+                        }
+                    }
+                    return true;
+                case Scope::Properties:
+                    if (field == Field::Id) current.id.assign(val);
+                    else if (field == Field::ExperimentId) current.experimentId.assign(val);
+                    else if (field == Field::Category) current.category.assign(val);
+                    return true;
+                case Scope::Geometry:
+                    if (field == Field::Type) current.geometryType.assign(val);
+                    else if (field == Field::Coordinates) current.invalidateCoordinates();
+                    return true;
+                default:
+                    return scalar(Value::Other);
+            }
+        }
+
+        bool binary(binary_t &) override {
+            return scalar(Value::Other);
+        }
+
+        bool start_object(std::size_t) override {
+            if (scopes.empty()) {
+                scopes.push_back(Scope::Collection);
+                return true;
+            }
+            switch (top()) {
+                case Scope::Features:
+                    current.reset();
+                    scopes.push_back(Scope::Feature);
+                    return true;
+                case Scope::Feature:
+                    if (field == Field::Properties) {
+                        current.hasProperties = true;
+                        scopes.push_back(Scope::Properties);
+                        return true;
+                    }
+                    if (field == Field::Geometry) {
+                        current.hasGeometry = true;
+                        scopes.push_back(Scope::Geometry);
+                        return true;
+                    }
+                    break;
+                case Scope::Properties:
+                    invalidateProperty();
+                    break;
+                case Scope::Geometry:
+                    if (field == Field::Type) current.geometryType.reset();
+                    else if (field == Field::Coordinates) current.invalidateCoordinates();
+                    break;
+                case Scope::Coordinates:
+                    current.coordinateElement(coordinateDepth, false);
+                    break;
+                default:
+                    break;
+            }
+            scopes.push_back(Scope::Skip);
+            return true;
+        }
+
+        bool key(string_t &val) override {
+            field = Field::None;
+            switch (top()) {
+                case Scope::Collection:
+                    if (val == "type") field = Field::Type;
+                    else if (val == "features") field = Field::Features;
+                    break;
+                case Scope::Feature:
+                    if (val == "properties") field = Field::Properties;
+                    else if (val == "geometry") field = Field::Geometry;
+                    break;
+                case Scope::Properties:
+                    if (val == "id") field = Field::Id;
+                    else if (val == "experiment_id") field = Field::ExperimentId;
+                    else if (val == "category") field = Field::Category;
+                    break;
+                case Scope::Geometry:
+                    if (val == "type") field = Field::Type;
+                    else if (val == "coordinates") field = Field::Coordinates;
+                    break;
+                default:
+                    break;
+            }
+            return true;
+        }
+
+        bool end_object() override {
+            Scope closed = pop();
+            if (closed == Scope::Feature) {
+                emitFeature();
+            }
+            return true;
+        }
+
+        bool start_array(std::size_t) override {
+            if (scopes.empty()) {
+                // A bare array is not a FeatureCollection; finish() reports it.
+                scopes.push_back(Scope::Skip);
+                return true;
+            }
+            switch (top()) {
+                case Scope::Collection:
+                    if (field == Field::Features) {
+                        scopes.push_back(Scope::Features);
+                        return true;
+                    }
+                    break;
+                case Scope::Features:
+                    reportError("Feature is not an object");
+                    break;
+                case Scope::Feature:
+                    if (field == Field::Properties) current.hasProperties = false;
+                    else if (field == Field::Geometry) current.hasGeometry = false;
+                    break;
+                case Scope::Properties:
+                    invalidateProperty();
+                    break;
+                case Scope::Geometry:
+                    if (field == Field::Coordinates) {
+                        current.coordinates = CoordinatesState::Array;
+                        coordinateDepth = 1;
+                        scopes.push_back(Scope::Coordinates);
+                        return true;
+                    }
+                    if (field == Field::Type) current.geometryType.reset();
+                    break;
+                case Scope::Coordinates:
+                    if (coordinateDepth < 3) {
+                        current.coordinateElement(coordinateDepth, true);
+                        ++coordinateDepth;
+                        scopes.push_back(Scope::Coordinates);
+                        return true;
+                    }
+                    current.coordinateElement(coordinateDepth, false);
+                    break;
+                default:
+                    break;
+            }
+            scopes.push_back(Scope::Skip);
+            return true;
+        }
+
+        bool end_array() override {
+            Scope closed = pop();
+            if (closed == Scope::Coordinates) {
+                if (coordinateDepth == 3) current.closePosition();
+                --coordinateDepth;
+            }
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &ex) override {
+            throw std::runtime_error(std::string("Invalid GeoJSON: ") + ex.what());
+        }
+
+    private:
+        enum class Scope { Collection, Features, Feature, Properties, Geometry, Coordinates, Skip };
+        enum class Field { None, Type, Features, Properties, Geometry, Coordinates, Id, ExperimentId, Category };
+        enum class Value { Null, Number, Other };
+
+        Output &output;
+        monadcount_sim::core::ParseReport &report;
+
+        std::vector<Scope> scopes;
+        Field field = Field::None;
+        int coordinateDepth = 0;
+        std::optional<std::string> collectionType;
+        PendingFeature current;
+
+        Scope top() const {
+            return scopes.empty() ? Scope::Skip : scopes.back();
+        }
+
+        Scope pop() {
+            Scope closed = scopes.back();
+            scopes.pop_back();
+            field = Field::None;
+            return closed;
+        }
+
+        void invalidateProperty() {
+            if (field == Field::Id) current.id.reset();
+            else if (field == Field::ExperimentId) current.experimentId.reset();
+            else if (field == Field::Category) current.category.reset();
+        }
+
+        bool number(double value) {
+            if (top() == Scope::Coordinates) {
+                current.coordinateNumber(coordinateDepth, value);
+                return true;
+            }
+            return scalar(Value::Number);
+        }
+
+        bool scalar(Value value) {
+            switch (top()) {
+                case Scope::Collection:
+                    if (field == Field::Type) {
+                        throw std::runtime_error("Invalid GeoJSON: Not a FeatureCollection");
+                    }
+                    break;
+                case Scope::Features:
+                    reportError("Feature is not an object");
+                    break;
+                case Scope::Feature:
+                    if (field == Field::Properties) current.hasProperties = false;
+                    else if (field == Field::Geometry) current.hasGeometry = false;
+                    break;
+                case Scope::Properties:
+                    invalidateProperty();
+                    break;
+                case Scope::Geometry:
+                    if (field == Field::Type) {
+                        current.geometryType.reset();
+                    } else if (field == Field::Coordinates) {
+                        // Iterating a null value yields nothing; any other scalar is a malformed ring.
+                        current.coordinates = value == Value::Null ? CoordinatesState::Null : CoordinatesState::Invalid;
+                    }
+                    break;
+                case Scope::Coordinates:
+                    current.coordinateElement(coordinateDepth, false);
+                    break;
+                default:
+                    break;
+            }
+            return true;
+        }
+
+        static const std::string &require(const PendingString &value, const char *name) {
+            if (!value) {
+                throw std::runtime_error(std::string("Missing or non-string property: ") + name);
+            }
+            return *value;
+        }
+
+        GeometryKind validate(monadcount_sim::models::Category &cat) const {
+            if (!current.hasProperties) throw std::runtime_error("Feature has no properties object");
+            require(current.id, "id");
+            require(current.experimentId, "experiment_id");
+            cat = monadcount_sim::models::Category::fromString(require(current.category, "category"));
+
+            if (!current.hasGeometry) throw std::runtime_error("Feature has no geometry object");
+            const std::string &geomType = require(current.geometryType, "geometry.type");
+
+            if (geomType == "Point") {
+                if (current.coordinates != CoordinatesState::Array || current.pointElements < 2)
+                    throw std::runtime_error("Invalid Point coordinates");
+                if (!current.pointValid)
+                    throw std::runtime_error("Invalid Point coordinate value");
+                return GeometryKind::Point;
+            }
+            if (geomType == "Polygon") {
+                if (current.coordinates == CoordinatesState::Missing ||
+                    current.coordinates == CoordinatesState::Invalid || !current.polygonValid)
+                    throw std::runtime_error("Invalid polygon point");
+                return GeometryKind::Polygon;
+            }
+            throw std::runtime_error("Unsupported geometry type: " + geomType);
+        }
+
+        void emitFeature() {
+            monadcount_sim::models::Category cat(monadcount_sim::models::Category::UNKNOWN);
+            GeometryKind kind;
+            try {
+                kind = validate(cat);
+            } catch (const std::exception &ex) {
+                reportError(ex.what());
+                return;
+            }
+            ++report.featureCount;
+            output.add(current, cat, kind);
+        }
+
+        void reportError(const std::string &what) {
+            ++report.errorCount;
+            std::cerr << "Error parsing feature: " << what << std::endl;
+        }
+    };
+}
 
 
 std::vector<std::unique_ptr<monadcount_sim::models::Feature>> monadcount_sim::core::GeoJSONParser::parseFile(const std::string &filePath) {
+    auto start = std::chrono::steady_clock::now();
+    report = ParseReport{};
+
     std::ifstream file(filePath);
     if (!file) {
         throw std::runtime_error("Could not open file: " + filePath);
@@ -22,50 +621,84 @@ std::vector<std::unique_ptr<monadcount_sim::models::Feature>> monadcount_sim::co
         throw std::runtime_error("Invalid GeoJSON: Not a FeatureCollection");
     }
 
-    std::vector<std::unique_ptr<monadcount_sim::models::Feature>> features;
+    std::vector<const json *> items;
     for (const auto &featureJson : j["features"]) {
-        try {
-            // Extract common properties.
-            std::string id = featureJson["properties"]["id"].get<std::string>();
-            std::string experiment_id = featureJson["properties"]["experiment_id"].get<std::string>();
-            std::string catStr = featureJson["properties"]["category"].get<std::string>();
-            monadcount_sim::models::Category cat = monadcount_sim::models::Category::fromString(catStr);
-
-            // Parse geometry.
-            std::string geomType = featureJson["geometry"]["type"].get<std::string>();
-            std::unique_ptr<monadcount_sim::models::Geometry> geometry;
+        items.push_back(&featureJson);
+    }
+    auto features = decodeAll(items.size(), threads, report, [&items](std::size_t i) {
+        return decodeFeature(*items[i]);
+    });
 
-            if (geomType == "Point") {
-                const auto &coords = featureJson["geometry"]["coordinates"];
-                if (!coords.is_array() || coords.size() < 2)
-                    throw std::runtime_error("Invalid Point coordinates");
-                double x = coords[0].get<double>();
-                double y = coords[1].get<double>();
-                geometry = std::make_unique<monadcount_sim::models::PointGeometry>(x, y);
-            } else if (geomType == "Polygon") {
-                const auto &coords = featureJson["geometry"]["coordinates"];
-                auto polyGeom = std::make_unique<monadcount_sim::models::PolygonGeometry>();
-                for (const auto &ring : coords) {
-                    std::vector<monadcount_sim::models::Point> loop;
-                    for (const auto &pt : ring) {
-                        if (!pt.is_array() || pt.size() < 2)
-                            throw std::runtime_error("Invalid polygon point");
-                        double x = pt[0].get<double>();
-                        double y = pt[1].get<double>();
-                        loop.push_back(monadcount_sim::models::Point(x, y));
-                    }
-                    polyGeom->rings.push_back(loop);
-                }
-                geometry = std::move(polyGeom);
-            } else {
-                throw std::runtime_error("Unsupported geometry type: " + geomType);
-            }
+    report.featureCount = features.size();
+    report.elapsedSeconds = secondsSince(start);
+    report.peakRssKb = PeakRssKb();
+    return features;
+}
+
+std::vector<std::unique_ptr<monadcount_sim::models::Feature>> monadcount_sim::core::GeoJSONParser::parseRanges(const std::string &filePath, std::span<const ByteRange> ranges) {
+    auto start = std::chrono::steady_clock::now();
+    report = ParseReport{};
 
-            features.push_back(std::make_unique<monadcount_sim::models::Feature>(id, experiment_id, cat, std::move(geometry)));
-        } catch (const std::exception &ex) {
-            std::cerr << "Error parsing feature: " << ex.what() << std::endl;
+    auto file = MappedFile::Open(filePath);
+    if (!file) {
+        throw std::runtime_error("Could not open file: " + filePath);
+    }
+    for (const ByteRange &range : ranges) {
+        if (range.begin > range.end || range.end > file->GetSize()) {
+            throw std::runtime_error("Feature range outside of " + filePath + "; rebuild the experiment index");
         }
     }
 
+    // Only the requested bytes are touched; each range holds exactly one feature object.
+    const char *data = file->GetData();
+    auto features = decodeAll(ranges.size(), threads, report, [data, &ranges](std::size_t i) {
+        return decodeFeature(json::parse(data + ranges[i].begin, data + ranges[i].end));
+    });
+
+    report.featureCount = features.size();
+    report.elapsedSeconds = secondsSince(start);
+    report.peakRssKb = PeakRssKb();
     return features;
 }
+
+void monadcount_sim::core::GeoJSONParser::parseStream(const std::string &filePath, const FeatureSink &sink) {
+    auto start = std::chrono::steady_clock::now();
+    report = ParseReport{};
+
+    std::vector<char> buffer(kStreamBufferSize);
+    std::ifstream file;
+    file.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    file.open(filePath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open file: " + filePath);
+    }
+
+    FeatureOutput output(sink);
+    GeoJsonSaxHandler<FeatureOutput> handler(output, report);
+    nlohmann::json::sax_parse(file, &handler);
+    handler.finish();
+
+    report.elapsedSeconds = secondsSince(start);
+    report.peakRssKb = PeakRssKb();
+}
+
+void monadcount_sim::core::GeoJSONParser::parseToStore(const std::string &filePath, monadcount_sim::models::FeatureStore &store) {
+    auto start = std::chrono::steady_clock::now();
+    report = ParseReport{};
+
+    std::vector<char> buffer(kStreamBufferSize);
+    std::ifstream file;
+    file.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    file.open(filePath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open file: " + filePath);
+    }
+
+    StoreOutput output(store);
+    GeoJsonSaxHandler<StoreOutput> handler(output, report);
+    nlohmann::json::sax_parse(file, &handler);
+    handler.finish();
+
+    report.elapsedSeconds = secondsSince(start);
+    report.peakRssKb = PeakRssKb();
+}
@@ -0,0 +1,29 @@
+#include <monadcount_sim/core/MappedFile.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unique_ptr<monadcount_sim::core::MappedFile> monadcount_sim::core::MappedFile::Open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::unique_ptr<MappedFile>(new MappedFile(data, size));
+}
+
+monadcount_sim::core::MappedFile::~MappedFile() {
+    ::munmap(m_data, m_size);
+}
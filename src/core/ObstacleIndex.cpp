@@ -0,0 +1,292 @@
+#include <monadcount_sim/core/ObstacleIndex.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    // Average number of segments per cell over the grid's area; about one measured fastest on building
+    // layouts (fewer edge tests outweigh the extra cell steps).
+    constexpr double kSegmentsPerCell = 1.0;
+
+    // Edges tested per step of the intersection kernel, one per SIMD lane; every cell's entries are padded
+    // to a multiple. Four doubles need AVX, two fit the SSE2/NEON registers every 64-bit target has.
+#if defined(__AVX__)
+    constexpr uint32_t kLanes = 4;
+#else
+    constexpr uint32_t kLanes = 2;
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    // GCC/Clang vector extensions: each arithmetic operation or comparison covers kLanes packed edges.
+    typedef double Lanes __attribute__((vector_size(kLanes * sizeof(double))));
+    typedef int64_t LaneMask __attribute__((vector_size(kLanes * sizeof(int64_t))));
+
+    inline Lanes loadLanes(const double *values) {
+        Lanes lanes;
+        std::memcpy(&lanes, values, sizeof(lanes));
+        return lanes;
+    }
+
+    inline bool anyLane(LaneMask mask) {
+        int64_t any = 0;
+        for (uint32_t lane = 0; lane < kLanes; ++lane) {
+            any |= mask[lane];
+        }
+        return any != 0;
+    }
+#endif
+
+    // Upper bound on the grid size, so a few far-away outliers cannot blow up memory.
+    constexpr double kMaxCells = double(1 << 22);
+
+    // Obstacles already counted by the current query. Links rarely cross more than a few dozen obstacles,
+    // so the common case stays on the stack.
+    class CrossedSet {
+    public:
+        bool insert(uint32_t obstacle) {
+            for (uint32_t i = 0; i < inlineCount; ++i) {
+                if (inlineIds[i] == obstacle) return false;
+            }
+            if (std::find(overflow.begin(), overflow.end(), obstacle) != overflow.end()) {
+                return false;
+            }
+            if (inlineCount < inlineIds.size()) {
+                inlineIds[inlineCount++] = obstacle;
+            } else {
+                overflow.push_back(obstacle);
+            }
+            return true;
+        }
+
+    private:
+        std::array<uint32_t, 64> inlineIds;
+        uint32_t inlineCount = 0;
+        std::vector<uint32_t> overflow;
+    };
+}
+
+monadcount_sim::core::ObstacleIndex::ObstacleIndex() {
+    // Typical indoor values: an interior brick/plasterboard wall, and a wooden table in the path.
+    m_attenuationDb[static_cast<std::size_t>(Material::WALL)] = 5.0;
+    m_attenuationDb[static_cast<std::size_t>(Material::TABLE)] = 1.5;
+}
+
+uint32_t monadcount_sim::core::ObstacleIndex::AddPolygon(uint32_t obstacle, Material material, const models::PolygonView &polygon) {
+    auto first = static_cast<uint32_t>(m_segments.size());
+    auto addEdge = [&](const models::Point &a, const models::Point &b) {
+        if (a.x != b.x || a.y != b.y) {
+            m_segments.push_back({a.x, a.y, b.x, b.y, obstacle, material});
+        }
+    };
+    for (std::size_t r = 0; r < polygon.rings.size(); ++r) {
+        auto ring = polygon.ring(r);
+        for (std::size_t i = 1; i < ring.size(); ++i) {
+            addEdge(ring[i - 1], ring[i]);
+        }
+        // GeoJSON rings repeat the first point; close the ones that do not.
+        if (ring.size() > 2) {
+            addEdge(ring.back(), ring.front());
+        }
+    }
+    m_built = false;
+    return first;
+}
+
+void monadcount_sim::core::ObstacleIndex::SetAttenuation(Material material, double attenuationDb) {
+    m_attenuationDb[static_cast<std::size_t>(material)] = attenuationDb;
+}
+
+double monadcount_sim::core::ObstacleIndex::GetAttenuation(Material material) const {
+    return m_attenuationDb[static_cast<std::size_t>(material)];
+}
+
+void monadcount_sim::core::ObstacleIndex::Build() {
+    m_built = false;
+    m_cellStart.clear();
+    if (m_segments.empty()) {
+        return;
+    }
+
+    double maxX = -std::numeric_limits<double>::infinity();
+    double maxY = -std::numeric_limits<double>::infinity();
+    m_minX = m_minY = std::numeric_limits<double>::infinity();
+    for (const ObstacleSegment &seg : m_segments) {
+        m_minX = std::min({m_minX, seg.x0, seg.x1});
+        m_minY = std::min({m_minY, seg.y0, seg.y1});
+        maxX = std::max({maxX, seg.x0, seg.x1});
+        maxY = std::max({maxY, seg.y0, seg.y1});
+    }
+
+    // Square cells sized for a few segments each; degenerate (zero-width) extents still get a usable size.
+    double extent = std::max({maxX - m_minX, maxY - m_minY, 1e-6});
+    double width = std::max(maxX - m_minX, extent * 1e-3);
+    double height = std::max(maxY - m_minY, extent * 1e-3);
+    m_cellSize = std::sqrt(width * height * kSegmentsPerCell / static_cast<double>(m_segments.size()));
+    m_cellSize = std::max(m_cellSize, std::sqrt(width * height / kMaxCells));
+    m_invCellSize = 1.0 / m_cellSize;
+    m_cellsX = static_cast<int32_t>(width * m_invCellSize) + 1;
+    m_cellsY = static_cast<int32_t>(height * m_invCellSize) + 1;
+
+    // Cells covered by a segment's bounding box, widened slightly so a link passing exactly through a cell
+    // corner still meets edges that end there.
+    const double pad = m_cellSize * 1e-9;
+    auto forEachCell = [&](const ObstacleSegment &seg, auto &&fn) {
+        auto cellX = [&](double x) { return std::clamp(static_cast<int32_t>((x - m_minX) * m_invCellSize), 0, m_cellsX - 1); };
+        auto cellY = [&](double y) { return std::clamp(static_cast<int32_t>((y - m_minY) * m_invCellSize), 0, m_cellsY - 1); };
+        int32_t x0 = cellX(std::min(seg.x0, seg.x1) - pad), x1 = cellX(std::max(seg.x0, seg.x1) + pad);
+        int32_t y0 = cellY(std::min(seg.y0, seg.y1) - pad), y1 = cellY(std::max(seg.y0, seg.y1) + pad);
+        for (int32_t y = y0; y <= y1; ++y) {
+            for (int32_t x = x0; x <= x1; ++x) {
+                fn(static_cast<std::size_t>(y) * m_cellsX + x);
+            }
+        }
+    };
+
+    // Counting sort into compressed rows: count per cell, pad to whole lanes, prefix sum, then fill. Padding
+    // entries are zero-length edges, which the kernel rejects as parallel to every link.
+    std::size_t cellCount = static_cast<std::size_t>(m_cellsX) * m_cellsY;
+    m_cellStart.assign(cellCount + 1, 0);
+    for (const ObstacleSegment &seg : m_segments) {
+        forEachCell(seg, [&](std::size_t cell) { ++m_cellStart[cell + 1]; });
+    }
+    for (std::size_t c = 0; c < cellCount; ++c) {
+        uint32_t padded = (m_cellStart[c + 1] + kLanes - 1) / kLanes * kLanes;
+        m_cellStart[c + 1] = m_cellStart[c] + padded;
+    }
+    std::size_t entries = m_cellStart[cellCount];
+    m_cellX0.assign(entries, 0.0);
+    m_cellY0.assign(entries, 0.0);
+    m_cellDx.assign(entries, 0.0);
+    m_cellDy.assign(entries, 0.0);
+    m_cellObstacle.assign(entries, 0);
+    m_cellMaterial.assign(entries, Material::WALL);
+    std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (const ObstacleSegment &seg : m_segments) {
+        forEachCell(seg, [&](std::size_t cell) {
+            uint32_t i = fill[cell]++;
+            m_cellX0[i] = seg.x0;
+            m_cellY0[i] = seg.y0;
+            m_cellDx[i] = seg.x1 - seg.x0;
+            m_cellDy[i] = seg.y1 - seg.y0;
+            m_cellObstacle[i] = seg.obstacle;
+            m_cellMaterial[i] = seg.material;
+        });
+    }
+    m_built = true;
+}
+
+monadcount_sim::core::WallCrossings monadcount_sim::core::ObstacleIndex::Query(double ax, double ay, double bx, double by) const {
+    WallCrossings result;
+    if (!m_built) {
+        return result;
+    }
+
+    const double dx = bx - ax;
+    const double dy = by - ay;
+
+    // Clip the link to the grid bounds; t0..t1 is the part inside.
+    double t0 = 0.0;
+    double t1 = 1.0;
+    auto clip = [&t0, &t1](double origin, double delta, double lo, double hi) {
+        if (delta == 0.0) {
+            return origin >= lo && origin <= hi;
+        }
+        double ta = (lo - origin) / delta;
+        double tb = (hi - origin) / delta;
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+        return t0 <= t1;
+    };
+    if (!clip(ax, dx, m_minX, m_minX + m_cellsX * m_cellSize) ||
+        !clip(ay, dy, m_minY, m_minY + m_cellsY * m_cellSize)) {
+        return result;
+    }
+
+    auto cellX = [this](double x) { return std::clamp(static_cast<int32_t>((x - m_minX) * m_invCellSize), 0, m_cellsX - 1); };
+    auto cellY = [this](double y) { return std::clamp(static_cast<int32_t>((y - m_minY) * m_invCellSize), 0, m_cellsY - 1); };
+    int32_t cx = cellX(ax + t0 * dx);
+    int32_t cy = cellY(ay + t0 * dy);
+    const int32_t endX = cellX(ax + t1 * dx);
+    const int32_t endY = cellY(ay + t1 * dy);
+
+    // Amanatides-Woo traversal: tMax* is the link parameter at the next cell boundary on each axis.
+    const int32_t stepX = dx > 0.0 ? 1 : -1;
+    const int32_t stepY = dy > 0.0 ? 1 : -1;
+    const double inf = std::numeric_limits<double>::infinity();
+    const double tDeltaX = dx != 0.0 ? m_cellSize / std::abs(dx) : inf;
+    const double tDeltaY = dy != 0.0 ? m_cellSize / std::abs(dy) : inf;
+    double tMaxX = dx != 0.0 ? (m_minX + (cx + (stepX > 0)) * m_cellSize - ax) / dx : inf;
+    double tMaxY = dy != 0.0 ? (m_minY + (cy + (stepY > 0)) * m_cellSize - ay) / dy : inf;
+
+    CrossedSet crossed;
+    for (;;) {
+        std::size_t cell = static_cast<std::size_t>(cy) * m_cellsX + cx;
+        auto count = [&](uint32_t i) {
+            if (crossed.insert(m_cellObstacle[i])) {
+                ++result.count;
+                result.attenuationDb += m_attenuationDb[static_cast<std::size_t>(m_cellMaterial[i])];
+            }
+        };
+#if defined(__GNUC__) || defined(__clang__)
+        for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i += kLanes) {
+            // Parametric intersection without division: t along A->B, u along the edge, both in [0, denom]
+            // (or [denom, 0] when denom is negative). denom == 0 means parallel, and grazing along an edge
+            // is not a crossing; it also rejects the zero-length padding entries.
+            Lanes sx = loadLanes(&m_cellDx[i]);
+            Lanes sy = loadLanes(&m_cellDy[i]);
+            Lanes qx = loadLanes(&m_cellX0[i]) - ax;
+            Lanes qy = loadLanes(&m_cellY0[i]) - ay;
+            Lanes denom = dx * sy - dy * sx;
+            Lanes t = qx * sy - qy * sx;
+            Lanes u = qx * dy - qy * dx;
+            LaneMask hit = ((denom > 0.0) & (t >= 0.0) & (t <= denom) & (u >= 0.0) & (u <= denom)) |
+                           ((denom < 0.0) & (t <= 0.0) & (t >= denom) & (u <= 0.0) & (u >= denom));
+            if (!anyLane(hit)) {
+                continue;
+            }
+            for (uint32_t lane = 0; lane < kLanes; ++lane) {
+                if (hit[lane]) {
+                    count(i + lane);
+                }
+            }
+        }
+#else
+        for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+            double sx = m_cellDx[i];
+            double sy = m_cellDy[i];
+            double denom = dx * sy - dy * sx;
+            if (denom == 0.0) {
+                continue;
+            }
+            double qx = m_cellX0[i] - ax;
+            double qy = m_cellY0[i] - ay;
+            double t = qx * sy - qy * sx;
+            double u = qx * dy - qy * dx;
+            if (denom < 0.0) {
+                denom = -denom;
+                t = -t;
+                u = -u;
+            }
+            if (t >= 0.0 && t <= denom && u >= 0.0 && u <= denom) {
+                count(i);
+            }
+        }
+#endif
+
+        if ((cx == endX && cy == endY) || (tMaxX > t1 && tMaxY > t1)) {
+            break;
+        }
+        if (tMaxX < tMaxY) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+            if (cx < 0 || cx >= m_cellsX) break;
+        } else {
+            cy += stepY;
+            tMaxY += tDeltaY;
+            if (cy < 0 || cy >= m_cellsY) break;
+        }
+    }
+    return result;
+}
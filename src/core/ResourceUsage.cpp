@@ -0,0 +1,35 @@
+#include <monadcount_sim/core/ResourceUsage.hpp>
+
+#include <fstream>
+#include <string>
+
+#include <sys/resource.h>
+
+long monadcount_sim::core::PeakRssKb() {
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    // macOS reports ru_maxrss in bytes, Linux in kilobytes.
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+long monadcount_sim::core::PrivateMemoryKb() {
+    std::ifstream in("/proc/self/smaps_rollup");
+    long total = 0;
+    std::string key;
+    long value;
+    std::string unit;
+    while (in >> key) {
+        if (key == "Private_Clean:" || key == "Private_Dirty:") {
+            if (in >> value >> unit) {
+                total += value;
+            }
+        }
+    }
+    return total;
+}
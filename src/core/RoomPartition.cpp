@@ -0,0 +1,80 @@
+#include <monadcount_sim/core/RoomPartition.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+monadcount_sim::core::Room monadcount_sim::core::MakeRoom(std::string id, const models::PolygonView &polygon) {
+    Room room;
+    room.id = std::move(id);
+    if (polygon.rings.empty() || polygon.rings[0].count == 0) {
+        return room;
+    }
+
+    auto ring = polygon.ring(0);
+    room.outline.assign(ring.begin(), ring.end());
+    room.minX = room.maxX = ring[0].x;
+    room.minY = room.maxY = ring[0].y;
+    double twiceArea = 0.0;
+    for (std::size_t i = 0; i < ring.size(); ++i) {
+        const models::Point &a = ring[i];
+        const models::Point &b = ring[(i + 1) % ring.size()];
+        room.minX = std::min(room.minX, a.x);
+        room.maxX = std::max(room.maxX, a.x);
+        room.minY = std::min(room.minY, a.y);
+        room.maxY = std::max(room.maxY, a.y);
+        twiceArea += a.x * b.y - b.x * a.y;
+    }
+    room.area = std::abs(twiceArea) / 2.0;
+    return room;
+}
+
+bool monadcount_sim::core::RoomContains(const Room &room, double x, double y) {
+    if (room.outline.size() < 3 || x < room.minX || x > room.maxX || y < room.minY || y > room.maxY) {
+        return false;
+    }
+    // Even-odd ray cast towards +x.
+    bool inside = false;
+    for (std::size_t i = 0, j = room.outline.size() - 1; i < room.outline.size(); j = i++) {
+        const models::Point &a = room.outline[i];
+        const models::Point &b = room.outline[j];
+        if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+std::size_t monadcount_sim::core::FindRoom(const std::vector<Room> &rooms, double x, double y) {
+    for (std::size_t i = 0; i < rooms.size(); ++i) {
+        if (RoomContains(rooms[i], x, y)) {
+            return i;
+        }
+    }
+    return rooms.size();
+}
+
+std::vector<double> monadcount_sim::core::AssignRoomsToRanks(std::vector<Room> &rooms, uint32_t ranks,
+                                                             const std::vector<uint32_t> &nodesPerRoom,
+                                                             double nodeWeight) {
+    if (ranks == 0) {
+        throw std::invalid_argument("Rooms must be spread over at least one rank");
+    }
+    std::vector<double> weights(rooms.size());
+    for (std::size_t i = 0; i < rooms.size(); ++i) {
+        weights[i] = rooms[i].area + nodeWeight * (i < nodesPerRoom.size() ? nodesPerRoom[i] : 0);
+    }
+    std::vector<std::size_t> order(rooms.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(),
+                     [&weights](std::size_t a, std::size_t b) { return weights[a] > weights[b]; });
+
+    std::vector<double> loads(ranks, 0.0);
+    for (std::size_t room : order) {
+        auto rank = static_cast<uint32_t>(std::min_element(loads.begin(), loads.end()) - loads.begin());
+        rooms[room].rank = rank;
+        loads[rank] += weights[room];
+    }
+    return loads;
+}
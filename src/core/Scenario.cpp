@@ -1,22 +1,383 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "monadcount_sim/core/Scenario.hpp"
+#include "monadcount_sim/core/CompiledScenario.hpp"
+#include "monadcount_sim/core/ExperimentIndex.hpp"
+#include "monadcount_sim/core/MappedFile.hpp"
+#include "monadcount_sim/core/ResourceUsage.hpp"
 #include "monadcount_sim/core/GeoJsonParser.hpp"
 #include "monadcount_sim/core/ScenarioEnvironmentBuilder.hpp"
 
+NS_LOG_COMPONENT_DEFINE ("Scenario");
+
 void monadcount_sim::core::Scenario::Execute(const std::string& scenarioFile) {
+    auto start = std::chrono::steady_clock::now();
+    m_executeStart = start;
     auto env = BuildEnvironment(scenarioFile);
+    auto built = std::chrono::steady_clock::now();
     Run(*env);
+    if (m_replicaPipe >= 0) {
+        FinishReplica();
+    }
+    ReportMetric("build_seconds", std::chrono::duration<double>(built - start).count());
+    ReportMetric("run_seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - built).count());
+    ReportMetric("peak_rss_kb", static_cast<double>(PeakRssKb()));
+    WriteMetrics();
+}
+
+void monadcount_sim::core::Scenario::SetSimulationTime(double) {
+    throw std::invalid_argument("This scenario has no configurable simulation time");
+}
+
+void monadcount_sim::core::Scenario::SetNumPedestrians(uint32_t) {
+    throw std::invalid_argument("This scenario has no configurable pedestrian count");
+}
+
+void monadcount_sim::core::Scenario::ReportMetric(const std::string& name, double value) {
+    m_metrics.emplace_back(name, value);
+}
+
+void monadcount_sim::core::Scenario::WriteMetrics() const {
+    if (m_metricsFile.empty()) {
+        return;
+    }
+    std::ofstream out(m_metricsFile);
+    out.precision(15);
+    for (const auto& [name, value] : m_metrics) {
+        out << name << ',' << value << '\n';
+    }
+    if (!out) {
+        throw std::runtime_error("Could not write metrics file: " + m_metricsFile);
+    }
+}
+
+bool monadcount_sim::core::Scenario::RunSimulation(const std::function<void()>& reseed) {
+    if (!IsReplicating()) {
+        ns3::Simulator::Run();
+        return true;
+    }
+    RunReplicas(reseed);
+    if (m_replicaPipe < 0) {
+        return false;
+    }
+    ns3::Simulator::Run();
+    return true;
+}
+
+void monadcount_sim::core::Scenario::RunReplicas(const std::function<void()>& reseed) {
+    using Clock = std::chrono::steady_clock;
+    const unsigned jobs = m_replicationJobs > 0 ? m_replicationJobs : std::max(1u, std::thread::hardware_concurrency());
+    const double setupSeconds = std::chrono::duration<double>(Clock::now() - m_executeStart).count();
+    const uint64_t baseRun = ns3::RngSeedManager::GetRun();
+    NS_LOG_INFO ("Set-up took " << setupSeconds << " s; forking " << m_replications << " replicas (RngRun "
+                 << baseRun << ".." << baseRun + m_replications - 1 << ") on " << jobs << " workers");
+
+    struct Replica {
+        uint32_t index;
+        int pipe;
+        Clock::time_point start;
+        std::string report;  // metric lines read from the pipe so far
+    };
+    std::map<pid_t, Replica> active;
+    std::vector<std::pair<std::string, std::pair<double, uint32_t>>> sums;  // metric -> sum, count
+    uint32_t next = 0;
+    uint32_t finished = 0;
+    uint32_t failed = 0;
+    long maxRssKb = 0;
+    const auto start = Clock::now();
+
+    while (finished < m_replications) {
+        while (active.size() < jobs && next < m_replications) {
+            int fds[2];
+            if (::pipe(fds) != 0) {
+                throw std::runtime_error(std::string("Could not create a replica pipe: ") + std::strerror(errno));
+            }
+            // Buffered output would otherwise be written once more by every child.
+            std::cout.flush();
+            std::clog.flush();
+            std::fflush(nullptr);
+            pid_t pid = ::fork();
+            if (pid < 0) {
+                throw std::runtime_error(std::string("Could not fork a replica: ") + std::strerror(errno));
+            }
+            if (pid == 0) {
+                ::close(fds[0]);
+                for (const auto& entry : active) {
+                    ::close(entry.second.pipe);
+                }
+                m_replicaPipe = fds[1];
+                ns3::RngSeedManager::SetRun(baseRun + next);
+                reseed();
+                m_replicaStart = Clock::now();
+                return;
+            }
+            ::close(fds[1]);
+            active.emplace(pid, Replica{next, fds[0], Clock::now(), {}});
+            ++next;
+        }
+
+        // Drain every replica's pipe before reaping it: a report larger than the pipe buffer would
+        // otherwise block the replica's write while the parent waits for it to exit.
+        std::vector<struct pollfd> pipes;
+        pipes.reserve(active.size());
+        for (const auto& entry : active) {
+            pipes.push_back({entry.second.pipe, POLLIN, 0});
+        }
+        if (::poll(pipes.data(), pipes.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Waiting for replicas failed: ") + std::strerror(errno));
+        }
+        auto it = active.end();
+        for (const struct pollfd& fd : pipes) {
+            if (fd.revents == 0) {
+                continue;
+            }
+            auto replica = std::find_if(active.begin(), active.end(),
+                                        [&fd](const auto& entry) { return entry.second.pipe == fd.fd; });
+            char buffer[4096];
+            ssize_t got = ::read(fd.fd, buffer, sizeof(buffer));
+            if (got > 0) {
+                replica->second.report.append(buffer, static_cast<std::size_t>(got));
+            } else if (got == 0 || errno != EINTR) {
+                it = replica;  // end of the report: the replica is exiting
+                break;
+            }
+        }
+        if (it == active.end()) {
+            continue;
+        }
+        ::close(it->second.pipe);
+
+        int status = 0;
+        struct rusage usage {};
+        while (::wait4(it->first, &status, 0, &usage) < 0) {
+            if (errno != EINTR) {
+                throw std::runtime_error(std::string("Waiting for replicas failed: ") + std::strerror(errno));
+            }
+        }
+        const std::string& report = it->second.report;
+        ++finished;
+
+        const bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        if (!ok) {
+            ++failed;
+            NS_LOG_WARN ("Replica " << it->second.index << " failed (status " << status << ")");
+        } else {
+            std::istringstream lines(report);
+            std::string line;
+            while (std::getline(lines, line)) {
+                std::size_t comma = line.rfind(',');
+                if (comma == std::string::npos) {
+                    continue;
+                }
+                std::string name = line.substr(0, comma);
+                double value = std::strtod(line.c_str() + comma + 1, nullptr);
+                auto sum = std::find_if(sums.begin(), sums.end(), [&name](const auto& s) { return s.first == name; });
+                if (sum == sums.end()) {
+                    sums.emplace_back(name, std::make_pair(value, 1u));
+                } else {
+                    sum->second.first += value;
+                    ++sum->second.second;
+                }
+            }
+#ifdef __APPLE__
+            maxRssKb = std::max<long>(maxRssKb, usage.ru_maxrss / 1024);
+#else
+            maxRssKb = std::max<long>(maxRssKb, usage.ru_maxrss);
+#endif
+        }
+        active.erase(it);
+    }
+
+    const double wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    auto mean = [&sums](const std::string& name) {
+        for (const auto& [metric, sum] : sums) {
+            if (metric == name) return sum.first / sum.second;
+        }
+        return 0.0;
+    };
+    const double runSeconds = mean("replica_run_seconds");
+    // Estimated, not measured: a cold start would repeat the set-up in every replica.
+    const double coldSeconds = std::ceil(static_cast<double>(m_replications) / jobs) * (setupSeconds + runSeconds);
+    NS_LOG_INFO ((m_replications - failed) << "/" << m_replications << " replicas in " << wallSeconds << " s ("
+                 << m_replications / wallSeconds * 3600.0 << " per hour), mean run " << runSeconds << " s");
+    NS_LOG_INFO ("Replica memory: " << mean("private_kb") << " KiB private on average, peak RSS up to " << maxRssKb
+                 << " KiB (shared copy-on-write pages included)");
+    NS_LOG_INFO ("Cold-start estimate (not measured): about " << coldSeconds << " s on " << jobs << " workers ("
+                 << m_replications << " x (" << setupSeconds << " s set-up + " << runSeconds << " s mean run))");
+
+    ReportMetric("replications", m_replications);
+    ReportMetric("failed_replications", failed);
+    ReportMetric("setup_seconds", setupSeconds);
+    ReportMetric("replication_seconds", wallSeconds);
+    ReportMetric("replications_per_hour", m_replications / wallSeconds * 3600.0);
+    ReportMetric("cold_start_estimate_seconds", coldSeconds);
+    ReportMetric("max_replica_rss_kb", static_cast<double>(maxRssKb));
+    for (const auto& [name, sum] : sums) {
+        ReportMetric("mean_" + name, sum.first / sum.second);
+    }
+}
+
+void monadcount_sim::core::Scenario::FinishReplica() {
+    ReportMetric("replica_run_seconds",
+                 std::chrono::duration<double>(std::chrono::steady_clock::now() - m_replicaStart).count());
+    ReportMetric("private_kb", static_cast<double>(PrivateMemoryKb()));
+    std::ostringstream out;
+    out.precision(15);
+    for (const auto& [name, value] : m_metrics) {
+        out << name << ',' << value << '\n';
+    }
+    const std::string report = out.str();
+    const char* data = report.data();
+    std::size_t size = report.size();
+    while (size > 0) {
+        ssize_t written = ::write(m_replicaPipe, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            break;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    ::close(m_replicaPipe);
+    std::cout.flush();
+    std::clog.flush();
+    std::fflush(nullptr);
+    // Skip static destructors and atexit handlers: they belong to the parent.
+    std::_Exit(0);
 }
 
 std::unique_ptr<monadcount_sim::core::ScenarioEnvironment> monadcount_sim::core::Scenario::BuildEnvironment(const std::string& scenarioFile) {
     core::ScenarioEnvironmentBuilder builder;
+    builder.SetBatched(m_loadOptions.batchedBuild);
+    builder.SetPartitions(m_loadOptions.partitions);
 
     if (scenarioFile.empty()) {
         // Create empty environment
-        return builder.Build({});
+        builder.Begin();
+        return builder.Finish();
+    }
+
+    const bool selective = !m_loadOptions.experimentId.empty();
+    uint64_t sourceHash = 0;
+    uint64_t sourceSize = 0;
+    if (m_loadOptions.useCache || selective) {
+        sourceHash = HashFileContents(scenarioFile, &sourceSize);
+    }
+
+    // Compiled cache: map the previously compiled scenario if the source is unchanged. A single experiment is
+    // cached under its own key.
+    std::string cachePath;
+    std::unique_ptr<CompiledScenarioWriter> writer;
+    if (m_loadOptions.useCache) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t cacheKey = selective ? sourceHash ^ HashBytes(m_loadOptions.experimentId) : sourceHash;
+        cachePath = CompiledScenario::CachePath(m_loadOptions.cacheDirectory, scenarioFile, cacheKey);
+        if (auto compiled = CompiledScenario::Open(cachePath, cacheKey)) {
+            auto env = builder.Build(*compiled);
+            NS_LOG_INFO ("Loaded " << compiled->GetFeatureCount() << " features from compiled cache " << cachePath
+                         << " in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                         << " s, peak RSS " << PeakRssKb() << " KiB");
+            return env;
+        }
+        writer = std::make_unique<CompiledScenarioWriter>();
+    }
+
+    // Parse GeoJSON and build environment
+    GeoJSONParser parser;
+    parser.setThreads(m_loadOptions.parseThreads);
+    std::unique_ptr<ScenarioEnvironment> env;
+    if (selective) {
+        auto features = parser.parseRanges(scenarioFile, FindExperiment(scenarioFile, sourceHash));
+        env = builder.Build(features);
+        if (writer) {
+            for (const auto &feature : features) writer->Add(*feature);
+        }
+    } else if (m_loadOptions.arena) {
+        models::FeatureStore store;
+        parser.parseToStore(scenarioFile, store);
+        env = builder.Build(store);
+        if (writer) {
+            store.visit([&writer](const models::FeatureRef &feature) { writer->Add(feature); });
+        }
+    } else if (m_loadOptions.streaming) {
+        builder.Begin();
+        parser.parseStream(scenarioFile, [&builder, &writer](std::unique_ptr<models::Feature> feature) {
+            builder.Add(*feature);
+            if (writer) writer->Add(*feature);
+        });
+        env = builder.Finish();
     } else {
-        // Parse GeoJSON and build environment
-        GeoJSONParser parser;
         auto features = parser.parseFile(scenarioFile);
-        return builder.Build(features);
+        env = builder.Build(features);
+        if (writer) {
+            for (const auto &feature : features) writer->Add(*feature);
+        }
+    }
+
+    if (writer) {
+        writer->Write(cachePath, selective ? sourceHash ^ HashBytes(m_loadOptions.experimentId) : sourceHash, sourceSize);
+        NS_LOG_INFO ("Wrote compiled scenario cache " << cachePath);
+    }
+
+    const ParseReport &report = parser.lastReport();
+    NS_LOG_INFO ("Loaded " << report.featureCount << " features (" << report.errorCount << " errors) from "
+                 << scenarioFile << " in " << report.elapsedSeconds << " s using the "
+                 << (selective ? "selective" : m_loadOptions.arena ? "arena" : m_loadOptions.streaming ? "streaming" : "DOM")
+                 << " parser, peak RSS "
+                 << report.peakRssKb << " KiB");
+    return env;
+}
+
+std::vector<monadcount_sim::core::ByteRange> monadcount_sim::core::Scenario::FindExperiment(const std::string& scenarioFile, uint64_t sourceHash) const {
+    // The index is built with one scan of the file and kept next to the compiled caches.
+    std::string indexPath = ExperimentIndex::IndexPath(m_loadOptions.cacheDirectory, scenarioFile, sourceHash);
+    std::optional<ExperimentIndex> index = ExperimentIndex::Load(indexPath, sourceHash);
+    if (!index) {
+        auto start = std::chrono::steady_clock::now();
+        auto file = MappedFile::Open(scenarioFile);
+        if (!file) {
+            throw std::runtime_error("Could not open file: " + scenarioFile);
+        }
+        index = ExperimentIndex::Build(file->GetView(), sourceHash);
+        index->Save(indexPath);
+        NS_LOG_INFO ("Indexed " << index->GetFeatureCount() << " features in " << index->GetExperimentIds().size()
+                     << " experiments in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                     << " s, wrote " << indexPath);
     }
-}
\ No newline at end of file
+
+    const std::vector<ByteRange> *ranges = index->Find(m_loadOptions.experimentId);
+    if (!ranges) {
+        std::string available;
+        for (const auto &id : index->GetExperimentIds()) {
+            available += (available.empty() ? "" : ", ") + id;
+        }
+        throw std::runtime_error("No features with experiment_id '" + m_loadOptions.experimentId + "' in " +
+                                 scenarioFile + " (available: " + available + ")");
+    }
+    NS_LOG_INFO ("Selected " << ranges->size() << " of " << index->GetFeatureCount() << " features for experiment "
+                 << m_loadOptions.experimentId);
+    return *ranges;
+}
@@ -4,68 +4,301 @@
 #include "ns3/vector.h"
 #include "ns3/log.h"
 #include "monadcount_sim/models/PointGeometry.hpp"
+#include "monadcount_sim/models/PolygonGeometry.hpp"
+#include "monadcount_sim/core/RoomPartition.hpp"
+
+#include <chrono>
+#include <variant>
+#include <vector>
 
 
 NS_LOG_COMPONENT_DEFINE ("ScenarioEnvironmentBuilder");
 
+namespace
+{
+    // Load of one AP, sniffer or terminal in square metres of floor, when weighting rooms for partitioning.
+    constexpr double kNodeWeight = 25.0;
+
+    // Turns a Feature's geometry into a GeometryView; polygon rings are flattened into the caller's scratch buffers.
+    class GeometryViewBuilder : public monadcount_sim::models::GeometryVisitor
+    {
+    public:
+        GeometryViewBuilder(monadcount_sim::models::GeometryView &view,
+                            std::vector<monadcount_sim::models::Point> &points,
+                            std::vector<monadcount_sim::models::RingSpan> &rings)
+            : view(view), points(points), rings(rings) {}
+
+        void visit(const monadcount_sim::models::PointGeometry &geometry) override
+        {
+            view = monadcount_sim::models::PointView{geometry.point.x, geometry.point.y};
+        }
+
+        void visit(const monadcount_sim::models::PolygonGeometry &geometry) override
+        {
+            points.clear();
+            rings.clear();
+            for (const auto &ring : geometry.rings)
+            {
+                rings.push_back({static_cast<uint32_t>(points.size()), static_cast<uint32_t>(ring.size())});
+                points.insert(points.end(), ring.begin(), ring.end());
+            }
+            view = monadcount_sim::models::PolygonView{rings, points.data()};
+        }
+
+    private:
+        monadcount_sim::models::GeometryView &view;
+        std::vector<monadcount_sim::models::Point> &points;
+        std::vector<monadcount_sim::models::RingSpan> &rings;
+    };
+}
+
 std::unique_ptr<monadcount_sim::core::ScenarioEnvironment> monadcount_sim::core::ScenarioEnvironmentBuilder::Build(const std::vector<std::unique_ptr<monadcount_sim::models::Feature>> &features)
+{
+    Begin();
+    for (const auto &f : features)
+    {
+        Add(*f);
+    }
+    return Finish();
+}
+
+void monadcount_sim::core::ScenarioEnvironmentBuilder::Begin()
 {
     NS_LOG_INFO ("Building NS-3 Environment from Features...");
-    auto env = std::make_unique<ScenarioEnvironment>();
+    m_env = std::make_unique<ScenarioEnvironment>();
+    m_apBatch = NodeBatch();
+    m_snifferBatch = NodeBatch();
+    m_terminalBatch = NodeBatch();
+    m_buildStart = std::chrono::steady_clock::now();
+}
 
-    // Loop over each Feature and build the corresponding ns-3 object or dynamic actor.
-    for (const auto &f : features)
+void monadcount_sim::core::ScenarioEnvironmentBuilder::Add(const models::Feature &feature)
+{
+    models::FeatureRef ref;
+    ref.id = feature.getId();
+    ref.experimentId = feature.getExperimentId();
+    ref.category = feature.getCategory();
+
+    if (feature.getGeometry())
+    {
+        GeometryViewBuilder visitor(ref.geometry, m_scratchPoints, m_scratchRings);
+        feature.getGeometry()->accept(visitor);
+    }
+
+    Add(ref);
+}
+
+std::unique_ptr<monadcount_sim::core::ScenarioEnvironment> monadcount_sim::core::ScenarioEnvironmentBuilder::Build(const CompiledScenario &scenario)
+{
+    Begin();
+    for (std::size_t i = 0; i < scenario.GetFeatureCount(); ++i)
+    {
+        // Ids and coordinates are read straight out of the mapped file.
+        Add(scenario.GetFeatureRef(i));
+    }
+    return Finish();
+}
+
+std::unique_ptr<monadcount_sim::core::ScenarioEnvironment> monadcount_sim::core::ScenarioEnvironmentBuilder::Build(const models::FeatureStore &store)
+{
+    Begin();
+    store.visit([this](const models::FeatureRef &feature) { Add(feature); });
+    return Finish();
+}
+
+void monadcount_sim::core::ScenarioEnvironmentBuilder::Add(const models::FeatureRef &feature)
+{
+    // Build the corresponding ns-3 object or dynamic actor.
+    switch (feature.category.getType())
+    {
+        case models::Category::ACCESS_POINT:
+            createApNode(feature, *m_env);
+            break;
+        case models::Category::SNIFFER:
+            createSnifferNode(feature, *m_env);
+            break;
+        case models::Category::TERMINAL:
+            createTerminalNode(feature, *m_env);
+            break;
+        case models::Category::WALL:
+        case models::Category::TABLE:
+            createObstacle(feature, *m_env);
+            break;
+        case models::Category::SEAT:
+            createSeat(feature, *m_env);
+            break;
+        case models::Category::DOOR:
+            createDoor(feature, *m_env);
+            break;
+        case models::Category::ROOM:
+            createRoom(feature, *m_env);
+            break;
+        default:
+            NS_LOG_WARN ("Unhandled feature category: " << feature.category.toString());
+            break;
+    }
+}
+
+std::unique_ptr<monadcount_sim::core::ScenarioEnvironment> monadcount_sim::core::ScenarioEnvironmentBuilder::Finish()
+{
+    m_env->partitionCount = m_partitions;
+    if (m_partitions > 1)
+    {
+        std::vector<uint32_t> apIds, snifferIds, terminalIds;
+        PartitionRooms(apIds, snifferIds, terminalIds);
+        m_env->apNodes.Add(CreateBatch(m_apBatch, apIds));
+        m_env->snifferNodes.Add(CreateBatch(m_snifferBatch, snifferIds));
+        m_env->terminalNodes.Add(CreateBatch(m_terminalBatch, terminalIds));
+    }
+    else if (m_batched)
+    {
+        m_env->apNodes.Add(CreateBatch(m_apBatch));
+        m_env->snifferNodes.Add(CreateBatch(m_snifferBatch));
+        m_env->terminalNodes.Add(CreateBatch(m_terminalBatch));
+        NS_LOG_DEBUG ("Batched nodes created. APs: " << m_env->apNodes.GetN() << ", sniffers: "
+                      << m_env->snifferNodes.GetN() << ", terminals: " << m_env->terminalNodes.GetN());
+    }
+
+    m_env->obstacleIndex.Build();
+    NS_LOG_INFO ("Indexed " << m_env->obstacleIndex.GetSegmentCount() << " obstacle edges from "
+                 << m_env->obstacles.size() << " obstacles");
+
+    NS_LOG_INFO ("Environment build complete in "
+                 << std::chrono::duration<double>(std::chrono::steady_clock::now() - m_buildStart).count()
+                 << " s (" << (m_partitions > 1 ? "partitioned" : m_batched ? "batched" : "per-node") << " node creation).");
+    return std::move(m_env);
+}
+
+void monadcount_sim::core::ScenarioEnvironmentBuilder::QueueNode(NodeBatch &batch, const models::FeatureRef &feature)
+{
+    if (const auto *pt = std::get_if<models::PointView>(&feature.geometry))
+    {
+        batch.positioned.push_back(batch.count);
+        batch.positions.emplace_back(pt->x, pt->y, 0.0);
+    }
+    ++batch.count;
+}
+
+void monadcount_sim::core::ScenarioEnvironmentBuilder::PartitionRooms(std::vector<uint32_t> &apIds,
+                                                                      std::vector<uint32_t> &snifferIds,
+                                                                      std::vector<uint32_t> &terminalIds)
+{
+    std::vector<Room> &rooms = m_env->rooms;
+    if (rooms.empty())
     {
-        switch (f->getCategory().getType())
+        NS_LOG_WARN ("Partitioning over " << m_partitions << " ranks requested, but the input has no rooms; "
+                     "all nodes stay on rank 0");
+    }
+
+    // Room of every queued node (rooms.size() = none); each room is weighted by the nodes it holds.
+    auto locate = [&rooms](const NodeBatch &batch, std::vector<std::size_t> &roomOf, std::vector<uint32_t> &counts)
+    {
+        roomOf.assign(batch.count, rooms.size());
+        for (std::size_t i = 0; i < batch.positioned.size(); ++i)
+        {
+            std::size_t room = FindRoom(rooms, batch.positions[i].x, batch.positions[i].y);
+            roomOf[batch.positioned[i]] = room;
+            if (room < rooms.size())
+            {
+                ++counts[room];
+            }
+        }
+    };
+    std::vector<uint32_t> nodesPerRoom(rooms.size(), 0);
+    std::vector<std::size_t> apRooms, snifferRooms, terminalRooms;
+    locate(m_apBatch, apRooms, nodesPerRoom);
+    locate(m_snifferBatch, snifferRooms, nodesPerRoom);
+    locate(m_terminalBatch, terminalRooms, nodesPerRoom);
+
+    std::vector<double> loads = AssignRoomsToRanks(rooms, m_partitions, nodesPerRoom, kNodeWeight);
+    for (uint32_t rank = 0; rank < m_partitions; ++rank)
+    {
+        uint32_t roomCount = 0;
+        uint32_t nodeCount = 0;
+        for (std::size_t room = 0; room < rooms.size(); ++room)
+        {
+            if (rooms[room].rank == rank)
+            {
+                ++roomCount;
+                nodeCount += nodesPerRoom[room];
+            }
+        }
+        NS_LOG_INFO ("Rank " << rank << ": " << roomCount << " rooms, " << nodeCount << " infrastructure nodes, load "
+                     << loads[rank]);
+    }
+
+    auto systemIds = [&rooms](const std::vector<std::size_t> &roomOf, std::vector<uint32_t> &ids)
+    {
+        ids.resize(roomOf.size());
+        for (std::size_t i = 0; i < roomOf.size(); ++i)
+        {
+            ids[i] = roomOf[i] < rooms.size() ? rooms[roomOf[i]].rank : 0;
+        }
+    };
+    systemIds(apRooms, apIds);
+    systemIds(snifferRooms, snifferIds);
+    systemIds(terminalRooms, terminalIds);
+}
+
+ns3::NodeContainer monadcount_sim::core::ScenarioEnvironmentBuilder::CreateBatch(const NodeBatch &batch,
+                                                                                 const std::vector<uint32_t> &systemIds)
+{
+    ns3::NodeContainer nodes;
+    if (systemIds.empty())
+    {
+        nodes.Create(batch.count);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < batch.count; ++i)
         {
-            case models::Category::ACCESS_POINT:
-                createApNode(*f, *env);
-                break;
-            case models::Category::SNIFFER:
-                createSnifferNode(*f, *env);
-                break;
-            case models::Category::TERMINAL:
-                createTerminalNode(*f, *env);
-                break;
-            case models::Category::WALL:
-            case models::Category::TABLE:
-                createObstacle(*f, *env);
-                break;
-            case models::Category::SEAT:
-                createSeat(*f, *env);
-                break;
-            case models::Category::DOOR:
-                createDoor(*f, *env);
-                break;
-            default:
-                NS_LOG_WARN ("Unhandled feature category: " << f->getCategory().toString());
-                break;
+            nodes.Add(ns3::CreateObject<ns3::Node>(systemIds[i]));
         }
     }
+    if (batch.positions.empty())
+    {
+        return nodes;
+    }
+
+    // One allocator and one Install for the whole category; nodes without a point geometry get no mobility
+    // model, as in the per-node path.
+    ns3::Ptr<ns3::ListPositionAllocator> posAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
+    ns3::NodeContainer positioned;
+    for (std::size_t i = 0; i < batch.positions.size(); ++i)
+    {
+        posAlloc->Add(batch.positions[i]);
+        positioned.Add(nodes.Get(batch.positioned[i]));
+    }
 
-    NS_LOG_INFO ("Environment build complete.");
-    return env;
+    ns3::MobilityHelper mobility;
+    mobility.SetPositionAllocator(posAlloc);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(positioned);
+    return nodes;
 }
 
-void monadcount_sim::core::ScenarioEnvironmentBuilder::createApNode(const models::Feature &feature, ScenarioEnvironment &env)
+void monadcount_sim::core::ScenarioEnvironmentBuilder::createApNode(const models::FeatureRef &feature, ScenarioEnvironment &env)
 {
+    if (m_batched || m_partitions > 1)
+    {
+        // Created together with the rest of its category in Finish().
+        QueueNode(m_apBatch, feature);
+        return;
+    }
+
     ns3::Ptr<ns3::Node> node = ns3::CreateObject<ns3::Node>();
 
     // If the feature has a point geometry, use it to set the node position.
-    if (feature.getGeometry() && feature.getGeometry()->getType() == "Point")
+    if (const auto *pt = std::get_if<models::PointView>(&feature.geometry))
     {
-        auto pt = dynamic_cast<const models::PointGeometry*>(feature.getGeometry());
-        if (pt)
-        {
-            ns3::Ptr<ns3::ListPositionAllocator> posAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
-            posAlloc->Add(ns3::Vector(pt->point.x, pt->point.y, 0.0));
-
-            ns3::MobilityHelper mobility;
-            mobility.SetPositionAllocator(posAlloc);
-            mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-            mobility.Install(node);
-            NS_LOG_DEBUG ("AP node positioned at (" << pt->point.x << ", " << pt->point.y << ")");
-        }
+        ns3::Ptr<ns3::ListPositionAllocator> posAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
+        posAlloc->Add(ns3::Vector(pt->x, pt->y, 0.0));
+
+        ns3::MobilityHelper mobility;
+        mobility.SetPositionAllocator(posAlloc);
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobility.Install(node);
+        NS_LOG_DEBUG ("AP node positioned at (" << pt->x << ", " << pt->y << ")");
     }
 
     // Installation of Wi-Fi (or BLE) devices is omitted for brevity.
@@ -73,51 +306,57 @@ void monadcount_sim::core::ScenarioEnvironmentBuilder::createApNode(const models
     NS_LOG_DEBUG ("AP node created. Total APs: " << env.apNodes.GetN());
 }
 
-void monadcount_sim::core::ScenarioEnvironmentBuilder::createSnifferNode(const models::Feature &feature, ScenarioEnvironment &env)
+void monadcount_sim::core::ScenarioEnvironmentBuilder::createSnifferNode(const models::FeatureRef &feature, ScenarioEnvironment &env)
 {
+    if (m_batched || m_partitions > 1)
+    {
+        // Created together with the rest of its category in Finish().
+        QueueNode(m_snifferBatch, feature);
+        return;
+    }
+
     ns3::Ptr<ns3::Node> node = ns3::CreateObject<ns3::Node>();
 
-    if (feature.getGeometry() && feature.getGeometry()->getType() == "Point")
+    if (const auto *pt = std::get_if<models::PointView>(&feature.geometry))
     {
-        auto pt = dynamic_cast<const models::PointGeometry*>(feature.getGeometry());
-        if (pt)
-        {
-            ns3::Ptr<ns3::ListPositionAllocator> posAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
-            posAlloc->Add(ns3::Vector(pt->point.x, pt->point.y, 0.0));
+        ns3::Ptr<ns3::ListPositionAllocator> posAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
+        posAlloc->Add(ns3::Vector(pt->x, pt->y, 0.0));
 
-            ns3::MobilityHelper mobility;
-            mobility.SetPositionAllocator(posAlloc);
-            mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-            mobility.Install(node);
+        ns3::MobilityHelper mobility;
+        mobility.SetPositionAllocator(posAlloc);
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobility.Install(node);
 
-            NS_LOG_DEBUG ("Sniffer node positioned at (" << pt->point.x << ", " << pt->point.y << ")");
-        }
+        NS_LOG_DEBUG ("Sniffer node positioned at (" << pt->x << ", " << pt->y << ")");
     }
 
-    // Attach multiple network devices (e.g., two BLE cards) as required.
+    // Radios are installed by the experiment, which owns the channels (see wifi::WifiSniffer).
     env.snifferNodes.Add(node);
     NS_LOG_DEBUG ("Sniffer node created. Total sniffers: " << env.snifferNodes.GetN());
 }
 
-void monadcount_sim::core::ScenarioEnvironmentBuilder::createTerminalNode(const models::Feature &feature, ScenarioEnvironment &env)
+void monadcount_sim::core::ScenarioEnvironmentBuilder::createTerminalNode(const models::FeatureRef &feature, ScenarioEnvironment &env)
 {
+    if (m_batched || m_partitions > 1)
+    {
+        // Created together with the rest of its category in Finish().
+        QueueNode(m_terminalBatch, feature);
+        return;
+    }
+
     ns3::Ptr<ns3::Node> node = ns3::CreateObject<ns3::Node>();
 
-    if (feature.getGeometry() && feature.getGeometry()->getType() == "Point")
+    if (const auto *pt = std::get_if<models::PointView>(&feature.geometry))
     {
-        auto pt = dynamic_cast<const models::PointGeometry*>(feature.getGeometry());
-        if (pt)
-        {
-            ns3::Ptr<ns3::ListPositionAllocator> posAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
-            posAlloc->Add(ns3::Vector(pt->point.x, pt->point.y, 0.0));
+        ns3::Ptr<ns3::ListPositionAllocator> posAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
+        posAlloc->Add(ns3::Vector(pt->x, pt->y, 0.0));
 
-            ns3::MobilityHelper mobility;
-            mobility.SetPositionAllocator(posAlloc);
-            mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-            mobility.Install(node);
+        ns3::MobilityHelper mobility;
+        mobility.SetPositionAllocator(posAlloc);
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobility.Install(node);
 
-            NS_LOG_DEBUG ("Terminal node positioned at (" << pt->point.x << ", " << pt->point.y << ")");
-        }
+        NS_LOG_DEBUG ("Terminal node positioned at (" << pt->x << ", " << pt->y << ")");
     }
 
     // Installation of terminal network devices in station mode is omitted.
@@ -125,51 +364,65 @@ void monadcount_sim::core::ScenarioEnvironmentBuilder::createTerminalNode(const
     NS_LOG_DEBUG ("Terminal node created. Total terminals: " << env.terminalNodes.GetN());
 }
 
-void monadcount_sim::core::ScenarioEnvironmentBuilder::createObstacle(const models::Feature &feature, ScenarioEnvironment &env)
+void monadcount_sim::core::ScenarioEnvironmentBuilder::createObstacle(const models::FeatureRef &feature, ScenarioEnvironment &env)
 {
     Obstacle obs;
-    obs.id = feature.getId();
-    // Additional geometry processing can be added here.
+    obs.id = std::string(feature.id);
+    obs.material = feature.category.getType() == models::Category::TABLE ? Material::TABLE : Material::WALL;
+
+    // The outline is kept as edge segments so links can be tested against it.
+    if (const auto *polygon = std::get_if<models::PolygonView>(&feature.geometry))
+    {
+        obs.firstSegment = env.obstacleIndex.AddPolygon(static_cast<uint32_t>(env.obstacles.size()), obs.material, *polygon);
+        obs.segmentCount = static_cast<uint32_t>(env.obstacleIndex.GetSegmentCount()) - obs.firstSegment;
+    }
+
     env.obstacles.push_back(obs);
-    NS_LOG_DEBUG ("Obstacle created with id " << obs.id << ". Total obstacles: " << env.obstacles.size());
+    NS_LOG_DEBUG ("Obstacle created with id " << obs.id << " (" << obs.segmentCount << " edges). Total obstacles: " << env.obstacles.size());
 }
 
-void monadcount_sim::core::ScenarioEnvironmentBuilder::createSeat(const models::Feature &feature, ScenarioEnvironment &env)
+void monadcount_sim::core::ScenarioEnvironmentBuilder::createSeat(const models::FeatureRef &feature, ScenarioEnvironment &env)
 {
     Seat seat;
-    seat.id = feature.getId();
+    seat.id = std::string(feature.id);
 
-    if (feature.getGeometry() && feature.getGeometry()->getType() == "Point")
+    if (const auto *pt = std::get_if<models::PointView>(&feature.geometry))
     {
-        auto pt = dynamic_cast<const models::PointGeometry*>(feature.getGeometry());
-        if (pt)
-        {
-            seat.x = pt->point.x;
-            seat.y = pt->point.y;
-            NS_LOG_DEBUG("Seat positioned at (" << seat.x << ", " << seat.y << ")");
-        }
+        seat.x = pt->x;
+        seat.y = pt->y;
+        NS_LOG_DEBUG ("Seat positioned at (" << seat.x << ", " << seat.y << ")");
     }
 
     env.seats.push_back(seat);
     NS_LOG_DEBUG ("Seat created with id " << seat.id << ". Total seats: " << env.seats.size());
 }
 
-void monadcount_sim::core::ScenarioEnvironmentBuilder::createDoor(const models::Feature &feature, ScenarioEnvironment &env)
+void monadcount_sim::core::ScenarioEnvironmentBuilder::createDoor(const models::FeatureRef &feature, ScenarioEnvironment &env)
 {
     Door door;
-    door.id = feature.getId();
+    door.id = std::string(feature.id);
 
-    if (feature.getGeometry() && feature.getGeometry()->getType() == "Point")
+    if (const auto *pt = std::get_if<models::PointView>(&feature.geometry))
     {
-        auto pt = dynamic_cast<const models::PointGeometry*>(feature.getGeometry());
-        if (pt)
-        {
-            door.x = pt->point.x;
-            door.y = pt->point.y;
-            NS_LOG_DEBUG ("Door positioned at (" << door.x << ", " << door.y << ")");
-        }
+        door.x = pt->x;
+        door.y = pt->y;
+        NS_LOG_DEBUG ("Door positioned at (" << door.x << ", " << door.y << ")");
     }
 
     env.doors.push_back(door);
     NS_LOG_DEBUG ("Door created with id " << door.id << ". Total doors: " << env.doors.size());
 }
+
+void monadcount_sim::core::ScenarioEnvironmentBuilder::createRoom(const models::FeatureRef &feature, ScenarioEnvironment &env)
+{
+    const auto *polygon = std::get_if<models::PolygonView>(&feature.geometry);
+    if (!polygon)
+    {
+        NS_LOG_WARN ("Room " << feature.id << " has no polygon geometry; ignored");
+        return;
+    }
+
+    env.rooms.push_back(MakeRoom(std::string(feature.id), *polygon));
+    NS_LOG_DEBUG ("Room created with id " << env.rooms.back().id << " (" << env.rooms.back().area
+                  << " m2). Total rooms: " << env.rooms.size());
+}
@@ -0,0 +1,311 @@
+#include <monadcount_sim/core/SweepRunner.hpp>
+
+#include <ns3/log.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE ("SweepRunner");
+
+namespace {
+    std::vector<std::string> split(const std::string &text, char separator) {
+        std::vector<std::string> parts;
+        std::size_t start = 0;
+        while (true) {
+            std::size_t end = text.find(separator, start);
+            parts.push_back(text.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (end == std::string::npos) {
+                return parts;
+            }
+            start = end + 1;
+        }
+    }
+
+    uint32_t parseSeed(const std::string &text) {
+        std::size_t used = 0;
+        unsigned long value = 0;
+        try {
+            value = std::stoul(text, &used);
+        } catch (const std::exception &) {
+            used = 0;
+        }
+        if (text.empty() || used != text.size() || value == 0 || value > UINT32_MAX) {
+            throw std::invalid_argument("Invalid RngRun seed '" + text + "' (positive integers, e.g. 1-16 or 1,4,9)");
+        }
+        return static_cast<uint32_t>(value);
+    }
+
+    std::string runDirectoryName(uint32_t index) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "run-%04u", index);
+        return name;
+    }
+
+    // Forks a worker that execs argv in directory with its output in run.log. Everything the child touches
+    // is prepared here, so it only makes async-signal-safe calls.
+    pid_t spawn(const std::string &directory, const std::vector<std::string> &arguments) {
+        std::vector<char *> argv;
+        argv.reserve(arguments.size() + 1);
+        for (const std::string &argument : arguments) {
+            argv.push_back(const_cast<char *>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+        const char *log = "run.log";
+
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            if (::chdir(directory.c_str()) != 0) {
+                ::_exit(126);
+            }
+            int fd = ::open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd >= 0) {
+                ::dup2(fd, STDOUT_FILENO);
+                ::dup2(fd, STDERR_FILENO);
+                ::close(fd);
+            }
+            ::execv(argv[0], argv.data());
+            ::_exit(127);
+        }
+        return pid;
+    }
+
+    std::vector<std::pair<std::string, double>> readMetrics(const std::filesystem::path &path) {
+        std::vector<std::pair<std::string, double>> metrics;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::size_t comma = line.rfind(',');
+            if (comma == std::string::npos) {
+                continue;
+            }
+            try {
+                metrics.emplace_back(line.substr(0, comma), std::stod(line.substr(comma + 1)));
+            } catch (const std::exception &) {
+                // Not a number: skip the line rather than lose the run.
+            }
+        }
+        return metrics;
+    }
+}
+
+std::vector<std::pair<std::string, std::vector<std::string>>>
+monadcount_sim::core::ParseSweepGrid(const std::string &grid) {
+    std::vector<std::pair<std::string, std::vector<std::string>>> axes;
+    if (grid.empty()) {
+        return axes;
+    }
+    for (const std::string &axis : split(grid, ';')) {
+        std::size_t equals = axis.find('=');
+        if (equals == std::string::npos || equals == 0 || equals + 1 == axis.size()) {
+            throw std::invalid_argument("Invalid sweep axis '" + axis + "' (expected option=value,value,...)");
+        }
+        std::string option = axis.substr(0, equals);
+        if (option.rfind("--", 0) == 0) {
+            option.erase(0, 2);
+        }
+        std::vector<std::string> values = split(axis.substr(equals + 1), ',');
+        if (std::find(values.begin(), values.end(), "") != values.end()) {
+            throw std::invalid_argument("Empty value in sweep axis '" + axis + "'");
+        }
+        axes.emplace_back(option, std::move(values));
+    }
+    return axes;
+}
+
+std::vector<uint32_t> monadcount_sim::core::ParseSeedList(const std::string &seeds) {
+    std::vector<uint32_t> values;
+    for (const std::string &part : split(seeds, ',')) {
+        std::size_t dash = part.find('-');
+        if (dash == std::string::npos) {
+            values.push_back(parseSeed(part));
+            continue;
+        }
+        uint32_t first = parseSeed(part.substr(0, dash));
+        uint32_t last = parseSeed(part.substr(dash + 1));
+        if (last < first) {
+            throw std::invalid_argument("Invalid RngRun range '" + part + "'");
+        }
+        for (uint32_t seed = first; seed <= last; ++seed) {
+            values.push_back(seed);
+        }
+    }
+    return values;
+}
+
+std::vector<monadcount_sim::core::SweepRun> monadcount_sim::core::ExpandSweep(
+        const std::vector<std::pair<std::string, std::vector<std::string>>> &axes,
+        const std::vector<uint32_t> &seeds) {
+    std::vector<SweepRun> runs;
+    // Odometer over the axes, the last axis turning fastest.
+    std::vector<std::size_t> position(axes.size(), 0);
+    while (true) {
+        for (uint32_t seed : seeds) {
+            SweepRun run;
+            run.index = static_cast<uint32_t>(runs.size());
+            for (std::size_t axis = 0; axis < axes.size(); ++axis) {
+                run.parameters.emplace_back(axes[axis].first, axes[axis].second[position[axis]]);
+            }
+            run.rngRun = seed;
+            runs.push_back(std::move(run));
+        }
+        std::size_t axis = axes.size();
+        while (axis > 0 && ++position[axis - 1] == axes[axis - 1].second.size()) {
+            position[axis - 1] = 0;
+            --axis;
+        }
+        if (axis == 0) {
+            return runs;
+        }
+    }
+}
+
+monadcount_sim::core::SweepRunner::SweepRunner(std::string executable, std::vector<std::string> arguments,
+                                               std::string outputDirectory, unsigned jobs)
+        : m_executable(std::move(executable)),
+          m_arguments(std::move(arguments)),
+          m_outputDirectory(std::move(outputDirectory)),
+          m_jobs(jobs > 0 ? jobs : std::max(1u, std::thread::hardware_concurrency())) {
+}
+
+std::vector<monadcount_sim::core::SweepResult> monadcount_sim::core::SweepRunner::Run(const std::vector<SweepRun> &runs) {
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<SweepResult> results(runs.size());
+    std::map<pid_t, std::pair<std::size_t, Clock::time_point>> active;  // pid -> run, start time
+    std::size_t next = 0;
+    std::size_t finished = 0;
+    const auto sweepStart = Clock::now();
+    NS_LOG_INFO ("Sweeping " << runs.size() << " runs with " << m_jobs << " workers into " << m_outputDirectory);
+
+    while (finished < runs.size()) {
+        while (active.size() < m_jobs && next < runs.size()) {
+            const SweepRun &run = runs[next];
+            fs::path directory = fs::path(m_outputDirectory) / runDirectoryName(run.index);
+            fs::create_directories(directory);
+
+            std::vector<std::string> arguments;
+            arguments.reserve(m_arguments.size() + run.parameters.size() + 3);
+            arguments.push_back(m_executable);
+            arguments.insert(arguments.end(), m_arguments.begin(), m_arguments.end());
+            // ns-3's CommandLine keeps the last value of an option, so these override the base arguments.
+            for (const auto &[option, value] : run.parameters) {
+                arguments.push_back("--" + option + "=" + value);
+            }
+            arguments.push_back("--RngRun=" + std::to_string(run.rngRun));
+            arguments.push_back(std::string("--metrics=") + kMetricsFile);
+
+            pid_t pid = spawn(directory.string(), arguments);
+            if (pid < 0) {
+                throw std::runtime_error(std::string("Could not start a sweep worker: ") + std::strerror(errno));
+            }
+            results[next].run = run;
+            active.emplace(pid, std::make_pair(next, Clock::now()));
+            ++next;
+        }
+
+        int status = 0;
+        struct rusage usage {};
+        pid_t pid = ::wait4(-1, &status, 0, &usage);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Waiting for sweep workers failed: ") + std::strerror(errno));
+        }
+        auto it = active.find(pid);
+        if (it == active.end()) {
+            continue;
+        }
+        SweepResult &result = results[it->second.first];
+        result.wallSeconds = std::chrono::duration<double>(Clock::now() - it->second.second).count();
+        result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+#ifdef __APPLE__
+        result.maxRssKb = usage.ru_maxrss / 1024;
+#else
+        result.maxRssKb = usage.ru_maxrss;
+#endif
+        result.metrics = readMetrics(fs::path(m_outputDirectory) / runDirectoryName(result.run.index) / kMetricsFile);
+        active.erase(it);
+        ++finished;
+        if (result.exitCode != 0) {
+            NS_LOG_WARN ("[" << finished << "/" << runs.size() << "] " << runDirectoryName(result.run.index)
+                         << " failed with " << (result.exitCode < 0 ? "signal " : "exit code ")
+                         << std::abs(result.exitCode) << ", see its run.log");
+        } else {
+            NS_LOG_INFO ("[" << finished << "/" << runs.size() << "] " << runDirectoryName(result.run.index)
+                         << " finished in " << result.wallSeconds << " s");
+        }
+    }
+
+    WriteSummary(results);
+    NS_LOG_INFO ("Sweep finished in " << std::chrono::duration<double>(Clock::now() - sweepStart).count()
+                 << " s, summary in " << (fs::path(m_outputDirectory) / "summary.csv").string());
+    return results;
+}
+
+void monadcount_sim::core::SweepRunner::WriteSummary(const std::vector<SweepResult> &results) const {
+    // Metric columns in order of first appearance; runs without a metric leave its cell empty.
+    std::vector<std::string> metricNames;
+    for (const SweepResult &result : results) {
+        for (const auto &metric : result.metrics) {
+            if (std::find(metricNames.begin(), metricNames.end(), metric.first) == metricNames.end()) {
+                metricNames.push_back(metric.first);
+            }
+        }
+    }
+
+    const std::string path = (std::filesystem::path(m_outputDirectory) / "summary.csv").string();
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Could not create sweep summary: " + path);
+    }
+    out.precision(15);  // event counts and the like stay integers
+    out << "run";
+    if (!results.empty()) {
+        for (const auto &parameter : results.front().run.parameters) {
+            out << ',' << parameter.first;
+        }
+    }
+    out << ",rng_run,exit_code,wall_seconds,max_rss_kb";
+    for (const std::string &name : metricNames) {
+        out << ',' << name;
+    }
+    out << '\n';
+
+    for (const SweepResult &result : results) {
+        out << result.run.index;
+        for (const auto &parameter : result.run.parameters) {
+            out << ',' << parameter.second;
+        }
+        out << ',' << result.run.rngRun << ',' << result.exitCode << ',' << result.wallSeconds << ','
+            << result.maxRssKb;
+        for (const std::string &name : metricNames) {
+            out << ',';
+            for (const auto &metric : result.metrics) {
+                if (metric.first == name) {
+                    out << metric.second;
+                    break;
+                }
+            }
+        }
+        out << '\n';
+    }
+    if (!out) {
+        throw std::runtime_error("Could not write sweep summary: " + path);
+    }
+}
@@ -0,0 +1,307 @@
+#include <monadcount_sim/core/TrajectoryFile.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char kFileMagic[8] = {'M', 'C', 'T', 'R', 'A', 'J', '0', '1'};
+    constexpr char kBlockMagic[4] = {'T', 'B', 'L', 'K'};
+    constexpr uint32_t kHeaderBytes = 32;
+    constexpr uint32_t kBlockHeaderBytes = 32;
+
+    // Worst case per sample: two 10-byte varints, the kind byte and six 5-byte varints.
+    constexpr std::size_t kMaxSampleBytes = 2 * 10 + 1 + 6 * 5;
+
+    constexpr std::size_t pad8(std::size_t value) {
+        return (value + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    template<typename T>
+    uint8_t *put(uint8_t *out, T value) {
+        std::memcpy(out, &value, sizeof(value));
+        return out + sizeof(value);
+    }
+
+    uint8_t *putVarint(uint8_t *out, uint64_t value) {
+        while (value >= 0x80) {
+            *out++ = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<uint8_t>(value);
+        return out;
+    }
+
+    uint8_t *putSigned(uint8_t *out, int64_t value) {
+        return putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    bool getVarint(const uint8_t *&in, const uint8_t *end, uint64_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && in < end; shift += 7) {
+            const uint8_t byte = *in++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool getSigned(const uint8_t *&in, const uint8_t *end, int64_t &value) {
+        uint64_t raw;
+        if (!getVarint(in, end, raw)) {
+            return false;
+        }
+        value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        return true;
+    }
+
+    bool writeAll(int fd, const uint8_t *data, std::size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+}
+
+monadcount_sim::core::TrajectoryWriter::TrajectoryWriter(const std::string &path, int64_t samplePeriodNs,
+                                                         std::size_t ringSamples, uint32_t blockSamples)
+        : m_blockSamples(std::max<uint32_t>(blockSamples, 1)) {
+    std::size_t capacity = 1;
+    while (capacity < std::max<std::size_t>(ringSamples, 2 * static_cast<std::size_t>(m_blockSamples))) {
+        capacity <<= 1;
+    }
+    m_ring = std::make_unique<TrajectorySample[]>(capacity);
+    m_mask = capacity - 1;
+
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+        throw std::runtime_error("Could not create trajectory file: " + path + " (" + std::strerror(errno) + ")");
+    }
+    uint8_t header[kHeaderBytes] = {};
+    uint8_t *out = header;
+    std::memcpy(out, kFileMagic, sizeof(kFileMagic));
+    out = put(out + sizeof(kFileMagic), kHeaderBytes);
+    out = put(out, static_cast<uint32_t>(kTrajectoryUnitsPerMetre));
+    put(out, samplePeriodNs);
+    m_failed = !writeAll(m_fd, header, sizeof(header));
+    m_stats.bytes = sizeof(header);
+
+    m_writer = std::thread(&TrajectoryWriter::WriterLoop, this);
+}
+
+monadcount_sim::core::TrajectoryWriter::~TrajectoryWriter() {
+    Close();
+}
+
+void monadcount_sim::core::TrajectoryWriter::WaitForSpace() {
+    m_cachedConsumed = m_consumed.load(std::memory_order_acquire);
+    if (m_head - m_cachedConsumed <= m_mask) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_stats.stalls;
+    m_pending.notify_one();
+    m_space.wait(lock, [this] {
+        m_cachedConsumed = m_consumed.load(std::memory_order_acquire);
+        return m_head - m_cachedConsumed <= m_mask;
+    });
+}
+
+void monadcount_sim::core::TrajectoryWriter::Wake() {
+    // Taking the lock orders the publish before the writer's predicate check, so no wake-up is lost.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.notify_one();
+}
+
+void monadcount_sim::core::TrajectoryWriter::WriterLoop() {
+    std::vector<uint8_t> buffer(kBlockHeaderBytes + pad8(static_cast<std::size_t>(m_blockSamples) * kMaxSampleBytes));
+    uint64_t consumed = 0;
+    while (true) {
+        uint64_t published;
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pending.wait(lock, [&] {
+                published = m_published.load(std::memory_order_acquire);
+                return published - consumed >= m_blockSamples || m_stopping;
+            });
+            stopping = m_stopping;
+        }
+        if (published == consumed && stopping) {
+            break;
+        }
+        while (published - consumed >= m_blockSamples || (stopping && published > consumed)) {
+            const auto count = static_cast<uint32_t>(std::min<uint64_t>(published - consumed, m_blockSamples));
+            const bool ok = WriteBlock(consumed, count, buffer);
+            consumed += count;
+            m_consumed.store(consumed, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_failed = m_failed || !ok;
+            m_space.notify_one();
+        }
+    }
+}
+
+bool monadcount_sim::core::TrajectoryWriter::WriteBlock(uint64_t first, uint32_t count, std::vector<uint8_t> &buffer) {
+    const uint32_t generation = ++m_generation;
+
+    const TrajectorySample &firstSample = m_ring[first & m_mask];
+    const TrajectorySample &lastSample = m_ring[(first + count - 1) & m_mask];
+    uint8_t *out = buffer.data() + kBlockHeaderBytes;
+    uint32_t previousNode = 0;
+    int64_t previousTime = firstSample.timeNs;
+    for (uint64_t i = first; i < first + count; ++i) {
+        const TrajectorySample &sample = m_ring[i & m_mask];
+        if (sample.node >= m_nodes.size()) {
+            m_nodes.resize(sample.node + 1, NodeState{{0, 0, 0}, 0});
+        }
+        NodeState &state = m_nodes[sample.node];
+        if (state.generation != generation) {
+            state = NodeState{{0, 0, 0}, generation};
+        }
+        out = putSigned(out, static_cast<int64_t>(sample.node) - previousNode);
+        out = putSigned(out, sample.timeNs - previousTime);
+        *out++ = sample.kind;
+        for (int axis = 0; axis < 3; ++axis) {
+            out = putSigned(out, static_cast<int64_t>(sample.position[axis]) - state.position[axis]);
+            state.position[axis] = sample.position[axis];
+        }
+        if (sample.kind == TrajectorySample::CourseChange) {
+            for (int axis = 0; axis < 3; ++axis) {
+                out = putSigned(out, sample.velocity[axis]);
+            }
+        }
+        previousNode = sample.node;
+        previousTime = sample.timeNs;
+    }
+
+    const auto payloadBytes = static_cast<uint32_t>(out - buffer.data() - kBlockHeaderBytes);
+    const std::size_t blockBytes = kBlockHeaderBytes + pad8(payloadBytes);
+    std::memset(out, 0, buffer.data() + blockBytes - out);
+    uint8_t *header = buffer.data();
+    std::memcpy(header, kBlockMagic, sizeof(kBlockMagic));
+    header = put(header + sizeof(kBlockMagic), count);
+    header = put(header, payloadBytes);
+    header = put(header, static_cast<uint32_t>(0));
+    header = put(header, firstSample.timeNs);
+    put(header, lastSample.timeNs);
+
+    const bool ok = writeAll(m_fd, buffer.data(), blockBytes);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.samples += count;
+    m_stats.blocks += 1;
+    m_stats.bytes += blockBytes;
+    return ok;
+}
+
+bool monadcount_sim::core::TrajectoryWriter::Close() {
+    if (m_closed) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_failed;
+    }
+    m_closed = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_pending.notify_one();
+    m_writer.join();
+    bool closed = ::close(m_fd) == 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_failed = m_failed || !closed;
+    return !m_failed;
+}
+
+monadcount_sim::core::TrajectoryWriterStats monadcount_sim::core::TrajectoryWriter::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::unique_ptr<monadcount_sim::core::TrajectoryReader>
+monadcount_sim::core::TrajectoryReader::Open(const std::string &path) {
+    std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+    if (!file || file->GetSize() < kHeaderBytes || std::memcmp(file->GetData(), kFileMagic, sizeof(kFileMagic)) != 0) {
+        return nullptr;
+    }
+    const auto *data = reinterpret_cast<const uint8_t *>(file->GetData());
+    uint32_t headerBytes;
+    int64_t samplePeriodNs;
+    std::memcpy(&headerBytes, data + 8, sizeof(headerBytes));
+    std::memcpy(&samplePeriodNs, data + 16, sizeof(samplePeriodNs));
+
+    std::vector<Block> blocks;
+    std::size_t offset = headerBytes;
+    while (offset + kBlockHeaderBytes <= file->GetSize()
+           && std::memcmp(data + offset, kBlockMagic, sizeof(kBlockMagic)) == 0) {
+        Block block{};
+        std::memcpy(&block.samples, data + offset + 4, 4);
+        std::memcpy(&block.payloadBytes, data + offset + 8, 4);
+        std::memcpy(&block.firstTimeNs, data + offset + 16, 8);
+        std::memcpy(&block.lastTimeNs, data + offset + 24, 8);
+        block.offset = offset + kBlockHeaderBytes;
+        if (block.offset + block.payloadBytes > file->GetSize()) {
+            break;
+        }
+        blocks.push_back(block);
+        offset = block.offset + pad8(block.payloadBytes);
+    }
+    return std::unique_ptr<TrajectoryReader>(new TrajectoryReader(std::move(file), samplePeriodNs, std::move(blocks)));
+}
+
+void monadcount_sim::core::TrajectoryReader::DecodeBlock(std::size_t block, std::vector<TrajectorySample> &out) const {
+    const Block &info = m_blocks.at(block);
+    const auto *in = reinterpret_cast<const uint8_t *>(m_file->GetData()) + info.offset;
+    const uint8_t *end = in + info.payloadBytes;
+
+    std::vector<TrajectoryWriter::NodeState> nodes;
+    int64_t node = 0;
+    int64_t time = info.firstTimeNs;
+    for (uint32_t i = 0; i < info.samples; ++i) {
+        int64_t delta;
+        TrajectorySample sample;
+        bool ok = getSigned(in, end, delta);
+        node += delta;
+        ok = ok && node >= 0 && node <= UINT32_MAX && getSigned(in, end, delta) && in < end;
+        if (!ok) {
+            throw std::runtime_error("Corrupt trajectory block " + std::to_string(block));
+        }
+        time += delta;
+        sample.timeNs = time;
+        sample.node = static_cast<uint32_t>(node);
+        sample.kind = *in++;
+        if (sample.node >= nodes.size()) {
+            nodes.resize(sample.node + 1, TrajectoryWriter::NodeState{{0, 0, 0}, 0});
+        }
+        TrajectoryWriter::NodeState &state = nodes[sample.node];
+        for (int axis = 0; axis < 3; ++axis) {
+            ok = ok && getSigned(in, end, delta);
+            state.position[axis] = static_cast<int32_t>(state.position[axis] + delta);
+            sample.position[axis] = state.position[axis];
+        }
+        if (sample.kind == TrajectorySample::CourseChange) {
+            for (int axis = 0; axis < 3; ++axis) {
+                ok = ok && getSigned(in, end, delta);
+                sample.velocity[axis] = static_cast<int32_t>(delta);
+            }
+        }
+        if (!ok) {
+            throw std::runtime_error("Corrupt trajectory block " + std::to_string(block));
+        }
+        out.push_back(sample);
+    }
+}
@@ -0,0 +1,80 @@
+#include <monadcount_sim/core/TrajectoryRecorder.hpp>
+
+#include <ns3/log.h>
+#include <ns3/node.h>
+#include <ns3/simulator.h>
+
+#include <cmath>
+#include <stdexcept>
+
+NS_LOG_COMPONENT_DEFINE ("TrajectoryRecorder");
+
+namespace {
+    int32_t toUnits(double metres) {
+        return static_cast<int32_t>(std::lround(metres * monadcount_sim::core::kTrajectoryUnitsPerMetre));
+    }
+
+    void setVector(int32_t (&out)[3], const ns3::Vector &value) {
+        out[0] = toUnits(value.x);
+        out[1] = toUnits(value.y);
+        out[2] = toUnits(value.z);
+    }
+
+    // Checked in the member initialiser list, before the writer creates the file and starts its thread.
+    ns3::Time checkedPeriod(ns3::Time period) {
+        if (!period.IsStrictlyPositive()) {
+            throw std::invalid_argument("Trajectory sample period must be positive");
+        }
+        return period;
+    }
+}
+
+monadcount_sim::core::TrajectoryRecorder::TrajectoryRecorder(const std::string &path, ns3::Time period)
+        : m_writer(path, checkedPeriod(period).GetNanoSeconds()),
+          m_period(period) {
+}
+
+void monadcount_sim::core::TrajectoryRecorder::Add(const ns3::NodeContainer &nodes) {
+    for (uint32_t i = 0; i < nodes.GetN(); ++i) {
+        ns3::Ptr<ns3::Node> node = nodes.Get(i);
+        ns3::Ptr<ns3::MobilityModel> model = node->GetObject<ns3::MobilityModel>();
+        if (!model) {
+            throw std::runtime_error("Node " + std::to_string(node->GetId()) + " has no mobility model to record");
+        }
+        m_nodeIds.push_back(node->GetId());
+        m_models.push_back(model);
+        model->TraceConnectWithoutContext(
+                "CourseChange", ns3::MakeCallback(&TrajectoryRecorder::OnCourseChange, this).Bind(node->GetId()));
+    }
+}
+
+void monadcount_sim::core::TrajectoryRecorder::Start() {
+    NS_LOG_INFO("Recording " << m_models.size() << " trajectories every " << m_period.GetSeconds() << " s");
+    ns3::Simulator::ScheduleNow(&TrajectoryRecorder::SampleAll, this);
+}
+
+bool monadcount_sim::core::TrajectoryRecorder::Close() {
+    return m_writer.Close();
+}
+
+void monadcount_sim::core::TrajectoryRecorder::SampleAll() {
+    TrajectorySample sample;
+    sample.timeNs = ns3::Simulator::Now().GetNanoSeconds();
+    sample.kind = TrajectorySample::Position;
+    for (std::size_t i = 0; i < m_models.size(); ++i) {
+        sample.node = m_nodeIds[i];
+        setVector(sample.position, m_models[i]->GetPosition());
+        m_writer.Append(sample);
+    }
+    ns3::Simulator::Schedule(m_period, &TrajectoryRecorder::SampleAll, this);
+}
+
+void monadcount_sim::core::TrajectoryRecorder::OnCourseChange(uint32_t node, ns3::Ptr<const ns3::MobilityModel> model) {
+    TrajectorySample sample;
+    sample.timeNs = ns3::Simulator::Now().GetNanoSeconds();
+    sample.node = node;
+    sample.kind = TrajectorySample::CourseChange;
+    setVector(sample.position, model->GetPosition());
+    setVector(sample.velocity, model->GetVelocity());
+    m_writer.Append(sample);
+}
@@ -2,10 +2,11 @@
 #include <ns3/simulator.h>
 #include <ns3/boolean.h>
 #include <ns3/log.h>
+#include <ns3/node.h>
+#include <cmath>
 #ifdef WITH_NETSIMULYZER
 #include <ns3/netsimulyzer-module.h>
 #endif
-#include <sstream>
 
 namespace monadcount_sim::core {
 
@@ -25,6 +26,7 @@ namespace monadcount_sim::core {
 #ifdef WITH_NETANIM
     void VisualizationManager::EnableNetAnim(const std::string& filename) {
         m_anim = new AnimationInterface(filename);
+        m_enabled = true;
     }
 #endif
 
@@ -34,20 +36,33 @@ namespace monadcount_sim::core {
         m_orchestrator = CreateObject<netsimulyzer::Orchestrator>(filename);
         m_logStream = CreateObject<netsimulyzer::LogStream>(m_orchestrator);
         m_nodeHelper = std::make_unique<netsimulyzer::NodeConfigurationHelper>(m_orchestrator);
+        m_enabled = true;
     }
 #endif
 
+    void VisualizationManager::EnableNetAnimPositions(const std::string& filename, Time interval) {
+        m_animPositions = std::make_unique<NetAnimPositionWriter>(filename);
+        m_animInterval = interval;
+        m_enabled = true;
+    }
+
     void VisualizationManager::RegisterGroup(const std::string& groupId,
                                              const NodeContainer& nodes,
                                              const GroupVisualConfig& config) {
-        Group group;
+        auto [it, inserted] = m_groupIndex.emplace(groupId, static_cast<uint32_t>(m_groups.size()));
+        if (inserted) {
+            m_groups.emplace_back();
+        }
+        Group& group = m_groups[it->second];
         group.nodes = nodes;
         group.config = config;
-        m_groups[groupId] = group;
 
         for (uint32_t i = 0; i < nodes.GetN(); ++i) {
-            Ptr<Node> node = nodes.Get(i);
-            m_nodeToGroup[node->GetId()] = groupId;
+            uint32_t nodeId = nodes.Get(i)->GetId();
+            if (nodeId >= m_nodes.size()) {
+                m_nodes.resize(nodeId + 1);
+            }
+            m_nodes[nodeId].group = static_cast<int32_t>(it->second);
         }
     }
 
@@ -55,64 +70,154 @@ namespace monadcount_sim::core {
 #ifdef WITH_NETSIMULYZER
         // Initialize NetSimulyzer groups
         if (m_nodeHelper) {
-            for (const auto& [groupId, group] : m_groups) {
+            for (const auto& group : m_groups) {
                 const auto& config = group.config;
                 m_nodeHelper->Set("Model", StringValue(config.nodeModel));
                 m_nodeHelper->Set("EnableMotionTrail", BooleanValue(config.enableTrail));
                 m_nodeHelper->Install(group.nodes);
+                for (uint32_t i = 0; i < group.nodes.GetN(); ++i) {
+                    Ptr<Node> node = group.nodes.Get(i);
+                    m_nodes[node->GetId()].netsimConfig = node->GetObject<netsimulyzer::NodeConfiguration>();
+                }
             }
         }
 #endif
+        bool netanim = m_animPositions != nullptr;
 #ifdef WITH_NETANIM
+        netanim = netanim || m_anim;
+#endif
         // Initialize NetAnim groups
-        if (m_anim) {
-            for (const auto& [groupId, group] : m_groups) {
+        if (netanim) {
+            if (m_animPositions) {
+                // The decimated trace declares every node before its first update.
+                for (const auto& group : m_groups) {
+                    for (uint32_t i = 0; i < group.nodes.GetN(); ++i) {
+                        Ptr<Node> node = group.nodes.Get(i);
+                        Ptr<MobilityModel> mobility = node->GetObject<MobilityModel>();
+                        Vector position = mobility ? mobility->GetPosition() : Vector();
+                        m_animPositions->AddNode(node->GetId(), position.x, position.y);
+                        if (mobility) {
+                            m_sampledNodes.push_back({node->GetId(), mobility, position.x, position.y});
+                        }
+                    }
+                }
+            }
+            for (const auto& group : m_groups) {
                 const auto& config = group.config;
                 for (uint32_t i = 0; i < group.nodes.GetN(); ++i) {
                     uint32_t nodeId = group.nodes.Get(i)->GetId();
+                    NodeState& state = m_nodes[nodeId];
                     auto [r, g, b] = config.netanimColorFunc(nodeId, 0);
-                    m_anim->UpdateNodeColor(nodeId, r, g, b);
+#ifdef WITH_NETANIM
+                    if (m_anim) {
+                        m_anim->UpdateNodeColor(nodeId, r, g, b);
+                    }
+#endif
+                    if (m_animPositions) {
+                        m_animPositions->UpdateColor(0.0, nodeId, r, g, b);
+                        if (!config.labelPrefix.empty()) {
+                            m_animPositions->UpdateDescription(0.0, nodeId, config.labelPrefix + " " + std::to_string(i));
+                        }
+                    }
+                    state.netanimColor = {r, g, b};
+                    state.requestedAp = state.appliedAp = 0;
                 }
             }
+            if (m_animPositions && !m_sampledNodes.empty()) {
+                Simulator::Schedule(m_animInterval, &VisualizationManager::SamplePositions, this);
+            }
         }
-#endif
+    }
+
+    void VisualizationManager::SamplePositions() {
+        // Sub-centimetre moves would not show in NetAnim and are below the writer's precision anyway.
+        constexpr double kMinMove = 0.01;
+        const double now = Simulator::Now().GetSeconds();
+        for (SampledNode& sampled : m_sampledNodes) {
+            Vector position = sampled.mobility->GetPosition();
+            if (std::abs(position.x - sampled.x) < kMinMove && std::abs(position.y - sampled.y) < kMinMove) continue;
+            m_animPositions->UpdatePosition(now, sampled.nodeId, position.x, position.y);
+            sampled.x = position.x;
+            sampled.y = position.y;
+            ++m_positionWrites;
+        }
+        Simulator::Schedule(m_animInterval, &VisualizationManager::SamplePositions, this);
     }
 
     void VisualizationManager::OnNodeAssociated(uint32_t nodeId, int apId) {
-        auto it = m_nodeToGroup.find(nodeId);
-        if (it == m_nodeToGroup.end()) return;
+        ++m_updates;
+        if (!m_enabled || nodeId >= m_nodes.size()) return;
+
+        NodeState& state = m_nodes[nodeId];
+        if (state.group < 0 || state.requestedAp == apId) return;
+
+        state.requestedAp = apId;
+        if (!state.pending) {
+            state.pending = true;
+            m_pending.push_back(nodeId);
+        }
+        if (!m_flushScheduled) {
+            // Runs after everything already scheduled for this instant, e.g. the rest of a handover tick.
+            m_flushScheduled = true;
+            Simulator::ScheduleNow(&VisualizationManager::Flush, this);
+        }
+    }
 
-        const auto& groupId = it->second;
-        const auto& config = m_groups.at(groupId).config;
+    void VisualizationManager::Flush() {
+        m_flushScheduled = false;
+        for (uint32_t nodeId : m_pending) {
+            NodeState& state = m_nodes[nodeId];
+            state.pending = false;
+            if (state.requestedAp == state.appliedAp) continue;
+            state.appliedAp = state.requestedAp;
+            [[maybe_unused]] const auto& config = m_groups[state.group].config;
 
 // Update NetAnim visualization if enabled
+            bool netanim = m_animPositions != nullptr;
 #ifdef WITH_NETANIM
-        if (m_anim) {
-            auto [r, g, b] = config.netanimColorFunc(nodeId, apId);
-            m_anim->UpdateNodeColor(nodeId, r, g, b);
-        }
+            netanim = netanim || m_anim;
 #endif
+            if (netanim) {
+                auto [r, g, b] = config.netanimColorFunc(nodeId, state.appliedAp);
+                std::array<uint8_t, 3> color{r, g, b};
+                if (color != state.netanimColor) {
+#ifdef WITH_NETANIM
+                    if (m_anim) {
+                        m_anim->UpdateNodeColor(nodeId, r, g, b);
+                    }
+#endif
+                    if (m_animPositions) {
+                        m_animPositions->UpdateColor(Simulator::Now().GetSeconds(), nodeId, r, g, b);
+                    }
+                    state.netanimColor = color;
+                    ++m_writes;
+                }
+            }
 
 // Update NetSimulyzer visualization if enabled
 #ifdef WITH_NETSIMULYZER
-        if (m_nodeHelper) {
-            auto [rD, gD, bD] = config.netsimColorFunc(nodeId, apId);
-            auto node = NodeList::GetNode(nodeId);
-            auto nodeCfg = node->GetObject<netsimulyzer::NodeConfiguration>();
-            if (nodeCfg) {
-                nodeCfg->SetBaseColor(netsimulyzer::Color3(rD, gD, bD));
+            if (state.netsimConfig) {
+                auto [rD, gD, bD] = config.netsimColorFunc(nodeId, state.appliedAp);
+                std::array<double, 3> color{rD, gD, bD};
+                if (color != state.netsimColor) {
+                    state.netsimConfig->SetBaseColor(netsimulyzer::Color3(rD, gD, bD));
+                    state.netsimColor = color;
+                    ++m_writes;
+                }
             }
-        }
 #endif
+        }
+        m_pending.clear();
     }
 
     void VisualizationManager::OnHandoverEvent(uint32_t nodeId, int fromAp, int toAp, double time) {
 // Log handover event for NetSimulyzer if enabled
 #ifdef WITH_NETSIMULYZER
+        // LogStream stamps and buffers messages itself and must be fed from the simulation thread, so this
+        // writes straight into it; the structured copy of the event goes through core::EventLog.
         if (m_logStream) {
-            std::ostringstream os;
-            os << "[" << time << "s] Node " << nodeId << " handed over: AP" << fromAp << " -> AP" << toAp;
-            *m_logStream << os.str() << "\n";
+            *m_logStream << "[" << time << "s] Node " << nodeId << " handed over: AP" << fromAp << " -> AP" << toAp
+                         << "\n";
         }
 #endif
     }
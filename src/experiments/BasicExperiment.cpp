@@ -11,6 +11,15 @@
 #include "ns3/wifi-module.h"
 #include "ns3/applications-module.h"
 #include "monadcount_sim/core/ScenarioEnvironment.hpp"
+#include "monadcount_sim/wifi/CachedPropagationLossModel.hpp"
+#include "monadcount_sim/wifi/MultiWallPropagationLossModel.hpp"
+#include "monadcount_sim/wifi/WifiCaptureSink.hpp"
+#include "monadcount_sim/wifi/WifiSniffer.hpp"
+#include "monadcount_sim/core/TrajectoryRecorder.hpp"
+#include "monadcount_sim/core/VisualizationManager.hpp"
+
+#include <chrono>
+#include <memory>
 
 using namespace ns3;
 
@@ -21,19 +30,26 @@ BasicExperiment::BasicExperiment()
           m_simulationTime(60.0),
           m_roomLength(50.0),
           m_roomWidth(30.0),
-          // Nakagami, Friis, LogDistance
-          m_propagationModel("Nakagami") // change propagation model here
+          // Nakagami, Friis, LogDistance, MultiWall
+          m_propagationModel("Nakagami"), // change propagation model here
+          m_pathLossCacheResolution(0.0)
 {
 }
 
 void BasicExperiment::SetPropagationModel(const std::string& model)
 {
-    if (model != "Nakagami" && model != "Friis" && model != "LogDistance") {
+    if (model != "Nakagami" && model != "Friis" && model != "LogDistance" && model != "MultiWall") {
         NS_ABORT_MSG("BasicExperiment: unknown propagation model " << model);
     }
     m_propagationModel = model;
 }
 
+void BasicExperiment::SetPathLossCache(double resolution)
+{
+    NS_ABORT_MSG_IF(resolution < 0.0, "BasicExperiment: negative path loss cache resolution " << resolution);
+    m_pathLossCacheResolution = resolution;
+}
+
 void BasicExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
 {
     // --------------------------------------------------
@@ -60,12 +76,55 @@ void BasicExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
     else if (m_propagationModel == "Friis") {
         channelHelper.AddPropagationLoss("ns3::FriisPropagationLossModel");
     }
+    else if (m_propagationModel == "MultiWall") {
+        // LogDistance path loss plus a fixed loss per wall/table of the scenario on the direct path.
+        Ptr<monadcount_sim::wifi::MultiWallPropagationLossModel> wallLoss =
+                CreateObject<monadcount_sim::wifi::MultiWallPropagationLossModel>();
+        wallLoss->SetObstacles(env.obstacleIndex);
+        wallLoss->SetNext(CreateObject<LogDistancePropagationLossModel>());
+        env.obstacleLossModel = wallLoss;
+        NS_LOG_INFO("Multi-wall loss over " << env.obstacles.size() << " obstacles ("
+                    << env.obstacleIndex.GetSegmentCount() << " edges)");
+    }
     else { // LogDistance
         channelHelper.AddPropagationLoss("ns3::LogDistancePropagationLossModel");
     }
 
+    Ptr<PropagationLossModel> lossModel = env.obstacleLossModel;
+    Ptr<monadcount_sim::wifi::CachedPropagationLossModel> lossCache;
+    if (m_pathLossCacheResolution > 0.0) {
+        // Same chain as the helper builds (Default() starts with LogDistance), split into the deterministic
+        // part, which is cached per AP, and the fading, which is still drawn per frame.
+        Ptr<PropagationLossModel> deterministic = env.obstacleLossModel;
+        Ptr<PropagationLossModel> fading;
+        if (!deterministic) {
+            deterministic = CreateObject<LogDistancePropagationLossModel>();
+            if (m_propagationModel == "Nakagami") {
+                fading = CreateObject<NakagamiPropagationLossModel>();
+            }
+            else if (m_propagationModel == "Friis") {
+                deterministic->SetNext(CreateObject<FriisPropagationLossModel>());
+            }
+            else {
+                deterministic->SetNext(CreateObject<LogDistancePropagationLossModel>());
+            }
+        }
+        lossCache = CreateObject<monadcount_sim::wifi::CachedPropagationLossModel>();
+        lossCache->SetAttribute("Resolution", DoubleValue(m_pathLossCacheResolution));
+        lossCache->SetModel(deterministic);
+        if (fading) {
+            lossCache->SetNext(fading);
+        }
+        lossModel = lossCache;
+    }
+
     Ptr<YansWifiChannel> channel1 = channelHelper.Create();
     Ptr<YansWifiChannel> channel2 = channelHelper.Create();
+    if (lossModel) {
+        // The helper only builds loss chains from type names; a prebuilt chain replaces it.
+        channel1->SetPropagationLossModel(lossModel);
+        channel2->SetPropagationLossModel(lossModel);
+    }
 
     YansWifiPhyHelper phy1;
     phy1.SetErrorRateModel("ns3::NistErrorRateModel");
@@ -228,15 +287,62 @@ void BasicExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
     // --------------------------------------------------
     // 7) Tracing (PCAP)
     // --------------------------------------------------
-    // We'll enable pcap on the device(s) for each AP
-    phy1.SetPcapDataLinkType (YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
-    phy1.EnablePcap("data/basic/ap1", apDevice1);
-
-    phy2.SetPcapDataLinkType (YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
-    phy2.EnablePcap("data/basic/ap2", apDevice2);
+    // We'll capture the device(s) of each AP
+    std::unique_ptr<monadcount_sim::wifi::WifiCaptureSink> capture;
+    if (m_captureOptions.format == monadcount_sim::core::CaptureOptions::Format::Pcapng) {
+        capture = std::make_unique<monadcount_sim::wifi::WifiCaptureSink>(
+                std::string("data/basic/capture.pcapng")
+                + monadcount_sim::core::CaptureCompressionSuffix(m_captureOptions.compression),
+                m_captureOptions.compression);
+        auto filter = monadcount_sim::wifi::WifiCaptureSink::MakeFilter(m_captureOptions);
+        capture->AddDevices(apDevice1, "ap1", filter);
+        capture->AddDevices(apDevice2, "ap2", filter);
+    } else if (m_captureOptions.format == monadcount_sim::core::CaptureOptions::Format::PcapPerDevice) {
+        phy1.SetPcapDataLinkType (YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
+        phy1.EnablePcap("data/basic/ap1", apDevice1);
+
+        phy2.SetPcapDataLinkType (YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
+        phy2.EnablePcap("data/basic/ap2", apDevice2);
+    }
+    // Scenario sniffers get a radio on each channel and log what they overhear, one row per frame
+    std::unique_ptr<monadcount_sim::wifi::WifiSniffer> sniffer;
+    if (env.snifferNodes.GetN() > 0) {
+        sniffer = std::make_unique<monadcount_sim::wifi::WifiSniffer>("data/basic/probes.arrow");
+        sniffer->SetFrameTypes(m_captureOptions.frameTypes);
+        sniffer->Install(wifi, phy1, env.snifferNodes);
+        sniffer->Install(wifi, phy2, env.snifferNodes);
+    }
+    // Ground-truth pedestrian positions
+    std::unique_ptr<monadcount_sim::core::TrajectoryRecorder> trajectories;
+    if (m_captureOptions.trajectoryPeriod > 0.0) {
+        trajectories = std::make_unique<monadcount_sim::core::TrajectoryRecorder>(
+                "data/basic/trajectories.traj", Seconds(m_captureOptions.trajectoryPeriod));
+        trajectories->Add(wifiStaNodes1);
+        trajectories->Add(wifiStaNodes2);
+        trajectories->Start();
+    }
+    // NetAnim: positions and colours only for long runs, otherwise full packet animation
+    std::unique_ptr<monadcount_sim::core::VisualizationManager> viz;
+    if (m_captureOptions.netanimInterval > 0.0) {
+        viz = std::make_unique<monadcount_sim::core::VisualizationManager>();
+        viz->EnableNetAnimPositions("data/basic/netanim.xml", Seconds(m_captureOptions.netanimInterval));
+        monadcount_sim::core::VisualizationManager::GroupVisualConfig apConfig;
+        apConfig.labelPrefix = "AP";
+        apConfig.netanimColorFunc = [](uint32_t, int) { return std::make_tuple(0, 0, 255); };
+        monadcount_sim::core::VisualizationManager::GroupVisualConfig staConfig;
+        staConfig.labelPrefix = "STA";
+        staConfig.netanimColorFunc = [](uint32_t, int) { return std::make_tuple(255, 0, 0); };
+        viz->RegisterGroup("aps", wifiApNodes, apConfig);
+        viz->RegisterGroup("stas1", wifiStaNodes1, staConfig);
+        viz->RegisterGroup("stas2", wifiStaNodes2, staConfig);
+        viz->Initialize();
+    }
     #ifdef WITH_NETANIM
-        AnimationInterface anim("data/basic/netanim.xml");
-        anim.SetMaxPktsPerTraceFile(500000);
+    std::unique_ptr<AnimationInterface> anim;
+    if (!viz) {
+        anim = std::make_unique<AnimationInterface>("data/basic/netanim.xml");
+        anim->SetMaxPktsPerTraceFile(500000);
+    }
     #endif
 
     // --------------------------------------------------
@@ -244,7 +350,39 @@ void BasicExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
     // --------------------------------------------------
     Simulator::Stop(Seconds(m_simulationTime));
     NS_LOG_INFO("Running Simulation with " << m_propagationModel << " model...");
+    auto wallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    ReportMetric("events", static_cast<double>(Simulator::GetEventCount()));
+    ReportMetric("simulate_seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count());
+    if (capture) {
+        if (!capture->Close()) {
+            NS_LOG_ERROR("Writing the capture file failed");
+        }
+        NS_LOG_INFO("Captured " << capture->GetStats().frames << " frames, " << capture->GetFilteredFrames()
+                    << " filtered out");
+        ReportMetric("captured_frames", static_cast<double>(capture->GetStats().frames));
+    }
+    if (sniffer) {
+        if (!sniffer->Close()) {
+            NS_LOG_ERROR("Writing the sniffer records failed");
+        }
+        NS_LOG_INFO("Sniffers recorded " << sniffer->GetRecords() << " frames (" << sniffer->GetBytes() / 1024
+                    << " KiB)");
+        ReportMetric("sniffer_records", static_cast<double>(sniffer->GetRecords()));
+    }
+    if (trajectories && !trajectories->Close()) {
+        NS_LOG_ERROR("Writing the trajectory file failed");
+    }
+    if (lossCache) {
+        monadcount_sim::wifi::PathLossCacheStats stats = lossCache->GetStats();
+        uint64_t lookups = stats.hits + stats.misses;
+        NS_LOG_INFO("Path loss cache: " << stats.hits << "/" << lookups << " hits, " << stats.bypasses
+                    << " uncached links, " << stats.tiles << " tiles (" << stats.bytes / 1024 << " KiB), "
+                    << stats.evictions << " evictions");
+    }
+    if (viz) {
+        NS_LOG_INFO("NetAnim: " << viz->GetPositionCount() << " position updates");
+    }
     Simulator::Destroy();
     NS_LOG_INFO("Simulation complete.");
 }
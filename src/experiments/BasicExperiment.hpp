@@ -11,6 +11,13 @@ public:
 
     void SetPropagationModel(const std::string& model);
 
+    // Serve deterministic path loss of the static APs from cached maps with this lattice spacing (m);
+    // 0 disables the cache.
+    void SetPathLossCache(double resolution);
+
+    void SetSimulationTime(double seconds) override { m_simulationTime = seconds; }
+    void SetNumPedestrians(uint32_t count) override { m_numPedestrians = count; }
+
 protected:
     void Run(monadcount_sim::core::ScenarioEnvironment& env) override;
 
@@ -21,6 +28,7 @@ private:
     double   m_roomWidth;
 
     std::string m_propagationModel;
+    double      m_pathLossCacheResolution;
 };
 
 #endif // MONADCOUNT_SIM_BASICEXPERIMENT_HPP
@@ -7,7 +7,12 @@
 #include "ns3/wifi-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/random-variable-stream.h"
+#include "monadcount_sim/wifi/WifiCaptureSink.hpp"
+#include "monadcount_sim/wifi/WifiSniffer.hpp"
+#include "monadcount_sim/core/TrajectoryRecorder.hpp"
 
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <random>
 #include <cmath>
@@ -17,10 +22,15 @@
 NS_LOG_COMPONENT_DEFINE("DoorToDoorExperiment");
 
 void
-DoorToDoorExperiment::LogEvent(uint32_t id, const std::string& what)
+DoorToDoorExperiment::LogDelivery(uint32_t id, uint32_t apId)
 {
-    NS_LOG_INFO("Time=" << ns3::Simulator::Now().GetSeconds()
-                        << "s: Pedestrian " << id << " " << what);
+    m_events->Post(m_deliveryEvent, id, apId);
+}
+
+void
+DoorToDoorExperiment::LogExit(uint32_t id)
+{
+    m_events->Post(m_exitEvent, id);
 }
 
 DoorToDoorExperiment::DoorToDoorExperiment()
@@ -159,9 +169,43 @@ DoorToDoorExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
     //
     ::mkdir("data",            0755);
     ::mkdir("data/doortodoor", 0755);
-    phy.SetPcapDataLinkType(YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
-    phy.EnablePcap("data/doortodoor/ap",  apDevs);
-    phy.EnablePcap("data/doortodoor/sta", staDevs);
+    std::unique_ptr<monadcount_sim::wifi::WifiCaptureSink> capture;
+    if (m_captureOptions.format == monadcount_sim::core::CaptureOptions::Format::Pcapng) {
+        capture = std::make_unique<monadcount_sim::wifi::WifiCaptureSink>(
+                std::string("data/doortodoor/capture.pcapng")
+                + monadcount_sim::core::CaptureCompressionSuffix(m_captureOptions.compression),
+                m_captureOptions.compression);
+        auto filter = monadcount_sim::wifi::WifiCaptureSink::MakeFilter(m_captureOptions);
+        capture->AddDevices(apDevs, "ap", filter);
+        capture->AddDevices(staDevs, "sta", filter);
+    } else if (m_captureOptions.format == monadcount_sim::core::CaptureOptions::Format::PcapPerDevice) {
+        phy.SetPcapDataLinkType(YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
+        phy.EnablePcap("data/doortodoor/ap",  apDevs);
+        phy.EnablePcap("data/doortodoor/sta", staDevs);
+    }
+
+    // Scenario sniffers listen on the same channel and log one row per overheard frame
+    std::unique_ptr<monadcount_sim::wifi::WifiSniffer> sniffer;
+    if (env.snifferNodes.GetN() > 0 && !IsReplicating()) {
+        sniffer = std::make_unique<monadcount_sim::wifi::WifiSniffer>("data/doortodoor/probes.arrow");
+        sniffer->SetFrameTypes(m_captureOptions.frameTypes);
+        sniffer->Install(wifi, phy, env.snifferNodes);
+    }
+
+    // Ground-truth pedestrian positions, waypoints included
+    std::unique_ptr<monadcount_sim::core::TrajectoryRecorder> trajectories;
+    if (m_captureOptions.trajectoryPeriod > 0.0) {
+        trajectories = std::make_unique<monadcount_sim::core::TrajectoryRecorder>(
+                "data/doortodoor/trajectories.traj", Seconds(m_captureOptions.trajectoryPeriod));
+        trajectories->Add(pedNodes);
+        trajectories->Start();
+    }
+
+    // Pedestrian events; with no output enabled, posting them costs a branch
+    m_events = std::make_unique<monadcount_sim::core::EventLog>(m_captureOptions.eventLog,
+                                                                "data/doortodoor/events");
+    m_deliveryEvent = m_events->Intern("DoorToDoor.delivery", "Pedestrian {} delivering to AP#{}");
+    m_exitEvent = m_events->Intern("DoorToDoor.exit", "Pedestrian {} exited via door");
 
     //
     // 10) Random variables
@@ -246,11 +290,11 @@ DoorToDoorExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
                                         m_simulationTime)));
 
             // log delivery
-            Simulator::Schedule(Seconds(now),
-                                &DoorToDoorExperiment::LogEvent,
-                                i,
-                                std::string("delivering to AP#")
-                                + std::to_string(bestAp));
+            if (m_events->IsEnabled()) {
+                Simulator::Schedule(Seconds(now),
+                                    &DoorToDoorExperiment::LogDelivery,
+                                    this, i, bestAp);
+            }
         }
 
         // d) dwell
@@ -269,10 +313,11 @@ DoorToDoorExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
             double dt = bestD2 / speedRv->GetValue();
             double tExit = std::min(now + dt, m_simulationTime);
             wmm->AddWaypoint(Waypoint(Seconds(tExit), exitDoor));
-            Simulator::Schedule(Seconds(tExit),
-                                &DoorToDoorExperiment::LogEvent,
-                                i,
-                                std::string("exited via door"));
+            if (m_events->IsEnabled()) {
+                Simulator::Schedule(Seconds(tExit),
+                                    &DoorToDoorExperiment::LogExit,
+                                    this, i);
+            }
             if (tExit < m_simulationTime) {
                 wmm->AddWaypoint(
                         Waypoint(Seconds(m_simulationTime), exitDoor)
@@ -285,7 +330,40 @@ DoorToDoorExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
     // 12) Run
     //
     Simulator::Stop(Seconds(m_simulationTime));
-    Simulator::Run();
+    auto wallStart = std::chrono::steady_clock::now();
+    // Replicas draw new Wi-Fi streams (backoff, error models, rate control); the waypoint plans scheduled
+    // above are deterministic from here on and shared by every replica.
+    bool ranHere = RunSimulation([&]() {
+        int64_t stream = 0;
+        stream += wifi.AssignStreams(apDevs, stream);
+        wifi.AssignStreams(staDevs, stream);
+    });
+    if (!ranHere) {
+        Simulator::Destroy();
+        return;
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    NS_LOG_INFO(Simulator::GetEventCount() << " events in " << wallSeconds << " s ("
+                << Simulator::GetEventCount() / wallSeconds << " events/s)");
+    ReportMetric("events", static_cast<double>(Simulator::GetEventCount()));
+    ReportMetric("simulate_seconds", wallSeconds);
+    if (capture && !capture->Close()) {
+        NS_LOG_ERROR("Writing the capture file failed");
+    }
+    if (sniffer) {
+        if (!sniffer->Close()) {
+            NS_LOG_ERROR("Writing the sniffer records failed");
+        }
+        NS_LOG_INFO("Sniffers recorded " << sniffer->GetRecords() << " frames (" << sniffer->GetBytes() / 1024
+                    << " KiB)");
+        ReportMetric("sniffer_records", static_cast<double>(sniffer->GetRecords()));
+    }
+    if (trajectories && !trajectories->Close()) {
+        NS_LOG_ERROR("Writing the trajectory file failed");
+    }
+    if (!m_events->Close()) {
+        NS_LOG_ERROR("Writing the event log failed");
+    }
     Simulator::Destroy();
 
     NS_LOG_INFO("Door-to-Door Wi-Fi experiment complete.");
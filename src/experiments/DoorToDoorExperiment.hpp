@@ -1,8 +1,10 @@
 #ifndef MONADCOUNT_SIM_DOORTODOOREXPERIMENT_HPP
 #define MONADCOUNT_SIM_DOORTODOOREXPERIMENT_HPP
 
+#include "monadcount_sim/core/EventLog.hpp"
 #include "monadcount_sim/core/Scenario.hpp"
 #include <cstdint>
+#include <memory>
 #include <string>
 
 namespace monadcount_sim {
@@ -15,7 +17,10 @@ public:
     ~DoorToDoorExperiment() override = default;
 
     /// How many pedestrians to spawn (default 50)
-    void SetNumPedestrians(uint32_t n) { m_numPedestrians = n; }
+    void SetNumPedestrians(uint32_t n) override { m_numPedestrians = n; }
+
+    /// Simulated seconds (default 60)
+    void SetSimulationTime(double seconds) override { m_simulationTime = seconds; }
 
 protected:
     void Run(monadcount_sim::core::ScenarioEnvironment &env) override;
@@ -27,8 +32,14 @@ private:
     double   m_roomLength;
     double   m_roomWidth;
 
-    /// Internal logger
-    static void LogEvent(uint32_t pedId, const std::string &what);
+    /// Structured event log (CaptureOptions::eventLog) and its event codes
+    std::unique_ptr<monadcount_sim::core::EventLog> m_events;
+    uint32_t m_deliveryEvent = 0;
+    uint32_t m_exitEvent = 0;
+
+    /// Internal loggers, scheduled at the time of the event
+    void LogDelivery(uint32_t pedId, uint32_t apId);
+    void LogExit(uint32_t pedId);
 };
 
 #endif // MONADCOUNT_SIM_DOORTODOOREXPERIMENT_HPP
@@ -15,13 +15,14 @@ void GaussMarkovHandoverExperiment::Run(monadcount_sim::core::ScenarioEnvironmen
 {
     NS_LOG_INFO("Setting up Gauss-Markov Handover Experiment...");
 
-    SetupNodes();
+    SetupNodes(env);
     SetupWifi();
     SetupMobility();  // overridden
     SetupInternet();
     SetupApplications();
     SetupTracing();
     SetupVisualization();
+    SetupHandover();
 
     Simulator::Schedule(Seconds(1.0), &GaussMarkovHandoverExperiment::CheckRssiAndTriggerHandover, this);
 
@@ -33,13 +34,16 @@ void GaussMarkovHandoverExperiment::Run(monadcount_sim::core::ScenarioEnvironmen
 
 void GaussMarkovHandoverExperiment::SetupMobility()
 {
-    // (a) APs are stationary
-    MobilityHelper mobilityAp;
-    mobilityAp.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-    mobilityAp.Install(m_wifiApNodes);
-
-    m_wifiApNodes.Get(0)->GetObject<MobilityModel>()->SetPosition(Vector(5.0, m_roomWidth / 2.0, 2.0));
-    m_wifiApNodes.Get(1)->GetObject<MobilityModel>()->SetPosition(Vector(45.0, m_roomWidth / 2.0, 2.0));
+    // (a) APs are stationary (scenario APs were placed by the environment builder)
+    if (!m_apsFromScenario)
+    {
+        MobilityHelper mobilityAp;
+        mobilityAp.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobilityAp.Install(m_wifiApNodes);
+
+        m_wifiApNodes.Get(0)->GetObject<MobilityModel>()->SetPosition(Vector(5.0, m_roomWidth / 2.0, 2.0));
+        m_wifiApNodes.Get(1)->GetObject<MobilityModel>()->SetPosition(Vector(45.0, m_roomWidth / 2.0, 2.0));
+    }
 
     // (b) Pedestrians use Gauss-Markov mobility
     MobilityHelper mobility;
@@ -77,8 +81,13 @@ void GaussMarkovHandoverExperiment::SetupTracing() {
 void GaussMarkovHandoverExperiment::SetupVisualization()
 {
     // Enable visualizations based on build configuration
+    if (m_captureOptions.netanimInterval > 0.0) {
+        m_viz.EnableNetAnimPositions("data/gauss-markov-handover/netanim.xml", Seconds(m_captureOptions.netanimInterval));
+    }
 #ifdef WITH_NETANIM
-    m_viz.EnableNetAnim("data/gauss-markov-handover/netanim.xml");
+    else {
+        m_viz.EnableNetAnim("data/gauss-markov-handover/netanim.xml");
+    }
 #endif
 #ifdef WITH_NETSIMULYZER
     m_viz.EnableNetSimulyzer("data/gauss-markov-handover/simulyzer.json");
@@ -5,6 +5,7 @@
 #include <ns3/double.h>
 #include <ns3/boolean.h>
 #include <ns3/uinteger.h>
+#include <chrono>
 #include <cmath>
 #include <sstream>
 
@@ -20,51 +21,119 @@ HandoverExperiment::HandoverExperiment()
           m_handoverMargin(5.0),
           m_txPower_dBm(20.0),
           m_pathLossExponent(3.0),
+          m_eventDriven(false),
+          m_apsFromScenario(false),
+          m_handover(m_txPower_dBm, m_pathLossExponent, m_handoverMargin, Seconds(5.0)),
+          m_rssiMonitor(0.1, Seconds(1.0)),
+          m_reassociations(0),
+          m_reassociationsFromCache(0),
+          m_scannedHandovers(0),
+          m_scannedReassociations(0),
+          m_cachePathMismatches(0),
+          m_handoverEvent(0),
+          m_reassociationEvent(0),
           m_anim(nullptr) {}
 
+void HandoverExperiment::SetEventDrivenHandover(bool enabled) {
+    m_eventDriven = enabled;
+}
+
 void HandoverExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env) {
     NS_LOG_INFO("Setting up RSSI-based Handover Experiment...");
 
-    SetupNodes();
+    SetupNodes(env);
     SetupWifi();
     SetupMobility();
     SetupInternet();
     SetupApplications();
     SetupTracing();
     SetupVisualization();
+    SetupHandover();
 
-    Simulator::Schedule(Seconds(1.0), &HandoverExperiment::CheckRssiAndTriggerHandover, this);
+    if (m_eventDriven) {
+        m_handover.StartEventDriven(Seconds(m_simulationTime));
+    } else {
+        Simulator::Schedule(Seconds(1.0), &HandoverExperiment::CheckRssiAndTriggerHandover, this);
+    }
     Simulator::Stop(Seconds(m_simulationTime));
-    Simulator::Run();
+    auto wallStart = std::chrono::steady_clock::now();
+    if (!RunSimulation([this]() { ReseedStreams(); })) {
+        // Replicated: the forked replicas ran the simulation and reported it.
+        Simulator::Destroy();
+        return;
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    NS_LOG_INFO(Simulator::GetEventCount() << " events in " << wallSeconds << " s ("
+                << Simulator::GetEventCount() / wallSeconds << " events/s)");
+    ReportMetric("events", static_cast<double>(Simulator::GetEventCount()));
+    ReportMetric("simulate_seconds", wallSeconds);
+    if (m_capture) {
+        if (!m_capture->Close()) {
+            NS_LOG_ERROR("Writing the capture file failed");
+        }
+        auto stats = m_capture->GetStats();
+        NS_LOG_INFO("Captured " << stats.frames << " frames (" << m_capture->GetFilteredFrames() << " filtered out), "
+                    << stats.capturedBytes / 1024 << " KiB pcapng, " << stats.writtenBytes / 1024 << " KiB written, "
+                    << stats.stalls << " writer stalls");
+    }
+    if (m_sniffer) {
+        if (!m_sniffer->Close()) {
+            NS_LOG_ERROR("Writing the sniffer records failed");
+        }
+        NS_LOG_INFO("Sniffers recorded " << m_sniffer->GetRecords() << " frames (" << m_sniffer->GetBytes() / 1024
+                    << " KiB)");
+        ReportMetric("sniffer_records", static_cast<double>(m_sniffer->GetRecords()));
+    }
+    if (m_trajectories) {
+        if (!m_trajectories->Close()) {
+            NS_LOG_ERROR("Writing the trajectory file failed");
+        }
+        auto stats = m_trajectories->GetStats();
+        NS_LOG_INFO("Trajectories: " << stats.samples << " samples, " << stats.bytes / 1024 << " KiB, "
+                    << stats.stalls << " writer stalls");
+    }
+    if (!m_events->Close()) {
+        NS_LOG_ERROR("Writing the event log failed");
+    }
+    NS_LOG_INFO("Handover checks: " << m_handover.GetChecks() << " station x AP evaluations for "
+                << m_handover.GetStationCount() << " pedestrians and " << m_handover.GetApCount() << " APs"
+                << (m_eventDriven ? " (event-driven)" : " (polling)"));
+    NS_LOG_INFO("Measured RSSI samples: " << m_rssiMonitor.GetSamples());
+    ReportMetric("handover_checks", static_cast<double>(m_handover.GetChecks()));
+    ReportMetric("reassociations", static_cast<double>(m_reassociations));
+    ReportMetric("scanned_handovers", static_cast<double>(m_scannedHandovers));
+    ReportMetric("scanned_reassociations", static_cast<double>(m_scannedReassociations));
+    ReportMetric("cache_path_mismatches", static_cast<double>(m_cachePathMismatches));
+    if (m_cachePathMismatches > 0) {
+        NS_LOG_ERROR(m_cachePathMismatches << " reassociations reported a different path (cached/scanned) than "
+                     "their handover took");
+    }
+    if (m_scannedHandovers > 0 && m_scannedReassociations == 0) {
+        NS_LOG_ERROR("None of " << m_scannedHandovers << " handovers to uncached APs produced a Reassociated trace");
+    }
+    NS_LOG_INFO("Visualization: " << m_viz.GetUpdateCount() << " association updates, " << m_viz.GetWriteCount()
+                << " colour writes, " << m_viz.GetPositionCount() << " NetAnim position updates");
+    if (m_reassociations > 0) {
+        NS_LOG_INFO("Reassociations: " << m_reassociations << ", " << m_reassociationsFromCache
+                    << " without a scan, mean time " << (m_reassociationTime / m_reassociations).As(Time::MS));
+    }
     Simulator::Destroy();
     NS_LOG_INFO("Handover Simulation complete.");
 }
 
-double HandoverExperiment::EstimateRssi(const Vector &stationPos, const Vector &apPos) const {
-    double dx = stationPos.x - apPos.x;
-    double dy = stationPos.y - apPos.y;
-    double distance = std::sqrt(dx * dx + dy * dy);
-    if (distance < 1.0) distance = 1.0;
-    return m_txPower_dBm - 10.0 * m_pathLossExponent * std::log10(distance);
-}
-
-void HandoverExperiment::SetupNodes() {
-    m_wifiApNodes.Create(2);
+void HandoverExperiment::SetupNodes(monadcount_sim::core::ScenarioEnvironment &env) {
+    m_apsFromScenario = env.apNodes.GetN() > 0;
+    if (m_apsFromScenario) {
+        m_wifiApNodes = env.apNodes;
+        NS_LOG_INFO("Using " << m_wifiApNodes.GetN() << " APs from the scenario");
+    } else {
+        m_wifiApNodes.Create(2);
+    }
+    m_snifferNodes = env.snifferNodes;
     uint32_t numGroupA = m_numPedestrians / 2;
     uint32_t numGroupB = m_numPedestrians - numGroupA;
     m_groupA.Create(numGroupA);
     m_groupB.Create(numGroupB);
-
-    for (uint32_t i = 0; i < m_groupA.GetN(); ++i) {
-        uint32_t nodeId = m_groupA.Get(i)->GetId();
-        m_nodeAssociation[nodeId] = 1;
-        m_nodeTriggered[nodeId] = false;
-    }
-    for (uint32_t i = 0; i < m_groupB.GetN(); ++i) {
-        uint32_t nodeId = m_groupB.Get(i)->GetId();
-        m_nodeAssociation[nodeId] = 2;
-        m_nodeTriggered[nodeId] = false;
-    }
 }
 
 void HandoverExperiment::SetupWifi() {
@@ -90,18 +159,38 @@ void HandoverExperiment::SetupWifi() {
     NetDeviceContainer staDevicesB = wifi.Install(wifiPhy, macSta, m_groupB);
     m_staDevices.Add(staDevicesB);
 
-    Ptr<WifiNetDevice> ap1Device = DynamicCast<WifiNetDevice>(m_apDevices.Get(0));
-    if (ap1Device) m_ap1Mac = DynamicCast<ApWifiMac>(ap1Device->GetMac());
-    Ptr<WifiNetDevice> ap2Device = DynamicCast<WifiNetDevice>(m_apDevices.Get(1));
-    if (ap2Device) m_ap2Mac = DynamicCast<ApWifiMac>(ap2Device->GetMac());
+    if (m_snifferNodes.GetN() > 0 && !IsReplicating()) {
+        m_sniffer = std::make_unique<monadcount_sim::wifi::WifiSniffer>("data/handover/probes.arrow");
+        m_sniffer->SetFrameTypes(m_captureOptions.frameTypes);
+        m_sniffer->Install(wifi, wifiPhy, m_snifferNodes);
+    }
+
+    for (uint32_t i = 0; i < m_apDevices.GetN(); ++i) {
+        Ptr<WifiNetDevice> apDevice = DynamicCast<WifiNetDevice>(m_apDevices.Get(i));
+        m_apMacs.push_back(apDevice ? DynamicCast<ApWifiMac>(apDevice->GetMac()) : nullptr);
+    }
+
+    for (uint32_t i = 0; i < m_staDevices.GetN(); ++i) {
+        Ptr<WifiNetDevice> staDevice = DynamicCast<WifiNetDevice>(m_staDevices.Get(i));
+        Ptr<StaWifiMac> staMac = DynamicCast<StaWifiMac>(staDevice->GetMac());
+        auto manager = CreateObject<monadcount_sim::wifi::RssiBasedAssocManager>();
+        staMac->SetAssocManager(manager);
+        manager->TraceConnectWithoutContext("Reassociated",
+                                            MakeCallback(&HandoverExperiment::OnReassociated, this).Bind(i));
+        m_assocManagers.push_back(manager);
+    }
+    m_pendingFromCache.assign(m_assocManagers.size(), -1);
 }
 
 void HandoverExperiment::SetupMobility() {
-    MobilityHelper mobilityAp;
-    mobilityAp.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-    mobilityAp.Install(m_wifiApNodes);
-    m_wifiApNodes.Get(0)->GetObject<MobilityModel>()->SetPosition(Vector(5.0, m_roomWidth / 2.0, 2.0));
-    m_wifiApNodes.Get(1)->GetObject<MobilityModel>()->SetPosition(Vector(45.0, m_roomWidth / 2.0, 2.0));
+    // Scenario APs were placed by the environment builder.
+    if (!m_apsFromScenario) {
+        MobilityHelper mobilityAp;
+        mobilityAp.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobilityAp.Install(m_wifiApNodes);
+        m_wifiApNodes.Get(0)->GetObject<MobilityModel>()->SetPosition(Vector(5.0, m_roomWidth / 2.0, 2.0));
+        m_wifiApNodes.Get(1)->GetObject<MobilityModel>()->SetPosition(Vector(45.0, m_roomWidth / 2.0, 2.0));
+    }
 
     MobilityHelper mobility;
     mobility.SetMobilityModel("ns3::ConstantVelocityMobilityModel");
@@ -141,7 +230,7 @@ void HandoverExperiment::SetupInternet() {
 
     Ipv4AddressHelper address;
     address.SetBase("10.1.1.0", "255.255.255.0");
-    address.Assign(m_apDevices);
+    m_apInterfaces = address.Assign(m_apDevices);
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 }
 
@@ -149,19 +238,17 @@ void HandoverExperiment::SetupApplications() {
     uint16_t echoPort = 7;
     UdpEchoServerHelper echoServer(echoPort);
 
-    auto serverApp1 = echoServer.Install(m_wifiApNodes.Get(0));
-    auto serverApp2 = echoServer.Install(m_wifiApNodes.Get(1));
-    serverApp1.Start(Seconds(0.0));
-    serverApp1.Stop(Seconds(m_simulationTime));
-    serverApp2.Start(Seconds(0.0));
-    serverApp2.Stop(Seconds(m_simulationTime));
+    auto serverApps = echoServer.Install(m_wifiApNodes);
+    serverApps.Start(Seconds(0.0));
+    serverApps.Stop(Seconds(m_simulationTime));
 
-    UdpEchoClientHelper echoClient1(Ipv4Address("10.1.1.1"), echoPort);
+    // Group A talks to the first AP, group B to the second (or the first, if there is only one).
+    UdpEchoClientHelper echoClient1(m_apInterfaces.GetAddress(0), echoPort);
     echoClient1.SetAttribute("MaxPackets", UintegerValue(4294967295u));
     echoClient1.SetAttribute("Interval", TimeValue(Seconds(1.0)));
     echoClient1.SetAttribute("PacketSize", UintegerValue(1024));
 
-    UdpEchoClientHelper echoClient2(Ipv4Address("10.1.1.2"), echoPort);
+    UdpEchoClientHelper echoClient2(m_apInterfaces.GetAddress(std::min(1u, m_wifiApNodes.GetN() - 1)), echoPort);
     echoClient2.SetAttribute("MaxPackets", UintegerValue(4294967295u));
     echoClient2.SetAttribute("Interval", TimeValue(Seconds(1.0)));
     echoClient2.SetAttribute("PacketSize", UintegerValue(1024));
@@ -179,57 +266,118 @@ void HandoverExperiment::SetupApplications() {
 }
 
 void HandoverExperiment::SetupTracing() {
-    m_anim = new AnimationInterface("data/handover/netanim.xml");
-    m_anim->UpdateNodeColor(m_wifiApNodes.Get(0)->GetId(), 0, 0, 255);
-    m_anim->UpdateNodeColor(m_wifiApNodes.Get(1)->GetId(), 255, 0, 0);
+    // Full packet animation; the position-only trace (--netanim-interval) is written by m_viz instead.
+    if (m_captureOptions.netanimInterval <= 0.0 && !IsReplicating()) {
+        m_anim = new AnimationInterface("data/handover/netanim.xml");
+        for (uint32_t i = 0; i < m_wifiApNodes.GetN(); ++i) {
+            if (i == 0) {
+                m_anim->UpdateNodeColor(m_wifiApNodes.Get(i)->GetId(), 0, 0, 255);
+            } else {
+                m_anim->UpdateNodeColor(m_wifiApNodes.Get(i)->GetId(), 255, 0, 0);
+            }
+        }
+    }
 
-    YansWifiPhyHelper wifiPhyHelper;
-    for (uint32_t i = 0; i < m_apDevices.GetN(); ++i) {
-        std::string fileName = "data/handover/ap_" + std::to_string(i) + ".pcap";
-        wifiPhyHelper.EnablePcap(fileName, m_apDevices.Get(i), true, YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
+    if (m_captureOptions.format == monadcount_sim::core::CaptureOptions::Format::Pcapng) {
+        std::string fileName = std::string("data/handover/capture.pcapng")
+                               + monadcount_sim::core::CaptureCompressionSuffix(m_captureOptions.compression);
+        m_capture = std::make_unique<monadcount_sim::wifi::WifiCaptureSink>(fileName, m_captureOptions.compression);
+        auto filter = monadcount_sim::wifi::WifiCaptureSink::MakeFilter(m_captureOptions);
+        m_capture->AddDevices(m_apDevices, "ap", filter);
+        m_capture->AddDevices(m_staDevices, "sta", filter);
+    } else if (m_captureOptions.format == monadcount_sim::core::CaptureOptions::Format::PcapPerDevice) {
+        YansWifiPhyHelper wifiPhyHelper;
+        for (uint32_t i = 0; i < m_apDevices.GetN(); ++i) {
+            std::string fileName = "data/handover/ap_" + std::to_string(i) + ".pcap";
+            wifiPhyHelper.EnablePcap(fileName, m_apDevices.Get(i), true, YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
+        }
+        for (uint32_t i = 0; i < m_staDevices.GetN(); ++i) {
+            std::string fileName = "data/handover/sta_" + std::to_string(i) + ".pcap";
+            wifiPhyHelper.EnablePcap(fileName, m_staDevices.Get(i), true, YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
+        }
     }
-    for (uint32_t i = 0; i < m_staDevices.GetN(); ++i) {
-        std::string fileName = "data/handover/sta_" + std::to_string(i) + ".pcap";
-        wifiPhyHelper.EnablePcap(fileName, m_staDevices.Get(i), true, YansWifiPhyHelper::DLT_IEEE802_11_RADIO);
+
+    if (m_captureOptions.trajectoryPeriod > 0.0) {
+        m_trajectories = std::make_unique<monadcount_sim::core::TrajectoryRecorder>(
+                "data/handover/trajectories.traj", Seconds(m_captureOptions.trajectoryPeriod));
+        m_trajectories->Add(m_groupA);
+        m_trajectories->Add(m_groupB);
+        m_trajectories->Start();
     }
+
+    m_events = std::make_unique<monadcount_sim::core::EventLog>(m_captureOptions.eventLog, "data/handover/events");
+    m_handoverEvent = m_events->Intern("Handover.handover", "Node {} handed over: AP{} -> AP{}");
+    m_reassociationEvent = m_events->Intern("Handover.reassociation", "Reassociated in {} s (cached scan: {})");
 }
 
-void HandoverExperiment::RestoreNodeTriggered(uint32_t nodeId) {
-    m_nodeTriggered[nodeId] = false;
+void HandoverExperiment::ReseedStreams() {
+    // Fixed stream numbers for the radio (PHY error models, MAC backoff, rate control) and movement, drawn
+    // from the replica's RngRun. A normal run assigns no streams, so replica k is an independent sample but
+    // not the run a cold start with RngRun k would give.
+    WifiHelper wifi;
+    MobilityHelper mobility;
+    int64_t stream = 0;
+    stream += wifi.AssignStreams(m_apDevices, stream);
+    stream += wifi.AssignStreams(m_staDevices, stream);
+    stream += mobility.AssignStreams(m_groupA, stream);
+    mobility.AssignStreams(m_groupB, stream);
 }
 
-void HandoverExperiment::CheckRssiAndTriggerHandover() {
-    Vector ap1Pos = m_wifiApNodes.Get(0)->GetObject<MobilityModel>()->GetPosition();
-    Vector ap2Pos = m_wifiApNodes.Get(1)->GetObject<MobilityModel>()->GetPosition();
-
-    NodeContainer allPedestrians;
-    allPedestrians.Add(m_groupA);
-    allPedestrians.Add(m_groupB);
-
-    for (uint32_t i = 0; i < allPedestrians.GetN(); ++i) {
-        Ptr<Node> node = allPedestrians.Get(i);
-        uint32_t nodeId = node->GetId();
-        Vector pos = node->GetObject<MobilityModel>()->GetPosition();
-        double rssi1 = EstimateRssi(pos, ap1Pos);
-        double rssi2 = EstimateRssi(pos, ap2Pos);
-        int currentAp = m_nodeAssociation[nodeId];
-
-        if (currentAp == 1 && rssi2 > (rssi1 + m_handoverMargin) && !m_nodeTriggered[nodeId]) {
-            m_nodeAssociation[nodeId] = 2;
-            m_nodeTriggered[nodeId] = true;
-            UpdateNodeVisualColor(nodeId, 2);
-            LogHandoverEvent(nodeId, 1, 2, Simulator::Now().GetSeconds());
-            Simulator::Schedule(Seconds(5.0), &HandoverExperiment::RestoreNodeTriggered, this, nodeId);
-        } else if (currentAp == 2 && rssi1 > (rssi2 + m_handoverMargin) && !m_nodeTriggered[nodeId]) {
-            m_nodeAssociation[nodeId] = 1;
-            m_nodeTriggered[nodeId] = true;
-            UpdateNodeVisualColor(nodeId, 1);
-            LogHandoverEvent(nodeId, 2, 1, Simulator::Now().GetSeconds());
-            Simulator::Schedule(Seconds(5.0), &HandoverExperiment::RestoreNodeTriggered, this, nodeId);
-        } else {
-            UpdateNodeVisualColor(nodeId, currentAp);
+void HandoverExperiment::SetupHandover() {
+    m_handover.AddAps(m_wifiApNodes);
+    m_handover.AddStations(m_groupA);
+    m_handover.AddStations(m_groupB);
+    // m_staDevices holds group A then group B, matching the engine's station order.
+    m_rssiMonitor.AddAps(m_apDevices);
+    m_rssiMonitor.AddStations(m_staDevices);
+    if (!m_eventDriven) {
+        m_handover.SetRssiMonitor(&m_rssiMonitor);
+    }
+    m_handover.SetHandoverCallback([this](uint32_t station, uint32_t fromAp, uint32_t toAp) {
+        OnHandover(station, fromAp, toAp);
+    });
+
+    // Colours only change on handover from here on.
+    for (uint32_t s = 0; s < m_handover.GetStationCount(); ++s) {
+        UpdateNodeVisualColor(m_handover.GetNodeId(s), static_cast<int>(m_handover.GetServingAp(s)) + 1);
+    }
+}
+
+void HandoverExperiment::OnHandover(uint32_t station, uint32_t fromAp, uint32_t toAp) {
+    if (m_apMacs[toAp]) {
+        Mac48Address target = m_apMacs[toAp]->GetAddress();
+        bool cached = m_assocManagers[station]->HasFreshCandidate(target);
+        if (m_assocManagers[station]->TriggerHandover(target)) {
+            // Checked against the Reassociated trace; a handover that is given up just gets overwritten.
+            m_pendingFromCache[station] = cached ? 1 : 0;
+            m_scannedHandovers += cached ? 0 : 1;
+        }
+    }
+
+    uint32_t nodeId = m_handover.GetNodeId(station);
+    // Visualization numbers APs from 1.
+    UpdateNodeVisualColor(nodeId, static_cast<int>(toAp) + 1);
+    LogHandoverEvent(nodeId, static_cast<int>(fromAp) + 1, static_cast<int>(toAp) + 1, Simulator::Now().GetSeconds());
+}
+
+void HandoverExperiment::OnReassociated(uint32_t station, Mac48Address bssid, Time elapsed, bool fromCache) {
+    if (m_pendingFromCache[station] >= 0) {
+        if ((m_pendingFromCache[station] == 1) != fromCache) {
+            NS_LOG_ERROR("Station " << station << " reassociated with " << bssid << " with fromCache=" << fromCache
+                         << " after a " << (fromCache ? "scanned" : "cached") << " handover");
+            ++m_cachePathMismatches;
         }
+        m_scannedReassociations += m_pendingFromCache[station] == 0 ? 1 : 0;
+        m_pendingFromCache[station] = -1;
     }
+    ++m_reassociations;
+    m_reassociationsFromCache += fromCache ? 1 : 0;
+    m_reassociationTime += elapsed;
+    m_events->Post(m_reassociationEvent, elapsed.GetSeconds(), fromCache);
+}
+
+void HandoverExperiment::CheckRssiAndTriggerHandover() {
+    m_handover.Tick();
 
     if (Simulator::Now().GetSeconds() < m_simulationTime)
         Simulator::Schedule(Seconds(1.0), &HandoverExperiment::CheckRssiAndTriggerHandover, this);
@@ -241,15 +389,25 @@ void HandoverExperiment::UpdateNodeVisualColor(uint32_t nodeId, int associatedAp
 
 void HandoverExperiment::LogHandoverEvent(uint32_t nodeId, int fromAp, int toAp, double time) {
     m_viz.OnHandoverEvent(nodeId, fromAp, toAp, time);
+    m_events->Post(m_handoverEvent, nodeId, fromAp, toAp);
 }
 
 void HandoverExperiment::SetupVisualization() {
-    // Enable visualizations based on build configuration
+    // Enable visualizations based on build configuration; replicas would share the files, so they get none
+    if (!IsReplicating()) {
+        if (m_captureOptions.netanimInterval > 0.0) {
+            m_viz.EnableNetAnimPositions("data/handover/netanim.xml", Seconds(m_captureOptions.netanimInterval));
+        }
 #ifdef WITH_NETANIM
-    m_viz.EnableNetAnim("data/handover/netanim.xml");
+        else {
+            m_viz.EnableNetAnim("data/handover/netanim.xml");
+        }
 #endif
+    }
 #ifdef WITH_NETSIMULYZER
-    m_viz.EnableNetSimulyzer("data/handover/simulyzer.json");
+    if (!IsReplicating()) {
+        m_viz.EnableNetSimulyzer("data/handover/simulyzer.json");
+    }
 #endif
 
     monadcount_sim::core::VisualizationManager::GroupVisualConfig apConfig;
@@ -15,7 +15,15 @@
 #include "ns3/wifi-module.h"
 #include "ns3/applications-module.h"
 #include "monadcount_sim/core/VisualizationManager.hpp"
-#include <map>
+#include "monadcount_sim/wifi/HandoverEngine.hpp"
+#include "monadcount_sim/wifi/RssiBasedAssocManager.hpp"
+#include "monadcount_sim/wifi/RssiMonitor.hpp"
+#include "monadcount_sim/wifi/WifiCaptureSink.hpp"
+#include "monadcount_sim/wifi/WifiSniffer.hpp"
+#include "monadcount_sim/core/TrajectoryRecorder.hpp"
+#include "monadcount_sim/core/EventLog.hpp"
+#include <memory>
+#include <vector>
 
 
 class HandoverExperiment : public monadcount_sim::core::Scenario
@@ -24,6 +32,14 @@ public:
     HandoverExperiment();
     void Run(monadcount_sim::core::ScenarioEnvironment &env) override;
 
+    // Instead of checking every station once per second, predict when each one crosses the handover
+    // boundary and schedule a single event at that time (re-predicted on CourseChange). Requires
+    // ConstantVelocity, Waypoint or ConstantPosition mobility.
+    void SetEventDrivenHandover(bool enabled);
+
+    void SetSimulationTime(double seconds) override { m_simulationTime = seconds; }
+    void SetNumPedestrians(uint32_t count) override { m_numPedestrians = count; }
+
 protected:
     // Simulation parameters.
     uint32_t m_numPedestrians;
@@ -35,22 +51,59 @@ protected:
     double m_handoverMargin;
     double m_txPower_dBm;
     double m_pathLossExponent;
+    bool m_eventDriven;
 
-    // Node containers for APs and pedestrian groups.
+    // Node containers for APs and pedestrian groups. The APs are the scenario's (env.apNodes) when it has
+    // any, otherwise two default ones.
     ns3::NodeContainer m_wifiApNodes;
+    bool m_apsFromScenario;
     ns3::NodeContainer m_groupA;
     ns3::NodeContainer m_groupB;
 
+    // The scenario's sniffers (env.snifferNodes); they get a passive radio on the handover channel.
+    ns3::NodeContainer m_snifferNodes;
+
     // NetDevice containers to store installed devices.
     ns3::NetDeviceContainer m_apDevices;
     ns3::NetDeviceContainer m_staDevices;
 
-    // Pointers to the AP MAC objects.
-    ns3::Ptr<ns3::ApWifiMac> m_ap1Mac;
-    ns3::Ptr<ns3::ApWifiMac> m_ap2Mac;
+    ns3::Ipv4InterfaceContainer m_apInterfaces;
+
+    // Pointers to the AP MAC objects, in m_wifiApNodes order.
+    std::vector<ns3::Ptr<ns3::ApWifiMac>> m_apMacs;
+
+    // Association state of every pedestrian; AP indices follow m_wifiApNodes.
+    monadcount_sim::wifi::HandoverEngine m_handover;
+
+    // RSSI the pedestrians' radios measure from each AP; drives the polling handover decisions.
+    monadcount_sim::wifi::RssiMonitor m_rssiMonitor;
+
+    // Association manager of every pedestrian's STA MAC, in m_staDevices (= handover station) order. The
+    // engine's decisions are carried out by these as real deauth/reassociation exchanges.
+    std::vector<ns3::Ptr<monadcount_sim::wifi::RssiBasedAssocManager>> m_assocManagers;
+    uint32_t m_reassociations;
+    uint32_t m_reassociationsFromCache;
+    ns3::Time m_reassociationTime;
+    // Per station, whether its handover in flight took the cached path (1), scanned (0) or none is (-1). A
+    // handover to an AP without a fresh candidate must end in a Reassociated trace with fromCache == false.
+    std::vector<int> m_pendingFromCache;
+    uint32_t m_scannedHandovers;
+    uint32_t m_scannedReassociations;
+    uint32_t m_cachePathMismatches;
+
+    // Single pcapng capture of all devices (CaptureOptions::Format::Pcapng only).
+    std::unique_ptr<monadcount_sim::wifi::WifiCaptureSink> m_capture;
+
+    // Per-frame records of what the sniffers overhear, if the scenario has any.
+    std::unique_ptr<monadcount_sim::wifi::WifiSniffer> m_sniffer;
+
+    // Ground-truth pedestrian positions (CaptureOptions::trajectoryPeriod > 0).
+    std::unique_ptr<monadcount_sim::core::TrajectoryRecorder> m_trajectories;
 
-    std::map<uint32_t, int> m_nodeAssociation;
-    std::map<uint32_t, bool> m_nodeTriggered;
+    // Handover and reassociation events (CaptureOptions::eventLog), and their codes.
+    std::unique_ptr<monadcount_sim::core::EventLog> m_events;
+    uint32_t m_handoverEvent;
+    uint32_t m_reassociationEvent;
 
     // Animation interface pointer for NetAnim.
     ns3::AnimationInterface* m_anim;
@@ -59,16 +112,19 @@ protected:
     monadcount_sim::core::VisualizationManager m_viz;
 
     // Helper functions.
-    double EstimateRssi(const ns3::Vector &stationPos, const ns3::Vector &apPos) const;
-    void SetupNodes();
+    void SetupNodes(monadcount_sim::core::ScenarioEnvironment &env);
     void SetupWifi();
     void SetupMobility();
     void SetupInternet();
     void SetupApplications();
     void SetupTracing();
     void SetupVisualization();
-    void RestoreNodeTriggered(uint32_t nodeId);
+    void SetupHandover();
+    // Re-assigns the random streams of the set-up devices and mobility models from the current RngRun.
+    void ReseedStreams();
     void CheckRssiAndTriggerHandover();
+    void OnHandover(uint32_t station, uint32_t fromAp, uint32_t toAp);
+    void OnReassociated(uint32_t station, ns3::Mac48Address bssid, ns3::Time elapsed, bool fromCache);
     void UpdateNodeVisualColor(uint32_t nodeId, int associatedAp);
     void LogHandoverEvent(uint32_t nodeId, int fromAp, int toAp, double time);
 };
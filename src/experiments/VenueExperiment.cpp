@@ -0,0 +1,289 @@
+#include "VenueExperiment.hpp"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/point-to-point-module.h"
+#include "monadcount_sim/core/RoomPartition.hpp"
+#ifdef WITH_MPI
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("VenueExperiment");
+
+VenueExperiment::VenueExperiment()
+        : m_simulationTime(60.0),
+          m_numPedestrians(1000),
+          m_backboneDelay(0.001),
+          m_reportInterval(1.0),
+          m_gridRooms(64),
+          m_gridRoomSize(20.0)
+{
+}
+
+void VenueExperiment::SetBackboneDelay(double seconds)
+{
+    NS_ABORT_MSG_IF(seconds <= 0.0, "VenueExperiment: the backbone delay must be positive, got " << seconds);
+    m_backboneDelay = seconds;
+}
+
+std::vector<monadcount_sim::core::Room> VenueExperiment::MakeGrid(uint32_t partitions) const
+{
+    auto columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(m_gridRooms))));
+    std::vector<monadcount_sim::core::Room> rooms;
+    for (uint32_t i = 0; i < m_gridRooms; ++i) {
+        double x = (i % columns) * m_gridRoomSize;
+        double y = (i / columns) * m_gridRoomSize;
+        std::vector<monadcount_sim::models::Point> outline{
+                monadcount_sim::models::Point(x, y), monadcount_sim::models::Point(x + m_gridRoomSize, y),
+                monadcount_sim::models::Point(x + m_gridRoomSize, y + m_gridRoomSize),
+                monadcount_sim::models::Point(x, y + m_gridRoomSize)};
+        monadcount_sim::models::RingSpan ring{0, static_cast<uint32_t>(outline.size())};
+        rooms.push_back(monadcount_sim::core::MakeRoom("grid-" + std::to_string(i),
+                                                       monadcount_sim::models::PolygonView{{&ring, 1}, outline.data()}));
+    }
+    monadcount_sim::core::AssignRoomsToRanks(rooms, partitions, {}, 0.0);
+    return rooms;
+}
+
+void VenueExperiment::Run(monadcount_sim::core::ScenarioEnvironment &env)
+{
+    //
+    // 0) Rooms and ranks
+    //
+    uint32_t systemId = 0;
+    uint32_t systemCount = 1;
+#ifdef WITH_MPI
+    if (MpiInterface::IsEnabled()) {
+        systemId = MpiInterface::GetSystemId();
+        systemCount = MpiInterface::GetSize();
+    }
+#endif
+    // Without MPI every node runs in this process whatever its system id, which gives the one-rank
+    // baseline of a partitioned topology.
+    auto isLocal = [systemId, systemCount](Ptr<Node> node) {
+        return systemCount == 1 || node->GetSystemId() == systemId;
+    };
+    if (systemCount > 1 && env.partitionCount != systemCount) {
+        throw std::runtime_error("The environment is partitioned for " + std::to_string(env.partitionCount)
+                                 + " ranks, but " + std::to_string(systemCount) + " are running");
+    }
+
+    std::vector<monadcount_sim::core::Room> rooms = env.rooms;
+    // The builder gives the scenario's APs the rank of their room; without rooms they all sit on rank 0,
+    // so they cannot serve grid rooms of other ranks and every grid room gets its own AP instead.
+    bool useScenarioAps = !rooms.empty();
+    if (rooms.empty()) {
+        rooms = MakeGrid(env.partitionCount);
+        NS_LOG_INFO("No rooms in the input, using a grid of " << rooms.size() << " rooms of " << m_gridRoomSize
+                    << " m");
+        if (env.apNodes.GetN() > 0) {
+            NS_LOG_INFO("Ignoring the input's " << env.apNodes.GetN() << " APs, one AP per grid room instead");
+        }
+    }
+    double totalArea = 0.0;
+    for (const auto &room : rooms) {
+        totalArea += room.area;
+    }
+    if (totalArea <= 0.0) {
+        throw std::runtime_error("The rooms of the input have no area to place pedestrians in");
+    }
+
+    //
+    // 1) Core router on rank 0, the APs' backbone
+    //
+    Ptr<Node> core = CreateObject<Node>(0);
+    InternetStackHelper stack;
+    stack.Install(core);
+
+    PointToPointHelper backbone;
+    backbone.SetDeviceAttribute("DataRate", StringValue("1Gbps"));
+    backbone.SetChannelAttribute("Delay", TimeValue(Seconds(m_backboneDelay)));
+
+    Ipv4AddressHelper wifiAddr;
+    wifiAddr.SetBase("10.0.0.0", "255.255.0.0");
+    Ipv4AddressHelper backboneAddr;
+    backboneAddr.SetBase("172.16.0.0", "255.255.255.252");
+    Ipv4Address coreAddress;
+
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211g);
+    wifi.SetRemoteStationManager("ns3::AarfWifiManager");
+
+    //
+    // 2) Per room: channel, APs, pedestrians
+    //
+    NodeContainer pedestrians;
+    NodeContainer localPedestrians;
+    NetDeviceContainer wifiDevices;
+    uint32_t placed = 0;
+    for (std::size_t r = 0; r < rooms.size(); ++r) {
+        const monadcount_sim::core::Room &room = rooms[r];
+
+        // The scenario's APs inside the room (built with its rank), or one in the middle of it.
+        NodeContainer aps;
+        for (uint32_t i = 0; useScenarioAps && i < env.apNodes.GetN(); ++i) {
+            Ptr<MobilityModel> mobility = env.apNodes.Get(i)->GetObject<MobilityModel>();
+            if (mobility && monadcount_sim::core::FindRoom(rooms, mobility->GetPosition().x,
+                                                           mobility->GetPosition().y) == r) {
+                aps.Add(env.apNodes.Get(i));
+            }
+        }
+        if (aps.GetN() == 0) {
+            Ptr<Node> ap = CreateObject<Node>(room.rank);
+            MobilityHelper apMob;
+            apMob.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+            apMob.Install(ap);
+            ap->GetObject<MobilityModel>()->SetPosition(
+                    Vector((room.minX + room.maxX) / 2, (room.minY + room.maxY) / 2, 2.0));
+            aps.Add(ap);
+        }
+
+        // Pedestrians by area; the last room takes the rounding remainder.
+        uint32_t count = r + 1 == rooms.size()
+                ? m_numPedestrians - std::min(placed, m_numPedestrians)
+                : static_cast<uint32_t>(std::lround(m_numPedestrians * room.area / totalArea));
+        count = std::min(count, m_numPedestrians - std::min(placed, m_numPedestrians));
+        placed += count;
+        NodeContainer peds;
+        for (uint32_t i = 0; i < count; ++i) {
+            peds.Add(CreateObject<Node>(room.rank));
+        }
+        pedestrians.Add(peds);
+
+        // Nodes of every room exist on every rank so ids line up, but only the owning rank gives a room
+        // its radios, movement and addresses; a remote room would otherwise run all its beacons,
+        // associations and walks here too. The backbone is wired on every rank: each AP link to the core
+        // is the remote end of a link on the other rank.
+        stack.Install(aps);
+        for (uint32_t i = 0; i < aps.GetN(); ++i) {
+            Ipv4InterfaceContainer link = backboneAddr.Assign(backbone.Install(core, aps.Get(i)));
+            backboneAddr.NewNetwork();
+            if (coreAddress == Ipv4Address()) {
+                coreAddress = link.GetAddress(0);
+            }
+        }
+        if (systemCount > 1 && room.rank != systemId) {
+            // Keeps the subnets of local rooms those of a one-rank run.
+            wifiAddr.NewNetwork();
+            continue;
+        }
+
+        // The room's own channel: a Wi-Fi channel cannot span ranks, and the walls keep rooms apart.
+        YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default();
+        YansWifiPhyHelper phy;
+        phy.SetErrorRateModel("ns3::NistErrorRateModel");
+        phy.SetChannel(channelHelper.Create());
+
+        Ssid ssid = Ssid("venue-" + std::to_string(r));
+        WifiMacHelper macAp;
+        macAp.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+        NetDeviceContainer apDevs = wifi.Install(phy, macAp, aps);
+        WifiMacHelper macSta;
+        macSta.SetType("ns3::StaWifiMac", "Ssid", SsidValue(ssid), "ActiveProbing", BooleanValue(false));
+        NetDeviceContainer staDevs = wifi.Install(phy, macSta, peds);
+        wifiDevices.Add(apDevs);
+        wifiDevices.Add(staDevs);
+
+        MobilityHelper pedMob;
+        pedMob.SetPositionAllocator(
+                "ns3::RandomRectanglePositionAllocator",
+                "X", StringValue("ns3::UniformRandomVariable[Min=" + std::to_string(room.minX) + "|Max="
+                                 + std::to_string(room.maxX) + "]"),
+                "Y", StringValue("ns3::UniformRandomVariable[Min=" + std::to_string(room.minY) + "|Max="
+                                 + std::to_string(room.maxY) + "]"));
+        pedMob.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
+                                "Bounds", RectangleValue(Rectangle(room.minX, room.maxX, room.minY, room.maxY)),
+                                "Speed", StringValue("ns3::UniformRandomVariable[Min=0.5|Max=1.5]"));
+        pedMob.Install(peds);
+
+        stack.Install(peds);
+        wifiAddr.Assign(apDevs);
+        wifiAddr.Assign(staDevs);
+        wifiAddr.NewNetwork();
+
+        localPedestrians.Add(peds);
+    }
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    NS_LOG_INFO("Rank " << systemId << "/" << systemCount << ": " << rooms.size() << " rooms, "
+                << pedestrians.GetN() << " pedestrians (" << localPedestrians.GetN() << " local)");
+
+    //
+    // 3) Applications, on this rank's nodes only
+    //
+    uint16_t port = 9;
+    ApplicationContainer serverApps;
+    if (isLocal(core)) {
+        UdpServerHelper server(port);
+        serverApps = server.Install(core);
+        serverApps.Start(Seconds(0.0));
+        serverApps.Stop(Seconds(m_simulationTime));
+    }
+    UdpClientHelper client(coreAddress, port);
+    client.SetAttribute("MaxPackets", UintegerValue(4294967295u));
+    client.SetAttribute("Interval", TimeValue(Seconds(m_reportInterval)));
+    client.SetAttribute("PacketSize", UintegerValue(200));
+    Ptr<UniformRandomVariable> startJitter = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < localPedestrians.GetN(); ++i) {
+        ApplicationContainer app = client.Install(localPedestrians.Get(i));
+        app.Start(Seconds(1.0 + startJitter->GetValue(0.0, m_reportInterval)));
+        app.Stop(Seconds(m_simulationTime));
+    }
+
+    //
+    // 4) Run
+    //
+    Simulator::Stop(Seconds(m_simulationTime));
+    auto wallStart = std::chrono::steady_clock::now();
+    bool ranHere = RunSimulation([&]() {
+        int64_t stream = wifi.AssignStreams(wifiDevices, 0);
+        MobilityHelper mobility;
+        mobility.AssignStreams(localPedestrians, stream);
+    });
+    if (!ranHere) {
+        Simulator::Destroy();
+        return;
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    auto events = static_cast<double>(Simulator::GetEventCount());
+    NS_LOG_INFO("Rank " << systemId << ": " << events << " events in " << wallSeconds << " s");
+
+    // Whole-run figures: the slowest rank sets the wall time, the busiest one the imbalance.
+    double totalEvents = events;
+    double maxEvents = events;
+    double maxWallSeconds = wallSeconds;
+#ifdef WITH_MPI
+    if (systemCount > 1) {
+        MPI_Allreduce(&events, &totalEvents, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(&events, &maxEvents, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        MPI_Allreduce(&wallSeconds, &maxWallSeconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    }
+#endif
+    if (systemId == 0) {
+        uint64_t received = serverApps.GetN() > 0 ? DynamicCast<UdpServer>(serverApps.Get(0))->GetReceived() : 0;
+        NS_LOG_INFO(systemCount << " ranks: " << totalEvents << " events in " << maxWallSeconds << " s ("
+                    << totalEvents / maxWallSeconds << " events/s), load imbalance "
+                    << maxEvents / (totalEvents / systemCount) << ", " << received << " reports received");
+        ReportMetric("ranks", systemCount);
+        ReportMetric("events", totalEvents);
+        ReportMetric("wall_seconds", maxWallSeconds);
+        ReportMetric("simulate_seconds", maxWallSeconds);
+        ReportMetric("events_per_second", totalEvents / maxWallSeconds);
+        ReportMetric("load_imbalance", maxEvents / (totalEvents / systemCount));
+        ReportMetric("reports_received", static_cast<double>(received));
+    }
+    Simulator::Destroy();
+
+    NS_LOG_INFO("Venue experiment complete.");
+}
@@ -0,0 +1,47 @@
+#ifndef MONADCOUNT_SIM_VENUEEXPERIMENT_HPP
+#define MONADCOUNT_SIM_VENUEEXPERIMENT_HPP
+
+#include "monadcount_sim/core/Scenario.hpp"
+#include <cstdint>
+#include <vector>
+
+// Large venue split into rooms, each with its own Wi-Fi channel, AP(s) and pedestrians, the APs wired to one
+// core router that collects the pedestrians' UDP reports.
+//
+// Built to run under ns-3's distributed simulator (--mpi): nodes take the rank of their room
+// (ScenarioEnvironment::rooms, see RoomPartition.hpp), so each rank owns the channels of its rooms, and
+// the only links between ranks are the point-to-point backbone links, whose delay is the lookahead. The
+// core router is on rank 0. Without ROOM features in the input, a grid of square rooms stands in, with one AP
+// per room.
+class VenueExperiment : public monadcount_sim::core::Scenario {
+public:
+    VenueExperiment();
+    ~VenueExperiment() override = default;
+
+    /// Pedestrians over the whole venue, spread over the rooms by area (default 1000)
+    void SetNumPedestrians(uint32_t n) override { m_numPedestrians = n; }
+
+    /// Simulated seconds (default 60)
+    void SetSimulationTime(double seconds) override { m_simulationTime = seconds; }
+
+    /// One-way delay of the AP-to-core links in seconds (default 1 ms): the synchronisation lookahead
+    /// between ranks, so longer delays mean fewer synchronisation rounds
+    void SetBackboneDelay(double seconds);
+
+protected:
+    void Run(monadcount_sim::core::ScenarioEnvironment &env) override;
+
+private:
+    double   m_simulationTime;
+    uint32_t m_numPedestrians;
+    double   m_backboneDelay;
+    double   m_reportInterval;
+
+    /// Stand-in layout when the input has no rooms
+    uint32_t m_gridRooms;
+    double   m_gridRoomSize;
+
+    std::vector<monadcount_sim::core::Room> MakeGrid(uint32_t partitions) const;
+};
+
+#endif // MONADCOUNT_SIM_VENUEEXPERIMENT_HPP
@@ -1,11 +1,22 @@
 #include "ns3/core-module.h"
 #include "experiments/BasicExperiment.hpp"
 #include "experiments/DoorToDoorExperiment.hpp"
+#include "monadcount_sim/core/EventProfiler.hpp"
 #include "monadcount_sim/core/ScenarioFactory.hpp"
+#include "monadcount_sim/core/SweepRunner.hpp"
 #include "experiments/HandoverExperiment.hpp"
 #include "experiments/GaussMarkovHandoverExperiment.hpp"
+#include "experiments/VenueExperiment.hpp"
+#include "monadcount_sim/wifi/WifiCaptureSink.hpp"
+#include <algorithm>
+#include <stdexcept>
 #include <system_error>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#ifdef WITH_MPI
+#include "ns3/mpi-interface.h"
+#endif
 
 namespace fs = std::filesystem;
 using namespace ns3;
@@ -17,6 +28,7 @@ void RegisterScenarios() {
     factory.RegisterScenario<BasicExperiment>("basic");
     factory.RegisterScenario<DoorToDoorExperiment>("doortodoor");
     factory.RegisterScenario<HandoverExperiment>("handover");
+    factory.RegisterScenario<VenueExperiment>("venue");
     //factory.RegisterScenario<GaussMarkovHandoverExperiment>("gauss-markov-handover");
 }
 
@@ -24,16 +36,73 @@ int main(int argc, char *argv[])
 {
     ns3::LogComponentEnable("MonadCountSim", ns3::LOG_LEVEL_INFO);
     ns3::LogComponentEnable("ScenarioEnvironmentBuilder", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("Scenario", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("SweepRunner", ns3::LOG_LEVEL_INFO);
 
     RegisterScenarios();
 
     std::string scenarioName = "basic";
     std::string scenarioFile;
+    std::string propagationModel;
+    double pathLossCache = 0.0;
+    bool handoverEvents = false;
+    std::string captureFormat = "pcapng";
+    std::string captureCompression;
+    std::string captureFrames = "all";
+    uint32_t captureSnapLength = 65535;
+    double trajectoryPeriod = 1.0;
+    std::string eventLog = "none";
+    double netanimInterval = 0.0;
+    double duration = 0.0;
+    uint32_t pedestrians = 0;
+    std::string metricsFile;
+    std::string sweepGrid;
+    std::string sweepSeeds;
+    std::string sweepDir;
+    unsigned sweepJobs = 0;
+    uint32_t replications = 1;
+    bool mpi = false;
+    double backboneDelay = 0.0;
+    bool profile = false;
+    uint32_t profileTop = 25;
+    uint32_t profileSample = 16;
     bool listScenarios = false;
+    monadcount_sim::core::ScenarioLoadOptions loadOptions;
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("scenario", "Name of the scenario to run", scenarioName);
     cmd.AddValue("input", "Path to the GeoJSON file describing the scenario (optional)", scenarioFile);
+    cmd.AddValue("experiment", "Only load --input features with this properties.experiment_id (indexed on first use)", loadOptions.experimentId);
+    cmd.AddValue("streaming", "Stream the GeoJSON input through the SAX parser instead of loading a DOM", loadOptions.streaming);
+    cmd.AddValue("arena", "Parse the GeoJSON input into a flat feature arena instead of per-feature objects", loadOptions.arena);
+    cmd.AddValue("parse-threads", "Threads decoding GeoJSON features (0 = all hardware threads)", loadOptions.parseThreads);
+    cmd.AddValue("partitions", "Spread the input's rooms over this many ranks (set by --mpi to the rank count)", loadOptions.partitions);
+    cmd.AddValue("batched-build", "Create AP, sniffer and terminal nodes in one batch per category", loadOptions.batchedBuild);
+    cmd.AddValue("cache", "Load the input from a compiled, memory-mapped cache (written on first use)", loadOptions.useCache);
+    cmd.AddValue("cache-dir", "Directory holding compiled scenario caches and experiment indexes", loadOptions.cacheDirectory);
+    cmd.AddValue("propagation", "Propagation model of the basic scenario: Nakagami, Friis, LogDistance or MultiWall", propagationModel);
+    cmd.AddValue("path-loss-cache", "Cache AP path loss on a lattice with this spacing in metres (basic scenario, 0 = off)", pathLossCache);
+    cmd.AddValue("handover-events", "Predict handover boundary crossings instead of polling RSSI every second (handover scenario)", handoverEvents);
+    cmd.AddValue("capture", "Frame capture of Wi-Fi devices: pcapng (one file, background writer), pcap (one file per device) or none", captureFormat);
+    cmd.AddValue("capture-compression", "Compression of the pcapng capture: zstd, lz4 or none (default: zstd if available)", captureCompression);
+    cmd.AddValue("capture-frames", "802.11 frames kept by the pcapng capture, comma-separated: all, mgmt, ctrl, data, probe-assoc, beacon", captureFrames);
+    cmd.AddValue("capture-snaplen", "Bytes kept per captured frame, radiotap header included", captureSnapLength);
+    cmd.AddValue("trajectory-period", "Seconds between ground-truth pedestrian position samples in trajectories.traj (0 = off)", trajectoryPeriod);
+    cmd.AddValue("event-log", "Outputs of the experiment event log, comma-separated: console, text (events.log), binary (events.bin) or none", eventLog);
+    cmd.AddValue("netanim-interval", "Write a position-only netanim.xml, sampling node positions every this many seconds (0 = full NetAnim tracing)", netanimInterval);
+    cmd.AddValue("duration", "Simulated seconds (0 = scenario default)", duration);
+    cmd.AddValue("pedestrians", "Number of pedestrians (0 = scenario default)", pedestrians);
+    cmd.AddValue("metrics", "Write the run's metrics (name,value lines) to this file", metricsFile);
+    cmd.AddValue("sweep", "Run a grid of option values in parallel processes, e.g. \"pedestrians=10,50;duration=600,1200\"", sweepGrid);
+    cmd.AddValue("seeds", "RngRun values of every sweep point, e.g. 1-16 (default 1)", sweepSeeds);
+    cmd.AddValue("jobs", "Concurrent sweep runs or replications (0 = one per hardware thread)", sweepJobs);
+    cmd.AddValue("replications", "Fork this many replicas of the set-up simulation, each with its own RngRun (handover and door-to-door scenarios, no file outputs)", replications);
+    cmd.AddValue("sweep-dir", "Directory of the sweep's run directories and summary.csv (default sweeps/<scenario>)", sweepDir);
+    cmd.AddValue("mpi", "Run distributed over the ranks of mpirun, one partition of rooms each (venue scenario, needs WITH_MPI)", mpi);
+    cmd.AddValue("backbone-delay", "One-way delay of the venue's AP-to-core links in seconds, the lookahead between ranks (venue scenario)", backboneDelay);
+    cmd.AddValue("profile", "Attribute the event loop's wall time to callback types, written to profile.txt and profile.folded", profile);
+    cmd.AddValue("profile-top", "Rows of the --profile report", profileTop);
+    cmd.AddValue("profile-sample", "--profile times about one in this many events (1 = every event, slower)", profileSample);
     cmd.AddValue("list-scenarios", "List all available scenario names", listScenarios);
     cmd.Parse(argc, argv);
 
@@ -46,6 +115,56 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (!sweepGrid.empty() || !sweepSeeds.empty()) {
+        if (!factory.CreateScenario(scenarioName)) {
+            NS_LOG_ERROR("Unknown scenario: " << scenarioName);
+            return 1;
+        }
+        std::vector<monadcount_sim::core::SweepRun> runs;
+        try {
+            runs = monadcount_sim::core::ExpandSweep(monadcount_sim::core::ParseSweepGrid(sweepGrid),
+                                                     monadcount_sim::core::ParseSeedList(sweepSeeds.empty() ? "1" : sweepSeeds));
+        } catch (const std::invalid_argument &e) {
+            NS_LOG_ERROR(e.what());
+            return 1;
+        }
+
+        // Every run repeats this command line in its own directory, so paths become absolute and the sweep
+        // options are dropped; the runner appends each run's values.
+        std::vector<std::string> arguments;
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            bool dropped = false;
+            for (const char *prefix : {"--sweep=", "--seeds=", "--jobs=", "--sweep-dir=", "--metrics=", "--input=", "--cache-dir="}) {
+                dropped = dropped || argument.rfind(prefix, 0) == 0;
+            }
+            if (!dropped) {
+                arguments.push_back(argument);
+            }
+        }
+        if (!scenarioFile.empty()) {
+            arguments.push_back("--input=" + fs::absolute(scenarioFile).string());
+        }
+        arguments.push_back("--cache-dir=" + fs::absolute(loadOptions.cacheDirectory).string());
+
+        std::error_code error;
+        fs::path executable = fs::read_symlink("/proc/self/exe", error);
+        if (error) {
+            executable = fs::absolute(argv[0]);
+        }
+        fs::path outputDir = fs::absolute(sweepDir.empty() ? "sweeps/" + scenarioName : sweepDir);
+        try {
+            monadcount_sim::core::SweepRunner runner(executable.string(), arguments, outputDir.string(), sweepJobs);
+            auto results = runner.Run(runs);
+            auto failed = std::count_if(results.begin(), results.end(),
+                                        [](const auto &result) { return result.exitCode != 0; });
+            return failed == 0 ? 0 : 1;
+        } catch (const std::exception &e) {
+            NS_LOG_ERROR(e.what());
+            return 1;
+        }
+    }
+
     fs::path nestedDir = "data/" + scenarioName;
     try {
         fs::create_directories(nestedDir);
@@ -65,8 +184,185 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (!loadOptions.experimentId.empty() && scenarioFile.empty()) {
+        NS_LOG_ERROR("--experiment requires --input");
+        return 1;
+    }
+
+    if (!propagationModel.empty() || pathLossCache > 0.0) {
+        auto *basic = dynamic_cast<BasicExperiment *>(scenario.get());
+        if (!basic) {
+            NS_LOG_ERROR("--propagation and --path-loss-cache are only supported by the basic scenario");
+            return 1;
+        }
+        if (!propagationModel.empty()) {
+            basic->SetPropagationModel(propagationModel);
+        }
+        basic->SetPathLossCache(pathLossCache);
+    }
+
+    if (handoverEvents) {
+        auto *handover = dynamic_cast<HandoverExperiment *>(scenario.get());
+        if (!handover) {
+            NS_LOG_ERROR("--handover-events is only supported by the handover scenario");
+            return 1;
+        }
+        handover->SetEventDrivenHandover(true);
+    }
+
+    if (mpi || backboneDelay > 0.0) {
+        auto *venue = dynamic_cast<VenueExperiment *>(scenario.get());
+        if (!venue) {
+            NS_LOG_ERROR("--mpi and --backbone-delay are only supported by the venue scenario");
+            return 1;
+        }
+        if (backboneDelay > 0.0) {
+            venue->SetBackboneDelay(backboneDelay);
+        }
+    }
+    if (loadOptions.partitions == 0) {
+        NS_LOG_ERROR("--partitions must be at least 1");
+        return 1;
+    }
+
+    monadcount_sim::core::CaptureOptions captureOptions;
+    if (captureFormat == "pcap") {
+        captureOptions.format = monadcount_sim::core::CaptureOptions::Format::PcapPerDevice;
+    } else if (captureFormat == "none") {
+        captureOptions.format = monadcount_sim::core::CaptureOptions::Format::None;
+    } else if (captureFormat != "pcapng") {
+        NS_LOG_ERROR("Unknown --capture format: " << captureFormat);
+        return 1;
+    }
+    if (!captureCompression.empty()) {
+        try {
+            captureOptions.compression = monadcount_sim::core::ParseCaptureCompression(captureCompression);
+        } catch (const std::invalid_argument &e) {
+            NS_LOG_ERROR(e.what());
+            return 1;
+        }
+        if (!monadcount_sim::core::IsCaptureCompressionAvailable(captureOptions.compression)) {
+            NS_LOG_ERROR("--capture-compression=" << captureCompression << " is not available in this build");
+            return 1;
+        }
+    }
+
+    if (!monadcount_sim::wifi::WifiCaptureFilter::ParseFrameTypes(captureFrames, captureOptions.frameTypes)) {
+        NS_LOG_ERROR("Unknown --capture-frames value: " << captureFrames);
+        return 1;
+    }
+    if (captureSnapLength < 16) {
+        NS_LOG_ERROR("--capture-snaplen must be at least 16 (the radiotap header)");
+        return 1;
+    }
+    captureOptions.snapLength = captureSnapLength;
+    if (trajectoryPeriod < 0.0) {
+        NS_LOG_ERROR("--trajectory-period must not be negative");
+        return 1;
+    }
+    captureOptions.trajectoryPeriod = trajectoryPeriod;
+    if (netanimInterval < 0.0) {
+        NS_LOG_ERROR("--netanim-interval must not be negative");
+        return 1;
+    }
+    captureOptions.netanimInterval = netanimInterval;
+    try {
+        captureOptions.eventLog = monadcount_sim::core::ParseEventLogOptions(eventLog);
+    } catch (const std::invalid_argument &e) {
+        NS_LOG_ERROR(e.what());
+        return 1;
+    }
+
+    try {
+        if (duration > 0.0) {
+            scenario->SetSimulationTime(duration);
+        }
+        if (pedestrians > 0) {
+            scenario->SetNumPedestrians(pedestrians);
+        }
+    } catch (const std::invalid_argument &e) {
+        NS_LOG_ERROR(e.what() << " (--scenario=" << scenarioName << ")");
+        return 1;
+    }
+
+    if (mpi) {
+#ifdef WITH_MPI
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+        loadOptions.partitions = MpiInterface::GetSize();
+        if (MpiInterface::GetSystemId() != 0) {
+            // Rank 0 reports the whole run's metrics.
+            metricsFile.clear();
+        }
+#else
+        NS_LOG_ERROR("--mpi needs a build with WITH_MPI (and ns-3 built with MPI)");
+        return 1;
+#endif
+    }
+    scenario->SetMetricsFile(metricsFile);
+
+    if (replications == 0) {
+        NS_LOG_ERROR("--replications must be at least 1");
+        return 1;
+    }
+    if (replications > 1) {
+        if (!dynamic_cast<HandoverExperiment *>(scenario.get()) && !dynamic_cast<DoorToDoorExperiment *>(scenario.get())) {
+            NS_LOG_ERROR("--replications is only supported by the handover and door-to-door scenarios");
+            return 1;
+        }
+        // Replicas are forked after set-up, so anything writing a file would share it between them.
+        captureOptions.format = monadcount_sim::core::CaptureOptions::Format::None;
+        captureOptions.trajectoryPeriod = 0.0;
+        captureOptions.netanimInterval = 0.0;
+        captureOptions.eventLog = {};
+        NS_LOG_INFO("Replicating " << replications << " times; capture, trajectories, event log and NetAnim are off");
+        scenario->SetReplications(replications, sweepJobs);
+    }
+
+    if (profile) {
+        if (mpi || replications > 1) {
+            NS_LOG_ERROR("--profile cannot be combined with --mpi or --replications");
+            return 1;
+        }
+        if (profileSample == 0) {
+            NS_LOG_ERROR("--profile-sample must be at least 1");
+            return 1;
+        }
+        monadcount_sim::core::EventProfiler::Instance().SetSamplePeriod(profileSample);
+        monadcount_sim::core::EventProfiler::Instance().Enable();
+    }
+
     NS_LOG_INFO("Running scenario: " << scenarioName);
-    scenario->Execute(scenarioFile);
+    scenario->SetLoadOptions(loadOptions);
+    scenario->SetCaptureOptions(captureOptions);
+    try {
+        scenario->Execute(scenarioFile);
+    } catch (const std::exception &e) {
+        NS_LOG_ERROR(e.what() << " (--scenario=" << scenarioName << ")");
+#ifdef WITH_MPI
+        if (mpi) {
+            MpiInterface::Disable();
+        }
+#endif
+        return 1;
+    }
+#ifdef WITH_MPI
+    if (mpi) {
+        MpiInterface::Disable();
+    }
+#endif
+
+    if (profile) {
+        const auto &profiler = monadcount_sim::core::EventProfiler::Instance();
+        std::ofstream report(nestedDir / "profile.txt");
+        profiler.WriteReport(report, profileTop);
+        std::ofstream folded(nestedDir / "profile.folded");
+        profiler.WriteCollapsed(folded);
+        std::ostringstream summary;
+        profiler.WriteReport(summary, std::min<uint32_t>(profileTop, 10));
+        NS_LOG_INFO("Event profile (" << (nestedDir / "profile.txt").string() << ", flamegraph input "
+                    << (nestedDir / "profile.folded").string() << "):\n" << summary.str());
+    }
 
     return 0;
 }
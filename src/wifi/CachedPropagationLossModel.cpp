@@ -0,0 +1,274 @@
+#include "monadcount_sim/wifi/CachedPropagationLossModel.hpp"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+
+#include <cmath>
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        NS_LOG_COMPONENT_DEFINE ("CachedPropagationLossModel");
+        NS_OBJECT_ENSURE_REGISTERED (CachedPropagationLossModel);
+
+        namespace {
+            // Per-tile bookkeeping besides the loss values: hash node, LRU node, vector header.
+            constexpr uint64_t kTileOverheadBytes = 96;
+
+            int32_t
+            FloorDiv (int64_t value, int64_t divisor)
+            {
+                int64_t quotient = value / divisor;
+                if ((value % divisor != 0) && (value < 0))
+                {
+                    --quotient;
+                }
+                return static_cast<int32_t> (quotient);
+            }
+        }
+
+        ns3::TypeId
+        CachedPropagationLossModel::GetTypeId (void)
+        {
+            static ns3::TypeId tid = ns3::TypeId ("monadcount_sim::wifi::CachedPropagationLossModel")
+                    .SetParent<ns3::PropagationLossModel> ()
+                    .SetGroupName ("MonadCountSim")
+                    .AddConstructor<CachedPropagationLossModel> ()
+                    .AddAttribute ("Model",
+                                   "Deterministic loss model (or chain) whose loss is cached.",
+                                   ns3::PointerValue (),
+                                   ns3::MakePointerAccessor (&CachedPropagationLossModel::SetModel,
+                                                             &CachedPropagationLossModel::GetModel),
+                                   ns3::MakePointerChecker<ns3::PropagationLossModel> ())
+                    .AddAttribute ("Resolution",
+                                   "Lattice spacing (m) of the cached maps; set before the first lookup.",
+                                   ns3::DoubleValue (0.25),
+                                   ns3::MakeDoubleAccessor (&CachedPropagationLossModel::m_resolution),
+                                   ns3::MakeDoubleChecker<double> (1e-3))
+                    .AddAttribute ("TileSize",
+                                   "Cells per tile side; a tile is filled on its first lookup. Set before the first lookup.",
+                                   ns3::UintegerValue (32),
+                                   ns3::MakeUintegerAccessor (&CachedPropagationLossModel::m_tileSize),
+                                   ns3::MakeUintegerChecker<uint32_t> (1, 4096))
+                    .AddAttribute ("MemoryBudget",
+                                   "Bytes of cached tiles above which the least recently used ones are evicted.",
+                                   ns3::UintegerValue (64u << 20),
+                                   ns3::MakeUintegerAccessor (&CachedPropagationLossModel::m_memoryBudget),
+                                   ns3::MakeUintegerChecker<uint64_t> ());
+            return tid;
+        }
+
+        CachedPropagationLossModel::CachedPropagationLossModel ()
+            : m_resolution (0.25),
+              m_tileSize (32),
+              m_memoryBudget (64u << 20),
+              m_probe (ns3::CreateObject<ns3::ConstantPositionMobilityModel> ())
+        {
+            NS_LOG_FUNCTION (this);
+        }
+
+        CachedPropagationLossModel::~CachedPropagationLossModel ()
+        {
+            NS_LOG_FUNCTION (this);
+        }
+
+        void
+        CachedPropagationLossModel::DoDispose (void)
+        {
+            NS_LOG_FUNCTION (this);
+            NS_LOG_INFO ("Path loss cache: " << m_stats.hits << " hits, " << m_stats.misses << " misses, "
+                         << m_stats.bypasses << " bypasses, " << m_stats.evictions << " evictions, "
+                         << m_stats.tiles << " tiles (" << m_stats.bytes / 1024 << " KiB)");
+            Clear ();
+            m_linkEnds.clear ();
+            m_model = nullptr;
+            m_probe = nullptr;
+            ns3::PropagationLossModel::DoDispose ();
+        }
+
+        void
+        CachedPropagationLossModel::SetModel (ns3::Ptr<ns3::PropagationLossModel> model)
+        {
+            NS_LOG_FUNCTION (this << model);
+            m_model = model;
+            Clear ();
+        }
+
+        ns3::Ptr<ns3::PropagationLossModel>
+        CachedPropagationLossModel::GetModel (void) const
+        {
+            return m_model;
+        }
+
+        void
+        CachedPropagationLossModel::Clear (void)
+        {
+            m_tiles.clear ();
+            m_lru.clear ();
+            m_stats.tiles = 0;
+            m_stats.bytes = 0;
+        }
+
+        PathLossCacheStats
+        CachedPropagationLossModel::GetStats (void) const
+        {
+            return m_stats;
+        }
+
+        void
+        CachedPropagationLossModel::ResetStats (void)
+        {
+            m_stats.hits = 0;
+            m_stats.misses = 0;
+            m_stats.bypasses = 0;
+            m_stats.evictions = 0;
+        }
+
+        std::size_t
+        CachedPropagationLossModel::TileKeyHash::operator() (const TileKey &key) const
+        {
+            uint64_t h = key.transmitter;
+            h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t> (key.x);
+            h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t> (key.y);
+            h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t> (key.z);
+            return static_cast<std::size_t> (h ^ (h >> 29));
+        }
+
+        uint32_t
+        CachedPropagationLossModel::GetTransmitter (ns3::Ptr<ns3::MobilityModel> mobility) const
+        {
+            auto it = m_linkEnds.find (ns3::PeekPointer (mobility));
+            if (it == m_linkEnds.end ())
+            {
+                bool isStatic = ns3::DynamicCast<ns3::ConstantPositionMobilityModel> (mobility) != nullptr;
+                LinkEnd end{isStatic, isStatic ? m_nextTransmitter++ : kNotStatic, mobility->GetPosition ()};
+                it = m_linkEnds.emplace (ns3::PeekPointer (mobility), end).first;
+            }
+            LinkEnd &end = it->second;
+            if (!end.isStatic)
+            {
+                return kNotStatic;
+            }
+            // ConstantPosition nodes are still placed by hand, sometimes after the first frames.
+            ns3::Vector position = mobility->GetPosition ();
+            if (position.x != end.position.x || position.y != end.position.y || position.z != end.position.z)
+            {
+                NS_LOG_DEBUG ("Static node moved to " << position << "; starting a new loss map");
+                end.position = position;
+                end.id = m_nextTransmitter++;
+            }
+            return end.id;
+        }
+
+        const CachedPropagationLossModel::Tile &
+        CachedPropagationLossModel::GetTile (ns3::Ptr<ns3::MobilityModel> transmitter, const TileKey &key) const
+        {
+            auto it = m_tiles.find (key);
+            if (it != m_tiles.end ())
+            {
+                ++m_stats.hits;
+                m_lru.splice (m_lru.begin (), m_lru, it->second.lruEntry);
+                return it->second;
+            }
+
+            ++m_stats.misses;
+            const uint32_t stride = m_tileSize + 1;
+            Tile tile;
+            tile.lossDb.resize (static_cast<std::size_t> (stride) * stride);
+            const double z = key.z * m_resolution;
+            for (uint32_t j = 0; j < stride; ++j)
+            {
+                double y = (static_cast<int64_t> (key.y) * m_tileSize + j) * m_resolution;
+                for (uint32_t i = 0; i < stride; ++i)
+                {
+                    double x = (static_cast<int64_t> (key.x) * m_tileSize + i) * m_resolution;
+                    m_probe->SetPosition (ns3::Vector (x, y, z));
+                    tile.lossDb[j * stride + i] = static_cast<float> (-m_model->CalcRxPower (0.0, transmitter, m_probe));
+                }
+            }
+            m_lru.push_front (key);
+            tile.lruEntry = m_lru.begin ();
+            auto inserted = m_tiles.emplace (key, std::move (tile)).first;
+            ++m_stats.tiles;
+            m_stats.bytes += inserted->second.lossDb.size () * sizeof (float) + kTileOverheadBytes;
+            EvictOverBudget ();
+            return inserted->second;
+        }
+
+        void
+        CachedPropagationLossModel::EvictOverBudget (void) const
+        {
+            // The most recent tile is the one being returned, so it always stays.
+            while (m_stats.bytes > m_memoryBudget && m_lru.size () > 1)
+            {
+                auto victim = m_tiles.find (m_lru.back ());
+                m_stats.bytes -= victim->second.lossDb.size () * sizeof (float) + kTileOverheadBytes;
+                --m_stats.tiles;
+                ++m_stats.evictions;
+                m_tiles.erase (victim);
+                m_lru.pop_back ();
+            }
+        }
+
+        double
+        CachedPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                                   ns3::Ptr<ns3::MobilityModel> a,
+                                                   ns3::Ptr<ns3::MobilityModel> b) const
+        {
+            if (!m_model)
+            {
+                return txPowerDbm;
+            }
+
+            // The map belongs to the static end; by reciprocity it also serves uplink frames.
+            ns3::Ptr<ns3::MobilityModel> fixed = a;
+            ns3::Ptr<ns3::MobilityModel> other = b;
+            uint32_t transmitter = GetTransmitter (a);
+            if (transmitter == kNotStatic)
+            {
+                fixed = b;
+                other = a;
+                transmitter = GetTransmitter (b);
+            }
+            if (transmitter == kNotStatic)
+            {
+                ++m_stats.bypasses;
+                return m_model->CalcRxPower (txPowerDbm, a, b);
+            }
+
+            ns3::Vector position = other->GetPosition ();
+            double fx = position.x / m_resolution;
+            double fy = position.y / m_resolution;
+            double cellX = std::floor (fx);
+            double cellY = std::floor (fy);
+            auto latticeX = static_cast<int64_t> (cellX);
+            auto latticeY = static_cast<int64_t> (cellY);
+
+            TileKey key{transmitter,
+                        FloorDiv (latticeX, m_tileSize),
+                        FloorDiv (latticeY, m_tileSize),
+                        static_cast<int32_t> (std::lround (position.z / m_resolution))};
+            const Tile &tile = GetTile (fixed, key);
+
+            // Bilinear interpolation inside the cell; the tile stores both edges of its last cell.
+            const uint32_t stride = m_tileSize + 1;
+            auto localX = static_cast<uint32_t> (latticeX - static_cast<int64_t> (key.x) * m_tileSize);
+            auto localY = static_cast<uint32_t> (latticeY - static_cast<int64_t> (key.y) * m_tileSize);
+            const float *row = tile.lossDb.data () + localY * stride + localX;
+            double wx = fx - cellX;
+            double wy = fy - cellY;
+            double bottom = row[0] + (row[1] - row[0]) * wx;
+            double top = row[stride] + (row[stride + 1] - row[stride]) * wx;
+            return txPowerDbm - (bottom + (top - bottom) * wy);
+        }
+
+        int64_t
+        CachedPropagationLossModel::DoAssignStreams (int64_t stream)
+        {
+            return m_model ? m_model->AssignStreams (stream) : 0;
+        }
+
+    }
+}
@@ -0,0 +1,352 @@
+#include "monadcount_sim/wifi/HandoverEngine.hpp"
+#include "monadcount_sim/wifi/RssiMonitor.hpp"
+#include "ns3/abort.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/waypoint-mobility-model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        NS_LOG_COMPONENT_DEFINE ("HandoverEngine");
+
+        namespace {
+            // Padding APs sit this far away, so they are never the strongest.
+            constexpr float kFarAway = 1e15f;
+
+#if defined(__GNUC__) || defined(__clang__)
+            // Floats per SIMD operation: 8 with AVX, 4 in the SSE2/NEON registers every 64-bit target has.
+#if defined(__AVX__)
+            constexpr uint32_t kVectorLanes = 8;
+#else
+            constexpr uint32_t kVectorLanes = 4;
+#endif
+            static_assert (HandoverEngine::kApLanes % kVectorLanes == 0);
+
+            typedef float Floats __attribute__ ((vector_size (kVectorLanes * sizeof (float))));
+            typedef int32_t Ints __attribute__ ((vector_size (kVectorLanes * sizeof (int32_t))));
+
+            inline Floats
+            LoadFloats (const float *values)
+            {
+                Floats lanes;
+                __builtin_memcpy (&lanes, values, sizeof (lanes));
+                return lanes;
+            }
+
+            inline Floats
+            Select (Ints mask, Floats ifSet, Floats ifClear)
+            {
+                return (Floats) (((Ints) ifSet & mask) | ((Ints) ifClear & ~mask));
+            }
+
+            // log10 of positive, normal inputs. Split x = m * 2^e with m in [sqrt(1/2), sqrt(2)), then
+            // ln(m) = 2 atanh(z), z = (m - 1) / (m + 1), |z| < 0.172, from four terms of the series.
+            inline Floats
+            Log10 (Floats x)
+            {
+                Ints bits = (Ints) x;
+                Ints exponent = ((bits >> 23) & 0xff) - 127;
+                Floats m = (Floats) ((bits & 0x007fffff) | 0x3f800000);
+                Ints high = m > 1.41421356f;
+                m = Select (high, m * 0.5f, m);
+                exponent -= high;  // -1 where the mantissa was halved
+                Floats z = (m - 1.0f) / (m + 1.0f);
+                Floats z2 = z * z;
+                Floats lnM = 2.0f * z * (1.0f + z2 * (1.0f / 3.0f + z2 * (1.0f / 5.0f + z2 * (1.0f / 7.0f))));
+                Floats e = __builtin_convertvector (exponent, Floats);
+                return (e * 0.693147181f + lnM) * 0.434294482f;
+            }
+#endif
+        }
+
+        HandoverEngine::HandoverEngine (double txPowerDbm, double pathLossExponent, double marginDb, ns3::Time holdOff)
+            : m_txPowerDbm (txPowerDbm),
+              m_pathLossExponent (pathLossExponent),
+              m_marginDb (marginDb),
+              m_holdOff (holdOff),
+              m_predictor (marginDb, pathLossExponent)
+        {
+        }
+
+        void
+        HandoverEngine::AddAps (const ns3::NodeContainer &aps)
+        {
+            NS_ABORT_MSG_IF (!m_nodeId.empty (), "HandoverEngine: add APs before stations");
+            for (uint32_t i = 0; i < aps.GetN (); ++i)
+            {
+                ns3::Ptr<ns3::MobilityModel> mobility = aps.Get (i)->GetObject<ns3::MobilityModel> ();
+                NS_ABORT_MSG_IF (!mobility, "HandoverEngine: AP node " << aps.Get (i)->GetId () << " has no position");
+                m_apPositions.push_back (mobility->GetPosition ());
+            }
+            m_apStride = (m_apPositions.size () + kApLanes - 1) / kApLanes * kApLanes;
+            m_apX.assign (m_apStride, kFarAway);
+            m_apY.assign (m_apStride, kFarAway);
+            for (std::size_t a = 0; a < m_apPositions.size (); ++a)
+            {
+                m_apX[a] = static_cast<float> (m_apPositions[a].x);
+                m_apY[a] = static_cast<float> (m_apPositions[a].y);
+            }
+        }
+
+        uint32_t
+        HandoverEngine::AddStations (const ns3::NodeContainer &stations)
+        {
+            NS_ABORT_MSG_IF (m_apPositions.empty (), "HandoverEngine: add APs before stations");
+            auto first = static_cast<uint32_t> (m_nodeId.size ());
+            std::size_t count = first + stations.GetN ();
+            m_nodeId.reserve (count);
+            m_mobility.reserve (count);
+            for (uint32_t i = 0; i < stations.GetN (); ++i)
+            {
+                ns3::Ptr<ns3::Node> node = stations.Get (i);
+                ns3::Ptr<ns3::MobilityModel> mobility = node->GetObject<ns3::MobilityModel> ();
+                NS_ABORT_MSG_IF (!mobility, "HandoverEngine: station node " << node->GetId () << " has no mobility");
+                m_nodeId.push_back (node->GetId ());
+                m_mobility.push_back (mobility);
+            }
+            m_x.resize (count);
+            m_y.resize (count);
+            m_servingAp.resize (count);
+            m_holdUntil.resize (count, 0);
+            m_pending.resize (count);
+            m_rssi.resize (count * m_apStride);
+
+            // Initial association: the strongest AP where the station starts.
+            for (uint32_t s = first; s < count; ++s)
+            {
+                ns3::Vector position = m_mobility[s]->GetPosition ();
+                m_x[s] = static_cast<float> (position.x);
+                m_y[s] = static_cast<float> (position.y);
+            }
+            ComputeRssi (m_x.data () + first, m_y.data () + first, count - first, m_apX.data (), m_apY.data (),
+                         m_apStride, static_cast<float> (m_txPowerDbm), static_cast<float> (m_pathLossExponent),
+                         m_rssi.data () + first * m_apStride);
+            for (uint32_t s = first; s < count; ++s)
+            {
+                m_servingAp[s] = StrongestAp (s);
+            }
+            return first;
+        }
+
+        void
+        HandoverEngine::SetHandoverCallback (HandoverCallback callback)
+        {
+            m_onHandover = std::move (callback);
+        }
+
+        void
+        HandoverEngine::SetRssiMonitor (const RssiMonitor *monitor)
+        {
+            NS_ABORT_MSG_IF (monitor && (monitor->GetApCount () != GetApCount () ||
+                                         monitor->GetStationCount () != GetStationCount ()),
+                             "HandoverEngine: RSSI monitor does not match the engine's stations and APs");
+            m_monitor = monitor;
+        }
+
+        void
+        HandoverEngine::ComputeRssi (const float *stationX, const float *stationY, std::size_t stations,
+                                     const float *apX, const float *apY, std::size_t apStride,
+                                     float txPowerDbm, float pathLossExponent, float *rssi)
+        {
+            // 10 n log10(max(d, 1)) = 5 n log10(max(d^2, 1)): no square root needed.
+            const float scale = 5.0f * pathLossExponent;
+            for (std::size_t s = 0; s < stations; ++s)
+            {
+                float *row = rssi + s * apStride;
+#if defined(__GNUC__) || defined(__clang__)
+                for (std::size_t a = 0; a < apStride; a += kVectorLanes)
+                {
+                    Floats dx = LoadFloats (apX + a) - stationX[s];
+                    Floats dy = LoadFloats (apY + a) - stationY[s];
+                    Floats d2 = dx * dx + dy * dy;
+                    d2 = Select (d2 < 1.0f, d2 - d2 + 1.0f, d2);
+                    Floats value = txPowerDbm - scale * Log10 (d2);
+                    __builtin_memcpy (row + a, &value, sizeof (value));
+                }
+#else
+                for (std::size_t a = 0; a < apStride; ++a)
+                {
+                    float dx = apX[a] - stationX[s];
+                    float dy = apY[a] - stationY[s];
+                    float d2 = std::max (dx * dx + dy * dy, 1.0f);
+                    row[a] = txPowerDbm - scale * std::log10 (d2);
+                }
+#endif
+            }
+        }
+
+        uint32_t
+        HandoverEngine::StrongestAp (uint32_t station) const
+        {
+            const float *row = GetRssi (station);
+            uint32_t best = 0;
+            for (uint32_t a = 1; a < GetApCount (); ++a)
+            {
+                if (row[a] > row[best])
+                {
+                    best = a;
+                }
+            }
+            return best;
+        }
+
+        void
+        HandoverEngine::Handover (uint32_t station, uint32_t toAp)
+        {
+            uint32_t fromAp = m_servingAp[station];
+            m_servingAp[station] = toAp;
+            m_holdUntil[station] = (ns3::Simulator::Now () + m_holdOff).GetTimeStep ();
+            NS_LOG_DEBUG ("Node " << m_nodeId[station] << ": AP " << fromAp << " -> " << toAp);
+            if (m_onHandover)
+            {
+                m_onHandover (station, fromAp, toAp);
+            }
+        }
+
+        void
+        HandoverEngine::Tick (void)
+        {
+            const std::size_t stations = m_nodeId.size ();
+            if (m_monitor)
+            {
+                for (uint32_t s = 0; s < stations; ++s)
+                {
+                    float *row = m_rssi.data () + std::size_t (s) * m_apStride;
+                    for (uint32_t a = 0; a < GetApCount (); ++a)
+                    {
+                        row[a] = m_monitor->GetRssi (s, a);
+                    }
+                }
+            }
+            else
+            {
+                for (std::size_t s = 0; s < stations; ++s)
+                {
+                    ns3::Vector position = m_mobility[s]->GetPosition ();
+                    m_x[s] = static_cast<float> (position.x);
+                    m_y[s] = static_cast<float> (position.y);
+                }
+                ComputeRssi (m_x.data (), m_y.data (), stations, m_apX.data (), m_apY.data (), m_apStride,
+                             static_cast<float> (m_txPowerDbm), static_cast<float> (m_pathLossExponent), m_rssi.data ());
+            }
+            m_checks += stations * GetApCount ();
+
+            const int64_t now = ns3::Simulator::Now ().GetTimeStep ();
+            const auto margin = static_cast<float> (m_marginDb);
+            for (uint32_t s = 0; s < stations; ++s)
+            {
+                if (now < m_holdUntil[s])
+                {
+                    continue;
+                }
+                const float *row = GetRssi (s);
+                uint32_t best = StrongestAp (s);
+                if (row[best] > row[m_servingAp[s]] + margin)
+                {
+                    Handover (s, best);
+                }
+            }
+        }
+
+        void
+        HandoverEngine::StartEventDriven (ns3::Time stopTime)
+        {
+            m_stopTime = stopTime;
+            for (uint32_t s = 0; s < GetStationCount (); ++s)
+            {
+                // Prediction assumes the velocity only changes with a CourseChange notification.
+                ns3::Ptr<ns3::MobilityModel> mobility = m_mobility[s];
+                NS_ABORT_MSG_UNLESS (ns3::DynamicCast<ns3::ConstantVelocityMobilityModel> (mobility) ||
+                                     ns3::DynamicCast<ns3::WaypointMobilityModel> (mobility) ||
+                                     ns3::DynamicCast<ns3::ConstantPositionMobilityModel> (mobility),
+                                     "Event-driven handover needs ConstantVelocity, Waypoint or ConstantPosition "
+                                     "mobility (node " << m_nodeId[s] << ")");
+                mobility->TraceConnectWithoutContext (
+                        "CourseChange", ns3::MakeCallback (&HandoverEngine::OnCourseChange, this).Bind (s));
+                Predict (s);
+            }
+        }
+
+        void
+        HandoverEngine::Predict (uint32_t station)
+        {
+            m_pending[station].Cancel ();
+            ns3::Time now = ns3::Simulator::Now ();
+            if (now.GetTimeStep () < m_holdUntil[station])
+            {
+                // Look again once the hold-off ends.
+                m_pending[station] = ns3::Simulator::Schedule (ns3::TimeStep (m_holdUntil[station]) - now,
+                                                               &HandoverEngine::Predict, this, station);
+                return;
+            }
+
+            // The handover condition "some AP beats the serving one by the margin" first holds at the
+            // earliest crossing against any single candidate.
+            ns3::Vector position = m_mobility[station]->GetPosition ();
+            ns3::Vector velocity = m_mobility[station]->GetVelocity ();
+            const ns3::Vector &serving = m_apPositions[m_servingAp[station]];
+            double earliest = std::numeric_limits<double>::infinity ();
+            for (uint32_t a = 0; a < GetApCount (); ++a)
+            {
+                if (a != m_servingAp[station])
+                {
+                    earliest = std::min (earliest, m_predictor.Predict (position, velocity, serving, m_apPositions[a]));
+                }
+            }
+            m_checks += GetApCount ();
+            if ((now + ns3::Seconds (std::min (earliest, m_stopTime.GetSeconds ()))) >= m_stopTime)
+            {
+                return;  // not on this course before the end (earliest may be infinite)
+            }
+            // The prediction is the instant both sides are equal; the margin is exceeded one tick later.
+            m_pending[station] = ns3::Simulator::Schedule (ns3::Seconds (earliest) + ns3::NanoSeconds (1),
+                                                           &HandoverEngine::OnPredictedHandover, this, station);
+        }
+
+        void
+        HandoverEngine::OnPredictedHandover (uint32_t station)
+        {
+            ns3::Vector position = m_mobility[station]->GetPosition ();
+            const ns3::Vector &serving = m_apPositions[m_servingAp[station]];
+            uint32_t best = m_servingAp[station];
+            double bestDistance = 0.0;
+            for (uint32_t a = 0; a < GetApCount (); ++a)
+            {
+                if (a == m_servingAp[station] || !m_predictor.ShouldHandover (position, serving, m_apPositions[a]))
+                {
+                    continue;
+                }
+                double dx = position.x - m_apPositions[a].x;
+                double dy = position.y - m_apPositions[a].y;
+                double distance = dx * dx + dy * dy;
+                if (best == m_servingAp[station] || distance < bestDistance)
+                {
+                    best = a;
+                    bestDistance = distance;
+                }
+            }
+            if (best != m_servingAp[station])
+            {
+                Handover (station, best);
+                Predict (station);  // waits out the hold-off
+                return;
+            }
+            // Rounding put the event just short of the boundary; look again shortly after.
+            m_pending[station] = ns3::Simulator::Schedule (ns3::MilliSeconds (1), &HandoverEngine::Predict, this, station);
+        }
+
+        void
+        HandoverEngine::OnCourseChange (uint32_t station, ns3::Ptr<const ns3::MobilityModel>)
+        {
+            Predict (station);
+        }
+
+    }
+}
@@ -0,0 +1,157 @@
+#include "monadcount_sim/wifi/HandoverPredictor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        namespace {
+            const double kNever = std::numeric_limits<double>::infinity ();
+
+            // a t^2 + b t + c
+            struct Quadratic
+            {
+                double a, b, c;
+
+                double operator() (double t) const { return (a * t + b) * t + c; }
+            };
+
+            // Squared horizontal distance to a point while moving: |p + v t - ap|^2.
+            Quadratic
+            SquaredDistance (const ns3::Vector &p, const ns3::Vector &v, const ns3::Vector &ap)
+            {
+                double dx = p.x - ap.x;
+                double dy = p.y - ap.y;
+                return {v.x * v.x + v.y * v.y, 2.0 * (v.x * dx + v.y * dy), dx * dx + dy * dy};
+            }
+
+            // Real roots, ascending; returns how many.
+            int
+            Roots (const Quadratic &q, double &r1, double &r2)
+            {
+                if (q.a == 0.0)
+                {
+                    if (q.b == 0.0)
+                    {
+                        return 0;
+                    }
+                    r1 = r2 = -q.c / q.b;
+                    return 1;
+                }
+                double disc = q.b * q.b - 4.0 * q.a * q.c;
+                if (disc < 0.0)
+                {
+                    return 0;
+                }
+                // Numerically stable form: no cancellation between -b and sqrt(disc).
+                double s = std::sqrt (disc);
+                double k = -0.5 * (q.b + (q.b >= 0.0 ? s : -s));
+                r1 = k / q.a;
+                r2 = k != 0.0 ? q.c / k : r1;
+                if (r1 > r2)
+                {
+                    std::swap (r1, r2);
+                }
+                return 2;
+            }
+
+            // Earliest t in [lo, hi) with q(t) >= 0 and q > 0 right after, given q(lo) <= 0.
+            double
+            FirstPositive (const Quadratic &q, double lo, double hi)
+            {
+                double r1, r2;
+                int n = Roots (q, r1, r2);
+                double best = kNever;
+                for (int i = 0; i < n; ++i)
+                {
+                    double r = i == 0 ? r1 : r2;
+                    if (r < lo || r >= hi)
+                    {
+                        continue;
+                    }
+                    // Rising through zero: q just after the root is positive.
+                    double slope = 2.0 * q.a * r + q.b;
+                    if (slope > 0.0 || (slope == 0.0 && q.a > 0.0))
+                    {
+                        best = std::min (best, r);
+                    }
+                }
+                return best;
+            }
+        }
+
+        HandoverPredictor::HandoverPredictor (double marginDb, double pathLossExponent)
+            : m_distanceRatioSquared (std::pow (10.0, marginDb / (5.0 * pathLossExponent)))
+        {
+        }
+
+        bool
+        HandoverPredictor::ShouldHandover (const ns3::Vector &position,
+                                           const ns3::Vector &servingAp, const ns3::Vector &candidateAp) const
+        {
+            ns3::Vector still (0.0, 0.0, 0.0);
+            double serving = std::max (SquaredDistance (position, still, servingAp).c, 1.0);
+            double candidate = std::max (SquaredDistance (position, still, candidateAp).c, 1.0);
+            return serving > m_distanceRatioSquared * candidate;
+        }
+
+        double
+        HandoverPredictor::Predict (const ns3::Vector &position, const ns3::Vector &velocity,
+                                    const ns3::Vector &servingAp, const ns3::Vector &candidateAp) const
+        {
+            // rssiCandidate - rssiServing > margin  <=>  max(ds, 1)^2 - K * max(dc, 1)^2 > 0, K = 10^(margin / 5n).
+            // Inside 1 m of an AP its distance term is the constant 1, so time splits into intervals at the
+            // instants a distance crosses 1 m, and within each interval the condition is a fixed quadratic.
+            const Quadratic serving = SquaredDistance (position, velocity, servingAp);
+            const Quadratic candidate = SquaredDistance (position, velocity, candidateAp);
+
+            std::array<double, 6> breaks{0.0};
+            std::size_t breakCount = 1;
+            for (const Quadratic &d : {serving, candidate})
+            {
+                double r1, r2;
+                int n = Roots ({d.a, d.b, d.c - 1.0}, r1, r2);
+                for (int i = 0; i < n; ++i)
+                {
+                    double r = i == 0 ? r1 : r2;
+                    if (r > 0.0)
+                    {
+                        breaks[breakCount++] = r;
+                    }
+                }
+            }
+            std::sort (breaks.begin (), breaks.begin () + breakCount);
+            breaks[breakCount++] = kNever;
+
+            for (std::size_t i = 0; i + 1 < breakCount; ++i)
+            {
+                double lo = breaks[i];
+                double hi = breaks[i + 1];
+                if (hi <= lo)
+                {
+                    continue;
+                }
+                double mid = std::isinf (hi) ? lo + 1.0 : 0.5 * (lo + hi);
+                Quadratic ds = serving (mid) >= 1.0 ? serving : Quadratic{0.0, 0.0, 1.0};
+                Quadratic dc = candidate (mid) >= 1.0 ? candidate : Quadratic{0.0, 0.0, 1.0};
+                Quadratic condition{ds.a - m_distanceRatioSquared * dc.a,
+                                    ds.b - m_distanceRatioSquared * dc.b,
+                                    ds.c - m_distanceRatioSquared * dc.c};
+                if (condition (lo) > 0.0)
+                {
+                    return lo;
+                }
+                double t = FirstPositive (condition, lo, hi);
+                if (!std::isinf (t))
+                {
+                    return t;
+                }
+            }
+            return kNever;
+        }
+
+    }
+}
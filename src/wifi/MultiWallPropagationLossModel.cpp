@@ -0,0 +1,99 @@
+#include "monadcount_sim/wifi/MultiWallPropagationLossModel.hpp"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        NS_LOG_COMPONENT_DEFINE ("MultiWallPropagationLossModel");
+        NS_OBJECT_ENSURE_REGISTERED (MultiWallPropagationLossModel);
+
+        ns3::TypeId
+        MultiWallPropagationLossModel::GetTypeId (void)
+        {
+            static ns3::TypeId tid = ns3::TypeId ("monadcount_sim::wifi::MultiWallPropagationLossModel")
+                    .SetParent<ns3::PropagationLossModel> ()
+                    .SetGroupName ("MonadCountSim")
+                    .AddConstructor<MultiWallPropagationLossModel> ()
+                    .AddAttribute ("WallAttenuation",
+                                   "Attenuation (dB) of every wall on the direct path.",
+                                   ns3::DoubleValue (5.0),
+                                   ns3::MakeDoubleAccessor (&MultiWallPropagationLossModel::SetWallAttenuation,
+                                                            &MultiWallPropagationLossModel::GetWallAttenuation),
+                                   ns3::MakeDoubleChecker<double> (0.0))
+                    .AddAttribute ("TableAttenuation",
+                                   "Attenuation (dB) of every table on the direct path.",
+                                   ns3::DoubleValue (1.5),
+                                   ns3::MakeDoubleAccessor (&MultiWallPropagationLossModel::SetTableAttenuation,
+                                                            &MultiWallPropagationLossModel::GetTableAttenuation),
+                                   ns3::MakeDoubleChecker<double> (0.0));
+            return tid;
+        }
+
+        MultiWallPropagationLossModel::MultiWallPropagationLossModel ()
+        {
+            NS_LOG_FUNCTION (this);
+        }
+
+        MultiWallPropagationLossModel::~MultiWallPropagationLossModel ()
+        {
+            NS_LOG_FUNCTION (this);
+        }
+
+        void
+        MultiWallPropagationLossModel::SetObstacles (const core::ObstacleIndex &obstacles)
+        {
+            NS_LOG_FUNCTION (this << obstacles.GetSegmentCount ());
+            double wall = GetWallAttenuation ();
+            double table = GetTableAttenuation ();
+            m_obstacles = obstacles;
+            SetWallAttenuation (wall);
+            SetTableAttenuation (table);
+        }
+
+        void
+        MultiWallPropagationLossModel::SetWallAttenuation (double attenuationDb)
+        {
+            m_obstacles.SetAttenuation (core::Material::WALL, attenuationDb);
+        }
+
+        double
+        MultiWallPropagationLossModel::GetWallAttenuation (void) const
+        {
+            return m_obstacles.GetAttenuation (core::Material::WALL);
+        }
+
+        void
+        MultiWallPropagationLossModel::SetTableAttenuation (double attenuationDb)
+        {
+            m_obstacles.SetAttenuation (core::Material::TABLE, attenuationDb);
+        }
+
+        double
+        MultiWallPropagationLossModel::GetTableAttenuation (void) const
+        {
+            return m_obstacles.GetAttenuation (core::Material::TABLE);
+        }
+
+        double
+        MultiWallPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                                      ns3::Ptr<ns3::MobilityModel> a,
+                                                      ns3::Ptr<ns3::MobilityModel> b) const
+        {
+            // Obstacles are floor-plan outlines, so the test is done in the horizontal plane.
+            ns3::Vector pa = a->GetPosition ();
+            ns3::Vector pb = b->GetPosition ();
+            core::WallCrossings crossings = m_obstacles.Query (pa.x, pa.y, pb.x, pb.y);
+            NS_LOG_LOGIC ("crossings=" << crossings.count << " loss=" << crossings.attenuationDb << "dB");
+            return txPowerDbm - crossings.attenuationDb;
+        }
+
+        int64_t
+        MultiWallPropagationLossModel::DoAssignStreams (int64_t)
+        {
+            // Deterministic: no random variables to assign streams to.
+            return 0;
+        }
+
+    }
+}
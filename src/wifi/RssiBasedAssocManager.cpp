@@ -2,6 +2,9 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/mac48-address.h"
+#include "ns3/nstime.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/uinteger.h"
 
 namespace monadcount_sim {
     namespace wifi {
@@ -14,11 +17,37 @@ namespace monadcount_sim {
         {
             static ns3::TypeId tid = ns3::TypeId ("monadcount_sim::wifi::RssiBasedAssocManager")
                     .SetParent<ns3::WifiAssocManager> ()
-                    .SetGroupName ("MonadCountSim");
+                    .SetGroupName ("MonadCountSim")
+                    .AddConstructor<RssiBasedAssocManager> ()
+                    .AddAttribute ("CandidateLifetime",
+                                   "How long a received beacon keeps its AP usable as a handover target without a scan.",
+                                   ns3::TimeValue (ns3::MilliSeconds (500)),
+                                   ns3::MakeTimeAccessor (&RssiBasedAssocManager::m_candidateLifetime),
+                                   ns3::MakeTimeChecker ())
+                    .AddAttribute ("ReassociationTimeout",
+                                   "How long after the scan (or the cached shortcut) the association with the target may "
+                                   "take before the handover is given up; covers the MAC's association request retries.",
+                                   ns3::TimeValue (ns3::Seconds (2)),
+                                   ns3::MakeTimeAccessor (&RssiBasedAssocManager::m_reassociationTimeout),
+                                   ns3::MakeTimeChecker ())
+                    .AddTraceSource ("Reassociated",
+                                     "A handover completed: target BSSID, time since TriggerHandover, whether the scan was skipped.",
+                                     ns3::MakeTraceSourceAccessor (&RssiBasedAssocManager::m_reassociatedTrace),
+                                     "monadcount_sim::wifi::RssiBasedAssocManager::ReassociatedCallback")
+                    .AddTraceSource ("ScansAvoided",
+                                     "Number of handovers served from the candidate cache instead of a scan.",
+                                     ns3::MakeTraceSourceAccessor (&RssiBasedAssocManager::m_scansAvoided),
+                                     "ns3::TracedValueCallback::Uint32");
             return tid;
         }
 
         RssiBasedAssocManager::RssiBasedAssocManager ()
+            : m_candidateLifetime (ns3::MilliSeconds (500)),
+              m_reassociationTimeout (ns3::Seconds (2)),
+              m_fromCache (false),
+              m_insertingCached (false),
+              m_assocConnected (false),
+              m_scansAvoided (0)
         {
             NS_LOG_FUNCTION (this);
         }
@@ -32,13 +61,209 @@ namespace monadcount_sim {
         RssiBasedAssocManager::DoDispose (void)
         {
             NS_LOG_FUNCTION (this);
+            m_scanEvent.Cancel ();
+            m_probeEvent.Cancel ();
+            m_assocTimeoutEvent.Cancel ();
+            m_candidates.clear ();
             ns3::WifiAssocManager::DoDispose ();
         }
 
+        bool
+        RssiBasedAssocManager::TriggerHandover (ns3::Mac48Address targetBssid)
+        {
+            NS_LOG_FUNCTION (this << targetBssid);
+            NS_ASSERT_MSG (m_mac, "The manager must be installed on a StaWifiMac first");
+
+            if (!m_mac->IsAssociated ())
+            {
+                NS_LOG_DEBUG ("STA " << m_mac->GetAddress () << " not associated; handover to " << targetBssid << " ignored");
+                return false;
+            }
+            if (m_mac->GetBssid (0) == targetBssid)
+            {
+                return false;
+            }
+            if (!m_assocConnected)
+            {
+                m_mac->TraceConnectWithoutContext ("Assoc", ns3::MakeCallback (&RssiBasedAssocManager::NotifyAssociated, this));
+                m_assocConnected = true;
+            }
+
+            m_assocTimeoutEvent.Cancel ();
+            m_target = targetBssid;
+            m_handoverStart = ns3::Simulator::Now ();
+            m_fromCache = false;
+            // Same effect on the STA as a deauthentication from its AP: the link is dropped and
+            // StartScanning () is called on this manager, which picks the target.
+            m_mac->Disassociated ();
+            return true;
+        }
+
+        bool
+        RssiBasedAssocManager::HasFreshCandidate (ns3::Mac48Address bssid) const
+        {
+            return FindCandidate (bssid) != nullptr;
+        }
+
+        const RssiBasedAssocManager::Candidate *
+        RssiBasedAssocManager::FindCandidate (ns3::Mac48Address bssid) const
+        {
+            for (const Candidate &candidate : m_candidates)
+            {
+                if (candidate.apInfo.m_bssid == bssid)
+                {
+                    bool fresh = ns3::Simulator::Now () - candidate.lastSeen <= m_candidateLifetime;
+                    return fresh ? &candidate : nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        void
+        RssiBasedAssocManager::NotifyChannelSwitched (void)
+        {
+            NS_LOG_FUNCTION (this);
+            // Beacons heard on the previous channel say nothing about the new one.
+            m_candidates.clear ();
+        }
+
+        void
+        RssiBasedAssocManager::DoStartScanning (void)
+        {
+            NS_LOG_FUNCTION (this);
+            m_scanEvent.Cancel ();
+            m_probeEvent.Cancel ();
+
+            if (m_target && FindCandidate (*m_target))
+            {
+                // Scheduled rather than called: we are still inside StaWifiMac::StartScanning ().
+                m_fromCache = true;
+                ++m_scansAvoided;
+                m_scanEvent = ns3::Simulator::ScheduleNow (&RssiBasedAssocManager::AssociateFromCache, this);
+                return;
+            }
+
+            const ns3::WifiScanParams &params = GetScanParams ();
+            ns3::Time wait = params.maxChannelTime;
+            if (params.type == ns3::WifiScanParams::ACTIVE)
+            {
+                m_probeEvent = ns3::Simulator::Schedule (params.probeDelay, &ns3::StaWifiMac::SendProbeRequest, m_mac, 0);
+                wait += params.probeDelay;
+            }
+            m_scanEvent = ns3::Simulator::Schedule (wait, &RssiBasedAssocManager::EndScanning, this);
+        }
+
+        void
+        RssiBasedAssocManager::AssociateFromCache (void)
+        {
+            NS_LOG_FUNCTION (this);
+            const Candidate *candidate = FindCandidate (*m_target);
+            if (candidate)
+            {
+                NS_LOG_DEBUG ("STA " << m_mac->GetAddress () << " reassociating with cached AP " << *m_target);
+                m_insertingCached = true;
+                NotifyApInfo (ns3::StaWifiMac::ApInfo (candidate->apInfo));
+                m_insertingCached = false;
+            }
+            ScanningTimeout ();
+            StartReassociationTimeout ();
+        }
+
+        void
+        RssiBasedAssocManager::EndScanning (void)
+        {
+            NS_LOG_FUNCTION (this);
+            if (m_target && !IsScanned (*m_target))
+            {
+                // The target did not answer; the STA associates with the best AP it did hear, or scans again.
+                NS_LOG_DEBUG ("Target " << *m_target << " not found by the scan");
+                m_target.reset ();
+            }
+            // Only moves the STA on to WAIT_ASSOC_RESP: the target stays set until the association response
+            // (NotifyAssociated) or the reassociation timeout.
+            ScanningTimeout ();
+            StartReassociationTimeout ();
+        }
+
+        bool
+        RssiBasedAssocManager::IsScanned (ns3::Mac48Address bssid) const
+        {
+            for (const ns3::StaWifiMac::ApInfo &apInfo : GetSortedList ())
+            {
+                if (apInfo.m_bssid == bssid)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void
+        RssiBasedAssocManager::StartReassociationTimeout (void)
+        {
+            m_assocTimeoutEvent.Cancel ();
+            if (m_target)
+            {
+                m_assocTimeoutEvent = ns3::Simulator::Schedule (m_reassociationTimeout,
+                                                                &RssiBasedAssocManager::ReassociationTimeout, this);
+            }
+        }
+
+        void
+        RssiBasedAssocManager::ReassociationTimeout (void)
+        {
+            NS_LOG_FUNCTION (this);
+            if (m_target && !m_mac->IsAssociated ())
+            {
+                // Refused or unanswered; a later association is the MAC's own, not this handover.
+                NS_LOG_DEBUG ("STA " << m_mac->GetAddress () << " gave up the handover to " << *m_target << " after "
+                              << (ns3::Simulator::Now () - m_handoverStart).As (ns3::Time::MS));
+                m_target.reset ();
+            }
+        }
+
+        bool
+        RssiBasedAssocManager::CanBeInserted (const ns3::StaWifiMac::ApInfo &apInfo) const
+        {
+            // Every beacon/probe response reaching the STA passes here, scanning or not.
+            bool found = false;
+            for (Candidate &candidate : m_candidates)
+            {
+                if (candidate.apInfo.m_bssid == apInfo.m_bssid)
+                {
+                    candidate.apInfo = apInfo;
+                    candidate.lastSeen = ns3::Simulator::Now ();
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                m_candidates.push_back (Candidate{apInfo, ns3::Simulator::Now ()});
+            }
+            return m_scanEvent.IsPending () || m_insertingCached;
+        }
+
+        bool
+        RssiBasedAssocManager::CanBeReturned (const ns3::StaWifiMac::ApInfo &apInfo) const
+        {
+            return !m_target || apInfo.m_bssid == *m_target;
+        }
+
         void
-        RssiBasedAssocManager::TriggerHandover (ns3::Ptr<ns3::StaWifiMac> staMac, uint32_t targetApId)
+        RssiBasedAssocManager::NotifyAssociated (ns3::Mac48Address bssid)
         {
-            return;
+            NS_LOG_FUNCTION (this << bssid);
+            if (!m_target)
+            {
+                return;
+            }
+            ns3::Time elapsed = ns3::Simulator::Now () - m_handoverStart;
+            NS_LOG_DEBUG ("STA " << m_mac->GetAddress () << " reassociated with " << bssid << " after "
+                          << elapsed.As (ns3::Time::MS) << (m_fromCache ? " (cached)" : " (scanned)"));
+            m_reassociatedTrace (bssid, elapsed, m_fromCache);
+            m_target.reset ();
+            m_assocTimeoutEvent.Cancel ();
         }
 
     }
@@ -0,0 +1,176 @@
+#include "monadcount_sim/wifi/RssiMonitor.hpp"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-net-device.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        NS_LOG_COMPONENT_DEFINE ("RssiMonitor");
+
+        namespace {
+            // A dense offset table is used while it stays within this many slots per AP.
+            constexpr uint64_t kMaxSlotsPerAp = 4;
+
+            // 802.11 MAC header up to and including addr2.
+            constexpr uint32_t kHeaderBytes = 16;
+
+            uint64_t
+            ToInteger (const uint8_t *bytes)
+            {
+                uint64_t value = 0;
+                for (int i = 0; i < 6; ++i)
+                {
+                    value = (value << 8) | bytes[i];
+                }
+                return value;
+            }
+
+            uint64_t
+            ToInteger (ns3::Mac48Address address)
+            {
+                uint8_t bytes[6];
+                address.CopyTo (bytes);
+                return ToInteger (bytes);
+            }
+        }
+
+        RssiMonitor::RssiMonitor (double alpha, ns3::Time maxAge)
+            : m_alpha (static_cast<float> (alpha)),
+              m_maxAge (maxAge.GetTimeStep ())
+        {
+            NS_ABORT_MSG_IF (alpha <= 0.0 || alpha > 1.0, "RssiMonitor: alpha must be in (0, 1]");
+        }
+
+        void
+        RssiMonitor::AddAps (const ns3::NetDeviceContainer &apDevices)
+        {
+            NS_ABORT_MSG_IF (m_stationCount > 0, "RssiMonitor: add APs before stations");
+            for (uint32_t i = 0; i < apDevices.GetN (); ++i)
+            {
+                m_sortedAddresses.push_back (ToInteger (ns3::Mac48Address::ConvertFrom (apDevices.Get (i)->GetAddress ())));
+            }
+            m_apCount = static_cast<uint32_t> (m_sortedAddresses.size ());
+
+            m_sortedAps.resize (m_apCount);
+            std::iota (m_sortedAps.begin (), m_sortedAps.end (), 0u);
+            std::sort (m_sortedAps.begin (), m_sortedAps.end (), [this] (uint32_t a, uint32_t b) {
+                return m_sortedAddresses[a] < m_sortedAddresses[b];
+            });
+            std::vector<uint64_t> addresses (m_apCount);
+            for (uint32_t i = 0; i < m_apCount; ++i)
+            {
+                addresses[i] = m_sortedAddresses[m_sortedAps[i]];
+            }
+            m_sortedAddresses = std::move (addresses);
+
+            m_apByOffset.clear ();
+            if (m_apCount > 0)
+            {
+                uint64_t span = m_sortedAddresses.back () - m_sortedAddresses.front () + 1;
+                if (span <= kMaxSlotsPerAp * m_apCount)
+                {
+                    m_firstAddress = m_sortedAddresses.front ();
+                    m_apByOffset.assign (span, kNotAp);
+                    for (uint32_t i = 0; i < m_apCount; ++i)
+                    {
+                        m_apByOffset[m_sortedAddresses[i] - m_firstAddress] = m_sortedAps[i];
+                    }
+                }
+            }
+            NS_LOG_INFO (m_apCount << " APs, " << (m_apByOffset.empty () ? "sorted" : "dense") << " address lookup");
+        }
+
+        uint32_t
+        RssiMonitor::AddStations (const ns3::NetDeviceContainer &staDevices)
+        {
+            uint32_t first = m_stationCount;
+            m_stationCount += staDevices.GetN ();
+            m_entries.resize (std::size_t (m_stationCount) * m_apCount);
+
+            for (uint32_t i = 0; i < staDevices.GetN (); ++i)
+            {
+                ns3::Ptr<ns3::WifiNetDevice> device = ns3::DynamicCast<ns3::WifiNetDevice> (staDevices.Get (i));
+                NS_ABORT_MSG_IF (!device, "RssiMonitor: stations must be WifiNetDevices");
+                device->GetPhy ()->TraceConnectWithoutContext (
+                        "MonitorSnifferRx", ns3::MakeCallback (&RssiMonitor::OnMonitorRx, this).Bind (first + i));
+            }
+            return first;
+        }
+
+        float
+        RssiMonitor::GetRssi (uint32_t station, uint32_t ap) const
+        {
+            const Entry &entry = m_entries[std::size_t (station) * m_apCount + ap];
+            if (ns3::Simulator::Now ().GetTimeStep () - entry.lastSample > m_maxAge)
+            {
+                return kNoSample;
+            }
+            return entry.rssi;
+        }
+
+        uint32_t
+        RssiMonitor::FindAp (uint64_t address) const
+        {
+            if (!m_apByOffset.empty ())
+            {
+                uint64_t offset = address - m_firstAddress;  // wraps for addresses below the first
+                return offset < m_apByOffset.size () ? m_apByOffset[offset] : kNotAp;
+            }
+            auto it = std::lower_bound (m_sortedAddresses.begin (), m_sortedAddresses.end (), address);
+            if (it == m_sortedAddresses.end () || *it != address)
+            {
+                return kNotAp;
+            }
+            return m_sortedAps[it - m_sortedAddresses.begin ()];
+        }
+
+        void
+        RssiMonitor::Update (uint32_t station, uint64_t transmitter, double signalDbm)
+        {
+            uint32_t ap = FindAp (transmitter);
+            if (ap == kNotAp)
+            {
+                return;
+            }
+            Entry &entry = m_entries[std::size_t (station) * m_apCount + ap];
+            const int64_t now = ns3::Simulator::Now ().GetTimeStep ();
+            const auto sample = static_cast<float> (signalDbm);
+            // A stale average says nothing about the current position; restart from the sample.
+            if (entry.rssi == kNoSample || now - entry.lastSample > m_maxAge)
+            {
+                entry.rssi = sample;
+            }
+            else
+            {
+                entry.rssi += m_alpha * (sample - entry.rssi);
+            }
+            entry.lastSample = now;
+            ++m_samples;
+        }
+
+        void
+        RssiMonitor::OnMonitorRx (uint32_t station, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                                  ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, ns3::SignalNoiseDbm signalNoise,
+                                  uint16_t staId)
+        {
+            // Only the frame control and addr2 are needed; deserializing a WifiMacHeader would cost more.
+            uint8_t header[kHeaderBytes];
+            if (packet->CopyData (header, kHeaderBytes) < kHeaderBytes)
+            {
+                return;
+            }
+            // Control frames (type 1) carry no usable transmitter address.
+            if (((header[0] >> 2) & 0x3) == 1)
+            {
+                return;
+            }
+            Update (station, ToInteger (header + 10), signalNoise.signal);
+        }
+
+    }
+}
@@ -0,0 +1,194 @@
+#include "monadcount_sim/wifi/WifiCaptureSink.hpp"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-net-device.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        NS_LOG_COMPONENT_DEFINE ("WifiCaptureSink");
+
+        namespace {
+            constexpr uint16_t kLinkTypeRadiotap = 127;  // LINKTYPE_IEEE802_11_RADIOTAP
+
+            // Radiotap fields, in the order they appear: Flags, Channel, then dBm signal and noise (received
+            // frames only). Channel is 2-byte aligned, hence the pad byte after Flags.
+            constexpr uint32_t kPresentFlags = 1u << 1;
+            constexpr uint32_t kPresentChannel = 1u << 3;
+            constexpr uint32_t kPresentSignal = 1u << 5;
+            constexpr uint32_t kPresentNoise = 1u << 6;
+            constexpr uint16_t kTxRadiotapLength = 14;
+            constexpr uint16_t kRxRadiotapLength = 16;
+
+            constexpr uint8_t kFlagFcsIncluded = 0x10;  // ns-3 frames end with the FCS
+            constexpr uint16_t kChannelOfdm = 0x0040;
+            constexpr uint16_t kChannel2GHz = 0x0080;
+            constexpr uint16_t kChannel5GHz = 0x0100;
+
+            int8_t
+            ToDbm (double value)
+            {
+                return static_cast<int8_t> (std::lround (std::min (127.0, std::max (-128.0, value))));
+            }
+        }
+
+        bool
+        WifiCaptureFilter::ParseFrameTypes (const std::string &names, uint64_t &frameTypes)
+        {
+            frameTypes = 0;
+            std::size_t start = 0;
+            while (start <= names.size ())
+            {
+                std::size_t end = std::min (names.find (',', start), names.size ());
+                std::string name = names.substr (start, end - start);
+                if (name == "all")
+                {
+                    frameTypes |= kAllFrames;
+                }
+                else if (name == "mgmt")
+                {
+                    frameTypes |= kManagement;
+                }
+                else if (name == "ctrl")
+                {
+                    frameTypes |= kManagement << 16;
+                }
+                else if (name == "data")
+                {
+                    frameTypes |= kManagement << 32;
+                }
+                else if (name == "probe-assoc")
+                {
+                    frameTypes |= kProbeAndAssociation;
+                }
+                else if (name == "beacon")
+                {
+                    frameTypes |= Bit (0, 8);
+                }
+                else
+                {
+                    return false;
+                }
+                start = end + 1;
+            }
+            return true;
+        }
+
+        WifiCaptureSink::WifiCaptureSink (const std::string &path, core::CaptureCompression compression)
+            : m_writer (path, compression)
+        {
+            NS_LOG_FUNCTION (this << path);
+        }
+
+        WifiCaptureFilter
+        WifiCaptureSink::MakeFilter (const core::CaptureOptions &options)
+        {
+            WifiCaptureFilter filter;
+            filter.frameTypes = options.frameTypes;
+            filter.snapLength = options.snapLength;
+            return filter;
+        }
+
+        void
+        WifiCaptureSink::AddDevices (const ns3::NetDeviceContainer &devices, const std::string &prefix,
+                                     const WifiCaptureFilter &filter)
+        {
+            NS_ABORT_MSG_IF (filter.snapLength < kRxRadiotapLength, "WifiCaptureSink: snap length below the radiotap header");
+            for (uint32_t i = 0; i < devices.GetN (); ++i)
+            {
+                ns3::Ptr<ns3::WifiNetDevice> device = ns3::DynamicCast<ns3::WifiNetDevice> (devices.Get (i));
+                NS_ABORT_MSG_IF (!device, "WifiCaptureSink: only WifiNetDevices can be captured");
+                std::string name = prefix + "-" + std::to_string (device->GetNode ()->GetId ()) + "-"
+                                   + std::to_string (device->GetIfIndex ());
+                uint32_t interfaceId = m_writer.AddInterface (kLinkTypeRadiotap, filter.snapLength, name);
+                m_filters.push_back (filter);
+                ns3::Ptr<ns3::WifiPhy> phy = device->GetPhy ();
+                phy->TraceConnectWithoutContext ("MonitorSnifferRx",
+                                                 ns3::MakeCallback (&WifiCaptureSink::OnMonitorRx, this).Bind (interfaceId));
+                phy->TraceConnectWithoutContext ("MonitorSnifferTx",
+                                                 ns3::MakeCallback (&WifiCaptureSink::OnMonitorTx, this).Bind (interfaceId));
+            }
+        }
+
+        bool
+        WifiCaptureSink::Close (void)
+        {
+            NS_LOG_FUNCTION (this);
+            return m_writer.Close ();
+        }
+
+        core::CaptureWriterStats
+        WifiCaptureSink::GetStats (void) const
+        {
+            return m_writer.GetStats ();
+        }
+
+        void
+        WifiCaptureSink::OnMonitorRx (uint32_t interfaceId, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                                      ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, ns3::SignalNoiseDbm signalNoise,
+                                      uint16_t staId)
+        {
+            Write (interfaceId, packet, channelFreqMhz, &signalNoise);
+        }
+
+        void
+        WifiCaptureSink::OnMonitorTx (uint32_t interfaceId, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                                      ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, uint16_t staId)
+        {
+            Write (interfaceId, packet, channelFreqMhz, nullptr);
+        }
+
+        void
+        WifiCaptureSink::Write (uint32_t interfaceId, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                                const ns3::SignalNoiseDbm *signalNoise)
+        {
+            const WifiCaptureFilter &filter = m_filters[interfaceId];
+            if (filter.frameTypes != WifiCaptureFilter::kAllFrames)
+            {
+                // Frame control byte 0: version in bits 0-1, type in bits 2-3, subtype in bits 4-7.
+                uint8_t frameControl;
+                if (packet->CopyData (&frameControl, 1) != 1 ||
+                    !((filter.frameTypes >> (((frameControl >> 2) & 0x3) * 16 + (frameControl >> 4))) & 1))
+                {
+                    ++m_filteredFrames;
+                    return;
+                }
+            }
+
+            const uint16_t radiotapLength = signalNoise ? kRxRadiotapLength : kTxRadiotapLength;
+            const uint32_t frameLength = radiotapLength + packet->GetSize ();
+            const uint32_t capturedLength = std::min (frameLength, filter.snapLength);
+            uint8_t *out = m_writer.AppendPacket (interfaceId, ns3::Simulator::Now ().GetNanoSeconds (),
+                                                  capturedLength, frameLength);
+
+            // Radiotap is little-endian; so is every target ns-3 runs on.
+            uint32_t present = kPresentFlags | kPresentChannel;
+            if (signalNoise)
+            {
+                present |= kPresentSignal | kPresentNoise;
+            }
+            const uint16_t channelFlags = kChannelOfdm | (channelFreqMhz < 4000 ? kChannel2GHz : kChannel5GHz);
+            out[0] = 0;  // version
+            out[1] = 0;
+            std::memcpy (out + 2, &radiotapLength, 2);
+            std::memcpy (out + 4, &present, 4);
+            out[8] = kFlagFcsIncluded;
+            out[9] = 0;
+            std::memcpy (out + 10, &channelFreqMhz, 2);
+            std::memcpy (out + 12, &channelFlags, 2);
+            if (signalNoise)
+            {
+                out[14] = static_cast<uint8_t> (ToDbm (signalNoise->signal));
+                out[15] = static_cast<uint8_t> (ToDbm (signalNoise->noise));
+            }
+            packet->CopyData (out + radiotapLength, capturedLength - radiotapLength);
+        }
+
+    }
+}
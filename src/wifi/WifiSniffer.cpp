@@ -0,0 +1,129 @@
+#include "monadcount_sim/wifi/WifiSniffer.hpp"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-mac-helper.h"
+#include "ns3/wifi-net-device.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace monadcount_sim {
+    namespace wifi {
+
+        NS_LOG_COMPONENT_DEFINE ("WifiSniffer");
+
+        namespace {
+            constexpr uint32_t kHeaderBytes = 16;  // frame control, duration, addr1, addr2
+            constexpr uint32_t kAddressBytes = 6;
+
+            std::vector<core::ArrowColumn>
+            Columns (void)
+            {
+                using Type = core::ArrowColumn::Type;
+                return {{"timestamp", Type::TimestampNs, 8},
+                        {"sniffer", Type::Int, 4, false},
+                        {"transmitter", Type::FixedSizeBinary, kAddressBytes},
+                        {"frame_type", Type::Int, 1, false},
+                        {"rssi", Type::Float, 4},
+                        {"channel", Type::Int, 2, false}};
+            }
+
+            uint16_t
+            ChannelNumber (uint16_t frequencyMhz)
+            {
+                if (frequencyMhz == 2484)
+                {
+                    return 14;
+                }
+                if (frequencyMhz < 2484)
+                {
+                    return static_cast<uint16_t> ((frequencyMhz - 2407) / 5);
+                }
+                if (frequencyMhz >= 5955)
+                {
+                    return static_cast<uint16_t> ((frequencyMhz - 5950) / 5);  // 6 GHz
+                }
+                return static_cast<uint16_t> ((frequencyMhz - 5000) / 5);
+            }
+        }
+
+        WifiSniffer::WifiSniffer (const std::string &path, uint32_t batchRows)
+            : m_writer (path, Columns ()),
+              m_batchRows (std::max<uint32_t> (batchRows, 1)),
+              m_timestamp (m_batchRows),
+              m_sniffer (m_batchRows),
+              m_transmitter (std::size_t (m_batchRows) * kAddressBytes),
+              m_frameType (m_batchRows),
+              m_rssi (m_batchRows),
+              m_channel (m_batchRows)
+        {
+            NS_LOG_FUNCTION (this << path << batchRows);
+        }
+
+        ns3::NetDeviceContainer
+        WifiSniffer::Install (const ns3::WifiHelper &wifi, const ns3::WifiPhyHelper &phy,
+                              const ns3::NodeContainer &nodes)
+        {
+            // An ad-hoc MAC sends nothing unless an application does, so the device only listens.
+            ns3::WifiMacHelper mac;
+            mac.SetType ("ns3::AdhocWifiMac");
+            ns3::NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+            for (uint32_t i = 0; i < devices.GetN (); ++i)
+            {
+                ns3::Ptr<ns3::WifiNetDevice> device = ns3::DynamicCast<ns3::WifiNetDevice> (devices.Get (i));
+                device->GetPhy ()->TraceConnectWithoutContext (
+                        "MonitorSnifferRx", ns3::MakeCallback (&WifiSniffer::OnMonitorRx, this).Bind (i));
+            }
+            NS_LOG_INFO ("Installed " << devices.GetN () << " sniffers");
+            return devices;
+        }
+
+        bool
+        WifiSniffer::Close (void)
+        {
+            NS_LOG_FUNCTION (this);
+            Flush ();
+            return m_writer.Close ();
+        }
+
+        void
+        WifiSniffer::OnMonitorRx (uint32_t sniffer, ns3::Ptr<const ns3::Packet> packet, uint16_t channelFreqMhz,
+                                  ns3::WifiTxVector txVector, ns3::MpduInfo aMpdu, ns3::SignalNoiseDbm signalNoise,
+                                  uint16_t staId)
+        {
+            uint8_t header[kHeaderBytes];
+            if (packet->CopyData (header, kHeaderBytes) < kHeaderBytes)
+            {
+                return;
+            }
+            const uint8_t type = (header[0] >> 2) & 0x3;
+            const uint8_t frameType = static_cast<uint8_t> (16 * type + (header[0] >> 4));
+            if (type == 1 || !((m_frameTypes >> frameType) & 1))
+            {
+                return;
+            }
+
+            const uint32_t row = m_rows;
+            m_timestamp[row] = ns3::Simulator::Now ().GetNanoSeconds ();
+            m_sniffer[row] = sniffer;
+            std::memcpy (&m_transmitter[std::size_t (row) * kAddressBytes], header + 10, kAddressBytes);
+            m_frameType[row] = frameType;
+            m_rssi[row] = static_cast<float> (signalNoise.signal);
+            m_channel[row] = ChannelNumber (channelFreqMhz);
+            if (++m_rows == m_batchRows)
+            {
+                Flush ();
+            }
+        }
+
+        void
+        WifiSniffer::Flush (void)
+        {
+            const void *columns[] = {m_timestamp.data (), m_sniffer.data (), m_transmitter.data (),
+                                     m_frameType.data (), m_rssi.data (), m_channel.data ()};
+            m_writer.WriteBatch (m_rows, columns);
+            m_rows = 0;
+        }
+
+    }
+}